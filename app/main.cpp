@@ -1,16 +1,94 @@
 #include <fmt/base.h>
 #include <spdlog/spdlog.h>
 
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
 #include <optional>
+#include <sstream>
 #include <stdexcept>
+#include <thread>
+#include <unistd.h>
 
 #include "argparse/argparse.hpp"
 #include <jacc/driver.h>
 #include <jacc/first_follow_set_generator.h>
 #include <jacc/grammar.h>
+#include <jacc/grammar_cache.h>
+#include <jacc/grammar_transform.h>
+#include <jacc/lexer_generator.h>
+#include <jacc/ll_parser_emitter.h>
 #include <jacc/ll_table_generator.h>
 #include <jacc/table_driven_ll_parser.h>
 
+namespace
+{
+/**
+ * Reads the grammar file again whenever it changes and brings sets_generator and table up to
+ * date rule by rule, so only what depends on the edited rules is analyzed again. Runs until the
+ * process is killed.
+ */
+[[noreturn]] void watch_grammar(const std::string &filename, bool rewrite,
+                                FirstFollowSetGenerator &sets_generator, LLTable &table)
+{
+    spdlog::info("watching {} for changes", filename);
+    auto modified = std::filesystem::last_write_time(filename);
+    for (;;) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        std::error_code error;
+        const auto last_write = std::filesystem::last_write_time(filename, error);
+        if (error || last_write == modified)
+            continue;
+        modified = last_write;
+        Driver driver;
+        if (driver.parse(filename) != 0 || driver.grammar.get_rules().empty()) {
+            spdlog::error("{} doesn't parse, waiting for the next change", filename);
+            continue;
+        }
+        const Grammar grammar = rewrite ? rewrite_for_ll(driver.grammar) : driver.grammar;
+
+        const auto start = std::chrono::steady_clock::now();
+        // a copy, the rules of the generator change while they are compared
+        const auto old_rules = sets_generator.grammar.get_rules();
+        std::size_t changed_rules = 0;
+        if (grammar.get_rules().front().get_LHS() != old_rules.front().get_LHS()) {
+            // a new start symbol changes every FOLLOW set
+            sets_generator = FirstFollowSetGenerator(grammar);
+            table = generate_dense_ll_table(sets_generator);
+            changed_rules = grammar.get_rules().size();
+        } else {
+            std::map<ProductionSymbol, const GrammarRule *> old_rule_of;
+            for (const auto &rule : old_rules)
+                old_rule_of.emplace(rule.get_LHS(), &rule);
+            for (const auto &rule : grammar.get_rules()) {
+                auto old_rule = old_rule_of.find(rule.get_LHS());
+                if (old_rule != old_rule_of.end()) {
+                    const bool unchanged =
+                        old_rule->second->get_productions() == rule.get_productions();
+                    old_rule_of.erase(old_rule);
+                    if (unchanged)
+                        continue;
+                }
+                patch_ll_table(table, sets_generator, sets_generator.replace_rule(rule));
+                changed_rules++;
+            }
+            for (const auto &[LHS, rule] : old_rule_of) {
+                patch_ll_table(table, sets_generator, sets_generator.remove_rule(LHS));
+                changed_rules++;
+            }
+        }
+        const std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        for (const auto &conflict : table.conflicts)
+            spdlog::warn(table.describe(conflict));
+        spdlog::info("{} rules changed, LL(1) table updated in {:.2f} ms with {} conflicts",
+                     changed_rules, elapsed.count(), table.conflicts.size());
+    }
+}
+} // namespace
+
 int main(int argc, char *argv[])
 {
     argparse::ArgumentParser program(argv[0]);
@@ -19,7 +97,16 @@ int main(int argc, char *argv[])
     program.add_argument("--grammar").default_value(false).implicit_value(true).help("stop after parsing the input grammar");
     program.add_argument("--first").default_value(false).implicit_value(true).help("stop after generating first sets");
     program.add_argument("--follow").default_value(false).implicit_value(true).help("stop after generating follow sets");
+    program.add_argument("--rewrite").default_value(false).implicit_value(true).help("eliminate left recursion and left factor the grammar before building tables");
     program.add_argument("--ll").default_value(false).implicit_value(true).help("stop after generating the LL(1) parse table");
+    program.add_argument("--stats").default_value(false).implicit_value(true).help("stop after reporting conflicts and size of the LL(1) table");
+    program.add_argument("--compress").default_value(false).implicit_value(true).help("use a row displacement LL(1) table with default rows");
+    program.add_argument("--emit").help("write a standalone LL(1) parser for the grammar to this directory").metavar("directory");
+    program.add_argument("--input").help("lex and parse this file with the tokens the grammar defines").metavar("filename");
+    program.add_argument("--recover").default_value(false).implicit_value(true).help("with --input, recover from syntax errors and report all of them");
+    program.add_argument("--cache").help("reuse the compiled grammar in this file, or write it there when it is missing or stale").metavar("filename");
+    program.add_argument("--watch").default_value(false).implicit_value(true).help("keep the LL(1) table up to date while the grammar file is edited, only reanalyzing changed rules");
+    program.add_argument("--name").default_value(std::string{"parser"}).help("name of the emitted parser").metavar("name");
     try{
         program.parse_args(argc, argv);
     }
@@ -37,33 +124,143 @@ int main(int argc, char *argv[])
     auto filename = program.present("-f");
     spdlog::info("filename: {}", filename.has_value() ? *filename : "nullopt");
 
-    Driver driver;
-    driver.parse(filename.value());
-    Grammar grammar = driver.grammar;
-    spdlog::info("grammar: {}", grammar);
-    if (program.is_used("--grammar"))
-        return 0;
+    // a compiled grammar stands in for everything up to the LL(1) table, unless that is what was
+    // asked for. It doesn't keep the conflicts either.
+    const auto cache_path = program.present("--cache");
+    const bool stops_early = program.is_used("--grammar") || program.is_used("--first") ||
+                             program.is_used("--follow") || program.is_used("--ll") ||
+                             program.is_used("--stats");
+    std::optional<std::uint64_t> grammar_hash;
+    std::optional<CompiledGrammar> compiled;
+    // watching always starts from the grammar file
+    if (cache_path && !stops_early && !program.is_used("--watch")) {
+        grammar_hash = hash_grammar_file(filename.value());
+        // the rewritten grammar compiles to different tables than the file as written
+        if (grammar_hash && program.is_used("--rewrite"))
+            grammar_hash = hash_grammar(fmt::format("{:x} rewritten", *grammar_hash));
+        if (grammar_hash)
+            compiled = CompiledGrammar::open(*cache_path, *grammar_hash);
+    }
 
-    FirstFollowSetGenerator sets_generator(grammar);
-    FirstFollowSetGenerator::set_map<ProductionSymbol> first_sets =
-        sets_generator.generate_first_sets();
-    spdlog::info("first sets: {}", first_sets);
-    if (program.is_used("--first"))
-        return 0;
+    // both are views into the compiled grammar when there is one
+    std::shared_ptr<const LLTable> parse_table;
+    std::shared_ptr<const LexerTable> lexer;
+    std::vector<TokenDefinition> token_definitions;
+    // FOLLOW sets by nonterminal index, the synchronizing tokens of --recover
+    std::vector<DenseBitset> sync_sets;
+    if (compiled) {
+        spdlog::info("using compiled grammar {}", *cache_path);
+        parse_table = compiled->ll_table();
+        lexer = compiled->lexer_table();
+        if (program.is_used("--recover"))
+            sync_sets = compiled->to_follow_sets();
+    } else {
+        Driver driver;
+        driver.parse(filename.value());
+        Grammar grammar = driver.grammar;
+        spdlog::info("grammar: {}", grammar);
+        if (program.is_used("--rewrite")) {
+            grammar = rewrite_for_ll(grammar);
+            spdlog::info("rewritten grammar: {}", grammar);
+        }
+        if (program.is_used("--grammar"))
+            return 0;
 
-    FirstFollowSetGenerator::set_map<ProductionSymbol> follow_sets =
-        sets_generator.generate_follow_sets();
-    spdlog::info("follow sets: {}", follow_sets);
-    if (program.is_used("--follow"))
-        return 0;
+        FirstFollowSetGenerator sets_generator(grammar);
+        FirstFollowSetGenerator::set_map<ProductionSymbol> first_sets =
+            sets_generator.generate_first_sets();
+        spdlog::info("first sets: {}", first_sets);
+        if (program.is_used("--first"))
+            return 0;
+
+        FirstFollowSetGenerator::set_map<ProductionSymbol> follow_sets =
+            sets_generator.generate_follow_sets();
+        spdlog::info("follow sets: {}", follow_sets);
+        if (program.is_used("--follow"))
+            return 0;
+
+        auto table = generate_ll_table(grammar, sets_generator);
+        spdlog::info("LL-parsing table:");
+        for (auto thing : table) {
+            spdlog::info(thing);
+        }
+        if (program.is_used("--ll"))
+            return 0;
+
+        auto dense_table = generate_dense_ll_table(sets_generator);
+        for (const auto &conflict : dense_table.conflicts)
+            spdlog::warn(dense_table.describe(conflict));
+        token_definitions = grammar.get_token_definitions();
+        for (auto nonterminal : dense_table.get_symbol_table().get_nonterminals())
+            sync_sets.push_back(sets_generator.get_engine().follow(nonterminal));
+        if (cache_path && grammar_hash) {
+            try {
+                const auto image = serialize_compiled_grammar(
+                    *grammar_hash, grammar, sets_generator.get_engine(), dense_table);
+                // written next to the cache and renamed, so other processes never map half a file
+                const auto temporary = *cache_path + ".tmp" + std::to_string(getpid());
+                std::ofstream(temporary, std::ios::binary) << image;
+                std::filesystem::rename(temporary, *cache_path);
+                spdlog::info("wrote compiled grammar {}", *cache_path);
+            } catch (const std::invalid_argument &e) {
+                spdlog::warn("not writing compiled grammar {}: {}", *cache_path, e.what());
+            }
+        }
+        if (program.is_used("--watch"))
+            watch_grammar(filename.value(), program.is_used("--rewrite"), sets_generator,
+                          dense_table);
+        parse_table = std::make_shared<const LLTable>(std::move(dense_table));
+    }
 
-    auto table = generate_ll_table(grammar, sets_generator);
-    spdlog::info("LL-parsing table:");
-    for (auto thing : table) {
-        spdlog::info(thing);
+    const auto stats = parse_table->compute_stats();
+    spdlog::info("LL(1) table: {} x {}, {} of {} cells filled ({:.1f}%), {} productions, {} "
+                 "conflicts, {} bytes dense, {} bytes compressed, {} bytes with default rows",
+                 stats.rows, stats.columns, stats.filled_cells, stats.rows * stats.columns,
+                 stats.fill_ratio * 100, stats.productions, stats.conflicts, stats.dense_bytes,
+                 stats.compressed_bytes, stats.default_rows_bytes);
+    if (program.is_used("--stats"))
+        return stats.conflicts == 0 ? 0 : 1;
+    if (program.is_used("--compress")) {
+        auto compressed = *parse_table;
+        compressed.compress(LLTable::Encoding::DefaultRows);
+        parse_table = std::make_shared<const LLTable>(std::move(compressed));
     }
-    if (program.is_used("--ll"))
+
+    if (auto directory = program.present("--emit")) {
+        auto emitted = emit_ll_parser(*parse_table, program.get<std::string>("--name"));
+        std::filesystem::create_directories(*directory);
+        for (const auto &[name, contents] : {std::pair{emitted.header_name, emitted.header},
+                                             std::pair{emitted.source_name, emitted.source}}) {
+            auto path = std::filesystem::path(*directory) / name;
+            std::ofstream(path) << contents;
+            spdlog::info("wrote {}", path.string());
+        }
         return 0;
+    }
+
+    if (auto input_file = program.present("--input")) {
+        std::stringstream text;
+        text << std::ifstream(*input_file).rdbuf();
+        const auto input = text.str();
+        if (!lexer)
+            lexer = std::make_shared<const LexerTable>(
+                generate_lexer(token_definitions, parse_table->get_symbol_table()));
+        LLParser parser{parse_table};
+        if (program.is_used("--recover"))
+            parser.set_recovery(LLParser::Recovery::PhraseLevel, std::move(sync_sets));
+        Scanner scanner(*lexer, input);
+        for (Token token; scanner.next(token);)
+            parser.feed(token.symbol);
+        if (scanner.failed()) {
+            spdlog::error("no token matches the input at offset {}", scanner.position());
+            return 1;
+        }
+        const bool accepted = parser.finish();
+        for (const auto &error : parser.get_errors())
+            spdlog::error("syntax error at token {}", parser.describe(error));
+        spdlog::info(accepted ? "Success!" : "Task succeeded with failure");
+        return accepted ? 0 : 1;
+    }
 
     auto input = std::vector<ProductionSymbol>{
         ProductionSymbol("{", ProductionSymbol::Kind::Terminal),
@@ -81,11 +278,12 @@ int main(int argc, char *argv[])
         // ProductionSymbol("id", ProductionSymbol::Kind::Terminal),
     };
     spdlog::info(input);
-    spdlog::info("first thing of grammar: {}", grammar.get_rules().front());
+    const auto &symbols = parse_table->get_symbol_table();
+    spdlog::info("first thing of grammar: {}", symbols.get_symbol(parse_table->get_start_symbol()));
 
 
-    // LLParser parser{table, ProductionSymbol("E", ProductionSymbol::Kind::NonTerminal)};
-    LLParser parser{table, ProductionSymbol("S", ProductionSymbol::Kind::NonTerminal)};
+    // the dense table always starts at the first rule of the grammar
+    LLParser parser{parse_table};
 
     if (parser.parse(input)) {
         spdlog::info("Success!");
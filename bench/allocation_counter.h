@@ -0,0 +1,14 @@
+#ifndef ALLOCATION_COUNTER_H_
+#define ALLOCATION_COUNTER_H_
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Every call to a global operator new in this process, counted by the replacements in
+ * allocation_counter.cpp. They live in a translation unit of their own, so the compiler never
+ * sees a new and the free() of its delete at the same time.
+ */
+extern std::atomic<std::size_t> allocations;
+
+#endif // ALLOCATION_COUNTER_H_
@@ -0,0 +1,439 @@
+#include "allocation_counter.h"
+#include "synthetic_grammar.h"
+
+#include <jacc/driver.h>
+#include <jacc/first_follow_set_generator.h>
+#include <jacc/grammar.h>
+#include <jacc/grammar_cache.h>
+#include <jacc/lalr_table_generator.h>
+#include <jacc/lexer_generator.h>
+#include <jacc/ll_table_generator.h>
+#include <jacc/parse_batch.h>
+#include <jacc/syntax_tree.h>
+#include <jacc/table_driven_ll_parser.h>
+#include <jacc/table_driven_lr_parser.h>
+
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr std::uint32_t grammar_seed = 1;
+constexpr std::uint32_t sentence_seed = 2;
+// size of the grammar the parse benchmarks run on
+constexpr std::size_t parse_grammar_rules = 1000;
+
+void load_grammar_file(benchmark::State &state, const std::string &name)
+{
+    const auto path = std::string{EXAMPLE_GRAMMAR_DIR}.append(name);
+    for (auto _ : state) {
+        Driver driver;
+        driver.parse(path);
+        benchmark::DoNotOptimize(driver.grammar);
+    }
+}
+BENCHMARK_CAPTURE(load_grammar_file, easy, std::string{"easy.bnf"});
+BENCHMARK_CAPTURE(load_grammar_file, energy, std::string{"energy.bnf"});
+BENCHMARK_CAPTURE(load_grammar_file, exp, std::string{"exp.bnf"});
+BENCHMARK_CAPTURE(load_grammar_file, first, std::string{"first.bnf"});
+BENCHMARK_CAPTURE(load_grammar_file, test, std::string{"test.bnf"});
+
+// loading should grow linearly with the size of the file
+void load_generated_grammar(benchmark::State &state)
+{
+    const auto bnf = to_bnf(generate_ll1_grammar(static_cast<std::size_t>(state.range(0)), 1));
+    const auto path = std::filesystem::temp_directory_path() / "jacc_bench_grammar.bnf";
+    std::ofstream(path) << bnf;
+    for (auto _ : state) {
+        Driver driver;
+        driver.parse(path.string());
+        benchmark::DoNotOptimize(driver.grammar);
+    }
+    std::filesystem::remove(path);
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                            static_cast<std::int64_t>(bnf.size()));
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(load_generated_grammar)
+    ->RangeMultiplier(10)
+    ->Range(1000, 100000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity(benchmark::oN);
+
+void first_follow_sets(benchmark::State &state, FirstFollowSetGenerator::Engine engine)
+{
+    const auto grammar =
+        generate_ll1_grammar(static_cast<std::size_t>(state.range(0)), grammar_seed);
+    for (auto _ : state) {
+        FirstFollowSetGenerator sets_generator(grammar, engine);
+        benchmark::DoNotOptimize(sets_generator.generate_first_sets());
+        benchmark::DoNotOptimize(sets_generator.generate_follow_sets());
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK_CAPTURE(first_follow_sets, bitset, FirstFollowSetGenerator::Engine::Bitset)
+    ->RangeMultiplier(10)
+    ->Range(100, 10000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity();
+BENCHMARK_CAPTURE(first_follow_sets, recursive, FirstFollowSetGenerator::Engine::Recursive)
+    ->RangeMultiplier(10)
+    ->Range(100, 1000)
+    ->Unit(benchmark::kMillisecond);
+
+void generate_map_ll_table(benchmark::State &state)
+{
+    auto grammar = generate_ll1_grammar(static_cast<std::size_t>(state.range(0)), grammar_seed);
+    for (auto _ : state) {
+        FirstFollowSetGenerator sets_generator(grammar);
+        benchmark::DoNotOptimize(generate_ll_table(grammar, sets_generator));
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(generate_map_ll_table)
+    ->RangeMultiplier(10)
+    ->Range(100, 10000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity();
+
+void generate_dense_table(benchmark::State &state)
+{
+    const auto grammar =
+        generate_ll1_grammar(static_cast<std::size_t>(state.range(0)), grammar_seed);
+    for (auto _ : state) {
+        FirstFollowSetGenerator sets_generator(grammar);
+        benchmark::DoNotOptimize(generate_dense_ll_table(sets_generator));
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(generate_dense_table)
+    ->RangeMultiplier(10)
+    ->Range(100, 10000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity();
+
+// one rule of the grammar loses an alternative and gets it back, against generate_dense_table
+void incremental_update(benchmark::State &state)
+{
+    const auto grammar =
+        generate_ll1_grammar(static_cast<std::size_t>(state.range(0)), grammar_seed);
+    FirstFollowSetGenerator sets_generator(grammar);
+    auto table = generate_dense_ll_table(sets_generator);
+    const auto &rule = grammar.get_rules()[grammar.get_rules().size() / 2];
+    auto productions = rule.get_productions();
+    productions.pop_back();
+    const GrammarRule shortened{rule.get_LHS(), productions};
+    std::size_t rows = 0;
+    bool original = false;
+    for (auto _ : state) {
+        const auto changes = sets_generator.replace_rule(original ? rule : shortened);
+        patch_ll_table(table, sets_generator, changes);
+        rows += changes.rows.size();
+        original = !original;
+    }
+    state.counters["rows/update"] =
+        static_cast<double>(rows) /
+        static_cast<double>(std::max<benchmark::IterationCount>(1, state.iterations()));
+}
+BENCHMARK(incremental_update)
+    ->RangeMultiplier(10)
+    ->Range(100, 10000)
+    ->Unit(benchmark::kMicrosecond);
+
+void generate_lalr(benchmark::State &state)
+{
+    const auto grammar =
+        generate_ll1_grammar(static_cast<std::size_t>(state.range(0)), grammar_seed);
+    for (auto _ : state) {
+        FirstFollowSetGenerator sets_generator(grammar);
+        benchmark::DoNotOptimize(generate_lalr_table(sets_generator));
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(generate_lalr)
+    ->RangeMultiplier(10)
+    ->Range(100, 10000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity();
+
+// what a process has to do at startup to get its table, with and without a compiled grammar
+void compile_grammar(benchmark::State &state)
+{
+    const auto bnf = to_bnf(generate_ll1_grammar(static_cast<std::size_t>(state.range(0)), 1));
+    const auto path = std::filesystem::temp_directory_path() / "jacc_bench_compile.bnf";
+    std::ofstream(path) << bnf;
+    for (auto _ : state) {
+        Driver driver;
+        driver.parse(path.string());
+        FirstFollowSetGenerator sets_generator(driver.grammar);
+        benchmark::DoNotOptimize(generate_dense_ll_table(sets_generator));
+    }
+    std::filesystem::remove(path);
+}
+BENCHMARK(compile_grammar)->RangeMultiplier(10)->Range(100, 10000)->Unit(benchmark::kMillisecond);
+
+void load_compiled_grammar(benchmark::State &state)
+{
+    const auto bnf = to_bnf(generate_ll1_grammar(static_cast<std::size_t>(state.range(0)), 1));
+    const auto hash = hash_grammar(bnf);
+    const auto path = std::filesystem::temp_directory_path() / "jacc_bench_compiled.jaccc";
+    {
+        const auto grammar = generate_ll1_grammar(static_cast<std::size_t>(state.range(0)), 1);
+        FirstFollowSetGenerator sets_generator(grammar);
+        std::ofstream(path, std::ios::binary) << serialize_compiled_grammar(
+            hash, grammar, sets_generator.get_engine(), generate_dense_ll_table(sets_generator));
+    }
+    for (auto _ : state) {
+        auto compiled = CompiledGrammar::open(path.string(), hash);
+        if (!compiled) {
+            state.SkipWithError("compiled grammar was not accepted");
+        } else {
+            benchmark::DoNotOptimize(compiled->ll_table());
+            benchmark::DoNotOptimize(compiled->lexer_table());
+        }
+    }
+    std::filesystem::remove(path);
+}
+BENCHMARK(load_compiled_grammar)
+    ->RangeMultiplier(10)
+    ->Range(100, 10000)
+    ->Unit(benchmark::kMillisecond);
+
+// allocations since allocations_before, per token parsed in the benchmark loop
+void report_allocations(benchmark::State &state, std::size_t allocations_before,
+                        std::size_t tokens)
+{
+    const auto allocated = allocations.load(std::memory_order_relaxed) - allocations_before;
+    state.counters["allocs/token"] =
+        static_cast<double>(allocated) /
+        static_cast<double>(std::max<std::size_t>(1, state.iterations() * tokens));
+}
+
+void report_tokens(benchmark::State &state, std::size_t tokens)
+{
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                            static_cast<std::int64_t>(tokens));
+    state.counters["tokens"] = static_cast<double>(tokens);
+    state.counters["tokens/s"] = benchmark::Counter(
+        static_cast<double>(tokens), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void ll_parse(benchmark::State &state)
+{
+    const auto grammar = generate_ll1_grammar(parse_grammar_rules, grammar_seed);
+    const auto sentence =
+        generate_sentence(grammar, static_cast<std::size_t>(state.range(0)), sentence_seed);
+    FirstFollowSetGenerator sets_generator(grammar);
+    LLParser parser{generate_dense_ll_table(sets_generator)};
+    for (auto _ : state) {
+        parser.reset();
+        if (!parser.parse(sentence))
+            state.SkipWithError("generated sentence was rejected");
+    }
+    report_tokens(state, sentence.size());
+}
+BENCHMARK(ll_parse)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+
+// spelling to terminal id, as done for every token fed to LLParser
+void terminal_lookup(benchmark::State &state, bool perfect_hash)
+{
+    const auto grammar = generate_ll1_grammar(parse_grammar_rules, grammar_seed);
+    const auto sentence = generate_sentence(grammar, 100000, sentence_seed);
+    FirstFollowSetGenerator sets_generator(grammar);
+    const auto table = generate_dense_ll_table(sets_generator);
+    for (auto _ : state) {
+        for (const auto &token : sentence) {
+            benchmark::DoNotOptimize(perfect_hash
+                                         ? table.find_terminal(*token.get_raw_symbol())
+                                         : table.get_symbol_table().find(token));
+        }
+    }
+    report_tokens(state, sentence.size());
+}
+BENCHMARK_CAPTURE(terminal_lookup, perfect_hash, true)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(terminal_lookup, symbol_table, false)->Unit(benchmark::kMillisecond);
+
+// same as ll_parse, but the tokens are already symbol ids, so this is the parser alone, for each
+// table encoding
+void ll_parse_ids(benchmark::State &state, LLTable::Encoding encoding)
+{
+    const auto grammar = generate_ll1_grammar(parse_grammar_rules, grammar_seed);
+    const auto sentence =
+        generate_sentence(grammar, static_cast<std::size_t>(state.range(0)), sentence_seed);
+    std::vector<SymbolId> ids;
+    ids.reserve(sentence.size());
+    for (const auto &token : sentence)
+        ids.push_back(grammar.get_symbol_table().find(token));
+    FirstFollowSetGenerator sets_generator(grammar);
+    const auto table = generate_dense_ll_table(sets_generator, encoding);
+    LLParser parser{table};
+    // the first parse grows the parse stack, every later one should reuse it
+    parser.parse(ids.begin(), ids.end());
+    const auto allocations_before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        parser.reset();
+        if (!parser.parse(ids.begin(), ids.end()))
+            state.SkipWithError("generated sentence was rejected");
+    }
+    report_allocations(state, allocations_before, ids.size());
+    report_tokens(state, ids.size());
+    const auto cell_bytes = (table.get_cells().size() + table.get_entries().size() +
+                             table.get_defaults().size()) *
+                                sizeof(LLTable::ProductionIndex) +
+                            (table.get_checks().size() + table.get_displacements().size()) *
+                                sizeof(std::uint32_t);
+    state.counters["table_bytes"] = static_cast<double>(cell_bytes);
+}
+BENCHMARK_CAPTURE(ll_parse_ids, dense, LLTable::Encoding::Dense)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(ll_parse_ids, row_displacement, LLTable::Encoding::RowDisplacement)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(ll_parse_ids, default_rows, LLTable::Encoding::DefaultRows)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000000)
+    ->Unit(benchmark::kMillisecond);
+
+// many small documents of uneven length, split between state.range(0) threads
+void ll_parse_batch(benchmark::State &state)
+{
+    const auto grammar = generate_ll1_grammar(parse_grammar_rules, grammar_seed);
+    FirstFollowSetGenerator sets_generator(grammar);
+    LLParser parser{generate_dense_ll_table(sets_generator)};
+    std::vector<std::vector<SymbolId>> documents;
+    std::size_t tokens = 0;
+    for (std::uint32_t i = 0; i < 2000; i++) {
+        const auto sentence = generate_sentence(grammar, i % 100 == 0 ? 20000 : 200, i);
+        auto &ids = documents.emplace_back();
+        for (const auto &token : sentence)
+            ids.push_back(grammar.get_symbol_table().find(token));
+        tokens += ids.size();
+    }
+    for (auto _ : state) {
+        const auto results = parse_batch(parser, documents, static_cast<unsigned>(state.range(0)));
+        if (!std::ranges::all_of(results, &BatchResult::accepted))
+            state.SkipWithError("generated sentence was rejected");
+    }
+    report_tokens(state, tokens);
+}
+BENCHMARK(ll_parse_batch)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void ll_parse_tree(benchmark::State &state)
+{
+    const auto grammar = generate_ll1_grammar(parse_grammar_rules, grammar_seed);
+    const auto sentence =
+        generate_sentence(grammar, static_cast<std::size_t>(state.range(0)), sentence_seed);
+    FirstFollowSetGenerator sets_generator(grammar);
+    LLParser parser{generate_dense_ll_table(sets_generator)};
+    SyntaxTree tree;
+    parser.set_syntax_tree(&tree);
+    for (auto _ : state) {
+        parser.reset();
+        if (!parser.parse(sentence))
+            state.SkipWithError("generated sentence was rejected");
+    }
+    report_tokens(state, sentence.size());
+    state.counters["nodes"] = static_cast<double>(tree.size());
+}
+BENCHMARK(ll_parse_tree)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+
+// a one token edit in the middle of the sentence, against ll_parse_tree for the whole thing
+void ll_reparse(benchmark::State &state)
+{
+    const auto grammar = generate_ll1_grammar(parse_grammar_rules, grammar_seed);
+    const auto sentence =
+        generate_sentence(grammar, static_cast<std::size_t>(state.range(0)), sentence_seed);
+    FirstFollowSetGenerator sets_generator(grammar);
+    LLParser parser{generate_dense_ll_table(sets_generator)};
+    const auto &symbols = parser.get_table().get_symbol_table();
+    std::vector<SymbolId> input;
+    for (const auto &token : sentence)
+        input.push_back(symbols.find(token));
+    SyntaxTree tree;
+    parser.set_syntax_tree(&tree);
+    if (!parser.parse(input.begin(), input.end()))
+        state.SkipWithError("generated sentence was rejected");
+    const auto nodes = tree.num_allocated();
+    // the token is replaced by itself, which still has to be parsed again
+    const LLParser::TokenEdit edit{input.size() / 2, 1, 1};
+    for (auto _ : state) {
+        if (!parser.reparse(input, edit))
+            state.SkipWithError("edited sentence was rejected");
+    }
+    state.counters["tokens"] = static_cast<double>(input.size());
+    // freed nodes are handed out again, so this stays close to zero
+    state.counters["nodes/reparse"] = (static_cast<double>(tree.num_allocated()) -
+                                       static_cast<double>(nodes)) /
+                                      static_cast<double>(std::max<benchmark::IterationCount>(
+                                          1, state.iterations()));
+}
+BENCHMARK(ll_reparse)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMicrosecond);
+
+void lr_parse(benchmark::State &state)
+{
+    const auto grammar = generate_ll1_grammar(parse_grammar_rules, grammar_seed);
+    const auto sentence =
+        generate_sentence(grammar, static_cast<std::size_t>(state.range(0)), sentence_seed);
+    FirstFollowSetGenerator sets_generator(grammar);
+    LRParser parser{generate_lalr_table(sets_generator)};
+    for (auto _ : state) {
+        parser.reset();
+        if (!parser.parse(sentence))
+            state.SkipWithError("generated sentence was rejected");
+    }
+    report_tokens(state, sentence.size());
+}
+BENCHMARK(lr_parse)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+
+// scans calc.bnf expressions with the generated lexer, bytes/s is the number to look at
+void lex(benchmark::State &state)
+{
+    Driver driver;
+    driver.parse(std::string{EXAMPLE_GRAMMAR_DIR}.append("calc.bnf"));
+    const auto &grammar = driver.grammar;
+    const auto lexer =
+        generate_lexer(grammar.get_token_definitions(), grammar.get_symbol_table());
+    std::string input;
+    while (input.size() < static_cast<std::size_t>(state.range(0)))
+        input += "(alpha + 12.5) * beta_2 + 7 # comment\n";
+
+    std::size_t tokens = 0;
+    for (auto _ : state) {
+        Scanner scanner(lexer, input);
+        tokens = 0;
+        for (Token token; scanner.next(token);)
+            tokens++;
+        if (scanner.failed())
+            state.SkipWithError("input was not lexed");
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                            static_cast<std::int64_t>(input.size()));
+    report_tokens(state, tokens);
+}
+BENCHMARK(lex)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMillisecond);
+} // namespace
+
+int main(int argc, char **argv)
+{
+    // the library logs at info level once per parse, keep that out of the measurements
+    spdlog::set_level(spdlog::level::warn);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "synthetic_grammar.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+
+namespace
+{
+ProductionSymbol terminal(const std::string &name)
+{
+    return ProductionSymbol{name, ProductionSymbol::Kind::Terminal};
+}
+
+ProductionSymbol nonterminal(std::size_t index)
+{
+    return ProductionSymbol{"N" + std::to_string(index), ProductionSymbol::Kind::NonTerminal};
+}
+} // namespace
+
+Grammar generate_ll1_grammar(std::size_t num_rules, std::uint32_t seed, std::size_t num_terminals)
+{
+    std::mt19937 rng(seed);
+    std::vector<ProductionSymbol> pool;
+    for (std::size_t t = 0; t < std::max<std::size_t>(num_terminals, 4); t++)
+        pool.push_back(terminal("t" + std::to_string(t)));
+
+    std::vector<GrammarRule> rules;
+    rules.reserve(num_rules + 1);
+    auto start = ProductionSymbol{"S", ProductionSymbol::Kind::NonTerminal};
+    rules.emplace_back(start, std::vector<Production>{Production{{nonterminal(1), start}},
+                                                      Production{terminal("end")}});
+
+    std::vector<std::size_t> order(pool.size());
+    std::iota(order.begin(), order.end(), 0);
+    for (std::size_t i = 1; i <= num_rules; i++) {
+        // distinct leading terminals keep the alternatives apart, nothing is nullable
+        std::shuffle(order.begin(), order.end(), rng);
+        const auto alternatives = std::uniform_int_distribution<std::size_t>{2, 4}(rng);
+        std::vector<Production> productions;
+        for (std::size_t a = 0; a < alternatives; a++) {
+            std::vector<ProductionSymbol> RHS{pool[order[a]]};
+            if (i < num_rules) {
+                if (a == 0) {
+                    RHS.push_back(nonterminal(i + 1));
+                } else if (rng() % 5 < 2) {
+                    RHS.push_back(nonterminal(
+                        std::uniform_int_distribution<std::size_t>{i + 1, num_rules}(rng)));
+                    if (rng() % 2 == 0)
+                        RHS.push_back(pool[rng() % pool.size()]);
+                }
+            }
+            productions.emplace_back(std::move(RHS));
+        }
+        rules.emplace_back(nonterminal(i), std::move(productions));
+    }
+    return Grammar{std::move(rules)};
+}
+
+std::vector<ProductionSymbol> generate_sentence(const Grammar &grammar, std::size_t length,
+                                                std::uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    const auto &symbols = grammar.get_symbol_table();
+    std::vector<const GrammarRule *> rule_of(symbols.num_nonterminals(), nullptr);
+    for (const auto &rule : grammar.get_rules())
+        rule_of[symbols.nonterminal_index(symbols.find(rule.get_LHS()))] = &rule;
+
+    // leftmost derivation with an explicit stack, the chains can be deep
+    std::vector<ProductionSymbol> sentence;
+    sentence.reserve(length + 16);
+    std::vector<ProductionSymbol> stack{grammar.get_rules().front().get_LHS()};
+    while (!stack.empty()) {
+        auto top = stack.back();
+        stack.pop_back();
+        if (!top.is_nonTerminal()) {
+            sentence.push_back(top);
+            continue;
+        }
+        const auto &productions =
+            rule_of[symbols.nonterminal_index(symbols.find(top))]->get_productions();
+        const auto &chosen = top == grammar.get_rules().front().get_LHS()
+                                 ? productions[sentence.size() < length ? 0 : 1]
+                                 : productions[rng() % productions.size()];
+        const auto &RHS = chosen.get_production_symbols();
+        stack.insert(stack.end(), RHS.rbegin(), RHS.rend());
+    }
+    return sentence;
+}
+
+std::string to_bnf(const Grammar &grammar)
+{
+    std::string bnf;
+    for (const auto &rule : grammar.get_rules()) {
+        bnf += *rule.get_LHS().get_raw_symbol();
+        auto separator = " :";
+        for (const auto &production : rule.get_productions()) {
+            bnf += separator;
+            for (const auto &symbol : production.get_production_symbols()) {
+                bnf += ' ';
+                bnf += symbol.is_epsilon() ? "_EPSILON_" : *symbol.get_raw_symbol();
+            }
+            separator = "\n  |";
+        }
+        bnf += ";\n";
+    }
+    return bnf;
+}
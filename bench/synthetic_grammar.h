@@ -0,0 +1,35 @@
+#ifndef SYNTHETIC_GRAMMAR_H_
+#define SYNTHETIC_GRAMMAR_H_
+
+#include <jacc/grammar.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * A random LL(1) grammar with num_rules + 1 rules, for benchmarking.
+ *
+ * The start rule is a list, S : N1 S | 'end'; and N1 ... Nn pick 2 to 4 alternatives that each
+ * start with a different terminal out of a pool of num_terminals. Alternatives only refer to
+ * nonterminals with a higher number, and Ni always has an alternative that refers to Ni+1, so
+ * every rule is reachable and derivations stay finite.
+ */
+Grammar generate_ll1_grammar(std::size_t num_rules, std::uint32_t seed,
+                             std::size_t num_terminals = 32);
+
+/**
+ * A random sentence of a grammar from generate_ll1_grammar with at least length tokens. The
+ * start rule keeps choosing its recursive alternative until the sentence is long enough, every
+ * other rule picks one at random.
+ */
+std::vector<ProductionSymbol> generate_sentence(const Grammar &grammar, std::size_t length,
+                                                std::uint32_t seed);
+
+/**
+ * The grammar in the .bnf format the Driver reads.
+ */
+std::string to_bnf(const Grammar &grammar);
+
+#endif // SYNTHETIC_GRAMMAR_H_
@@ -0,0 +1,48 @@
+#ifndef BYTE_SCAN_H_
+#define BYTE_SCAN_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * A set of bytes. Byte b is bit b & 7 of low[b >> 4] if b & 8 is clear and of high[b >> 4]
+ * otherwise, so the vectorized scans can look up 16 bytes at once with a shuffle of each half.
+ */
+struct ByteSet {
+    alignas(16) std::array<std::uint8_t, 16> low{};
+    alignas(16) std::array<std::uint8_t, 16> high{};
+
+    void insert(unsigned char byte)
+    {
+        auto &half = (byte & 8) ? high : low;
+        half[byte >> 4] = static_cast<std::uint8_t>(half[byte >> 4] | 1u << (byte & 7));
+    }
+    bool contains(unsigned char byte) const
+    {
+        const auto &half = (byte & 8) ? high : low;
+        return (half[byte >> 4] >> (byte & 7)) & 1;
+    }
+    std::size_t size() const;
+};
+
+/**
+ * Scalar: one byte at a time. SSSE3: 16 bytes at a time. AVX2: 32 bytes at a time.
+ */
+enum class ByteScan { Scalar, SSSE3, AVX2 };
+
+/**
+ * The widest scan the CPU supports, detected once at runtime.
+ */
+ByteScan best_byte_scan();
+
+/**
+ * Position of the first byte at or after from that isn't in set, or input.size() if there is
+ * none. Uses best_byte_scan() unless told otherwise. The scan must be supported by the CPU.
+ */
+std::size_t find_first_not_in(const ByteSet &set, std::string_view input, std::size_t from);
+std::size_t find_first_not_in(const ByteSet &set, std::string_view input, std::size_t from,
+                              ByteScan scan);
+
+#endif // BYTE_SCAN_H_
@@ -0,0 +1,114 @@
+#ifndef DENSE_BITSET_H_
+#define DENSE_BITSET_H_
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Fixed size bitset whose size is decided at runtime, used for sets over dense symbol indices.
+ */
+class DenseBitset
+{
+  public:
+    DenseBitset() = default;
+    explicit DenseBitset(std::size_t size) : num_bits(size), words((size + 63) / 64, 0) {}
+
+    std::size_t size() const { return num_bits; }
+    /**
+     * Keeps the bits below the new size, bits that are added are zero.
+     */
+    void resize(std::size_t size)
+    {
+        num_bits = size;
+        words.resize((size + 63) / 64, 0);
+        if (size % 64 != 0)
+            words.back() &= bit(size) - 1;
+    }
+
+    void set(std::size_t index) { words[index / 64] |= bit(index); }
+    void reset(std::size_t index) { words[index / 64] &= ~bit(index); }
+    bool test(std::size_t index) const { return (words[index / 64] & bit(index)) != 0; }
+    void clear() { std::fill(words.begin(), words.end(), 0); }
+
+    /**
+     * Sets every bit that is set in other. Returns true if that added anything.
+     */
+    bool merge(const DenseBitset &other)
+    {
+        std::uint64_t changed = 0;
+        for (std::size_t i = 0; i < words.size(); i++) {
+            const auto merged = words[i] | other.words[i];
+            changed |= merged ^ words[i];
+            words[i] = merged;
+        }
+        return changed != 0;
+    }
+
+    /**
+     * Clears every bit that is set in other.
+     */
+    void remove(const DenseBitset &other)
+    {
+        for (std::size_t i = 0; i < words.size(); i++)
+            words[i] &= ~other.words[i];
+    }
+
+    /**
+     * Clears every bit that isn't set in other.
+     */
+    void intersect(const DenseBitset &other)
+    {
+        for (std::size_t i = 0; i < words.size(); i++)
+            words[i] &= other.words[i];
+    }
+
+    bool intersects(const DenseBitset &other) const
+    {
+        for (std::size_t i = 0; i < words.size(); i++)
+            if (words[i] & other.words[i])
+                return true;
+        return false;
+    }
+
+    bool none() const
+    {
+        for (auto word : words)
+            if (word)
+                return false;
+        return true;
+    }
+
+    std::size_t count() const
+    {
+        std::size_t total = 0;
+        for (auto word : words)
+            total += static_cast<std::size_t>(std::popcount(word));
+        return total;
+    }
+
+    template <class F> void for_each(F &&f) const
+    {
+        for (std::size_t i = 0; i < words.size(); i++) {
+            for (auto word = words[i]; word != 0; word &= word - 1)
+                f(i * 64 + static_cast<std::size_t>(std::countr_zero(word)));
+        }
+    }
+
+    bool operator==(const DenseBitset &other) const = default;
+
+    /**
+     * Bit i is bit i % 64 of word i / 64, bits past size() are always zero.
+     */
+    const std::vector<std::uint64_t> &get_words() const { return words; }
+
+  private:
+    static std::uint64_t bit(std::size_t index) { return std::uint64_t{1} << (index % 64); }
+
+    std::size_t num_bits = 0;
+    std::vector<std::uint64_t> words;
+};
+
+#endif // DENSE_BITSET_H_
@@ -0,0 +1,129 @@
+#ifndef DFA_LEXER_H_
+#define DFA_LEXER_H_
+
+#include <jacc/byte_scan.h>
+#include <jacc/mapped_array.h>
+#include <jacc/symbol_table.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/**
+ * Transition table of a minimized DFA that recognizes a set of tokens.
+ *
+ * Bytes are first mapped to equivalence classes, bytes that no token tells apart share a class,
+ * so a row of the table has one cell per class instead of 256. State 0 is the dead state that
+ * every failed match ends up in, scanning starts in state 1.
+ *
+ * States that go back to themselves on some bytes, like inside an identifier, a comment or a run
+ * of whitespace, keep those bytes as a ByteSet, so a Scanner can skip the rest of the run with
+ * find_first_not_in() instead of stepping through it byte by byte.
+ *
+ * Like the arrays of an LLTable, the arrays can be views into a CompiledGrammar, see
+ * CompiledGrammar::lexer_table().
+ */
+class LexerTable
+{
+  public:
+    using StateId = std::uint32_t;
+    using TokenIndex = std::uint32_t;
+    static constexpr StateId dead_state = 0;
+    static constexpr StateId start_state = 1;
+    static constexpr TokenIndex no_token = std::numeric_limits<TokenIndex>::max();
+    static constexpr std::uint32_t no_loop = std::numeric_limits<std::uint32_t>::max();
+
+    LexerTable() = default;
+    LexerTable(std::array<std::uint8_t, 256> byte_classes, std::size_t num_classes,
+               std::vector<StateId> transitions, std::vector<TokenIndex> accepting);
+    /**
+     * The table that had these arrays, without looking for the self loops again.
+     */
+    LexerTable(std::array<std::uint8_t, 256> byte_classes, std::size_t num_classes,
+               MappedArray<StateId> transitions, MappedArray<TokenIndex> accepting,
+               MappedArray<std::uint32_t> loop_of, MappedArray<ByteSet> loops);
+
+    StateId next(StateId state, unsigned char byte) const
+    {
+        return transitions[state * classes + byte_classes[byte]];
+    }
+    /**
+     * The token the input read so far is, if the DFA is in state, or no_token.
+     */
+    TokenIndex accepts(StateId state) const { return accepting[state]; }
+    /**
+     * The bytes on which state stays in state, or null if there are none.
+     */
+    const ByteSet *self_loop(StateId state) const
+    {
+        return loop_of[state] == no_loop ? nullptr : &loops[loop_of[state]];
+    }
+
+    std::size_t num_states() const { return accepting.size(); }
+    std::size_t num_classes() const { return classes; }
+    std::uint8_t byte_class(unsigned char byte) const { return byte_classes[byte]; }
+    /**
+     * The arrays behind next() and self_loop(): the transitions row by row, and for every state
+     * the index of its loop in get_loops() or no_loop.
+     */
+    std::span<const StateId> get_transitions() const { return transitions; }
+    std::span<const TokenIndex> get_accepting() const { return accepting; }
+    std::span<const std::uint32_t> get_loop_of() const { return loop_of; }
+    std::span<const ByteSet> get_loops() const { return loops; }
+
+    /**
+     * Terminal each token stands for. Skipped tokens stand for ε, they match input without
+     * producing a terminal. Tokens the grammar never uses are invalid_id.
+     */
+    MappedArray<SymbolId> token_symbols;
+
+  private:
+    std::array<std::uint8_t, 256> byte_classes{};
+    std::size_t classes = 0;
+    MappedArray<StateId> transitions;
+    MappedArray<TokenIndex> accepting;
+    MappedArray<std::uint32_t> loop_of;
+    MappedArray<ByteSet> loops;
+};
+
+struct Token {
+    SymbolId symbol;
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+/**
+ * Splits input into tokens with a LexerTable, always taking the longest match. When two tokens
+ * match the same text the one that was defined first wins.
+ *
+ * Tokens come out as symbol ids, ready to be fed to a parser:
+ *
+ *   Scanner scanner(table, input);
+ *   for (Token token; scanner.next(token);)
+ *       parser.feed(token.symbol);
+ */
+class Scanner
+{
+  public:
+    Scanner(const LexerTable &table, std::string_view input) : table(&table), input(input) {}
+
+    /**
+     * Finds the next token that isn't skipped. Returns false at the end of the input, or when
+     * no token matches at position(), see failed().
+     */
+    bool next(Token &token);
+    bool failed() const { return error; }
+    std::size_t position() const { return offset; }
+
+  private:
+    const LexerTable *table;
+    std::string_view input;
+    std::size_t offset = 0;
+    bool error = false;
+};
+
+#endif // DFA_LEXER_H_
@@ -1,5 +1,6 @@
 #ifndef DRIVER_HH
 #define DRIVER_HH
+#include <cstddef>
 #include <string>
 
 #include <jacc/grammar.h>
@@ -13,6 +14,8 @@
 #define YY_DECL yy::parser::symbol_type yylex(Driver &drv)
 YY_DECL;
 
+struct yy_buffer_state;
+
 class Driver
 {
   public:
@@ -27,11 +30,32 @@ class Driver
     // Handling the scanner.
     void scan_begin();
     void scan_end();
+    /**
+     * The grammar file is memory mapped instead of read, with two zero bytes after its end so
+     * flex can scan it in place. Tokens are views into the mapping, it is only valid during
+     * parse().
+     */
+    void map_input();
+    void unmap_input();
+    /**
+     * Skips the whitespace and // comments that start at offset in the input, whole runs at a
+     * time with find_first_not_in(), and moves location past them. Returns the offset of the
+     * next token, or the size of the file at its end. The scanner calls this before every
+     * token, so flex only ever sees the tokens themselves.
+     */
+    std::size_t skip_layout(std::size_t offset);
+    char *input = nullptr;
+    // of the whole mapping, including the two zero bytes
+    std::size_t input_size = 0;
+    yy_buffer_state *scan_buffer = nullptr;
     // Whether to generate scanner debug traces.
     bool trace_scanning;
     // The token's location used by the scanner.
     yy::location location;
 
+    // Symbols are interned here while parsing and handed over to the grammar.
+    SymbolTable symbols;
+    std::vector<TokenDefinition> token_definitions;
     Grammar grammar;
 };
 #endif // DRIVER_HH
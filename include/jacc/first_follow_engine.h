@@ -0,0 +1,125 @@
+#ifndef FIRST_FOLLOW_ENGINE_H_
+#define FIRST_FOLLOW_ENGINE_H_
+
+#include <jacc/dense_bitset.h>
+#include <jacc/grammar.h>
+#include <jacc/symbol_table.h>
+
+#include <optional>
+#include <span>
+#include <vector>
+
+/**
+ * Computes nullable, FIRST and FOLLOW for a whole grammar at once.
+ *
+ * Sets are bitsets over the dense terminal indices of the grammar's symbol table, and every set
+ * is indexed by the dense nonterminal index. Nullable comes from Grammar::get_nullable(). Each
+ * analysis is a worklist fixpoint over the dependency graph between nonterminals, so a set is
+ * only revisited when one of the sets it is built from actually grew.
+ *
+ * FIRST sets never contain epsilon, ask is_nullable() instead.
+ *
+ * Rules can be replaced, added and removed afterwards. Only the sets that depend on the changed
+ * rule through that graph are computed again.
+ */
+class FirstFollowEngine
+{
+  public:
+    /**
+     * The nonterminals an update changed the sets of, by id. rows are the nonterminals whose row
+     * of an LL(1) table may be different now, see patch_ll_table().
+     */
+    struct Changes {
+        std::vector<SymbolId> nullable;
+        std::vector<SymbolId> first;
+        std::vector<SymbolId> follow;
+        std::vector<SymbolId> rows;
+    };
+
+    explicit FirstFollowEngine(const Grammar &grammar);
+
+    /**
+     * Replaces all productions of the LHS of rule by the ones of rule, which adds the rule if the
+     * LHS had none. New symbols are interned after the known ones, so ids stay valid. Whatever
+     * the replaced productions contributed is taken out of the sets that might have it through
+     * them, and those are derived again from the sets around them. Everything else is left
+     * alone.
+     */
+    Changes replace_rule(const GrammarRule &rule);
+    /**
+     * Removes all productions of LHS, its symbol stays known. The start symbol can't be removed.
+     */
+    Changes remove_rule(const ProductionSymbol &LHS);
+
+    bool is_nullable(SymbolId symbol) const;
+    const DenseBitset &first(SymbolId nonterminal) const;
+    const DenseBitset &follow(SymbolId nonterminal) const;
+    /**
+     * FIRST of a sequence of symbols. nullable is set to whether the whole sequence can derive ε.
+     */
+    DenseBitset first(std::span<const SymbolId> sequence, bool &nullable) const;
+
+    const SymbolTable &get_symbol_table() const { return symbols; }
+    std::size_t num_productions() const { return production_LHS.size(); }
+    SymbolId get_production_LHS(std::size_t production) const { return production_LHS[production]; }
+    /**
+     * Right hand side of a production with all ε symbols dropped, so ε productions are empty.
+     */
+    std::span<const SymbolId> get_production_RHS(std::size_t production) const;
+    /**
+     * Productions of replaced rules keep their index, but are removed from the grammar. The new
+     * ones are added at the end.
+     */
+    bool is_removed(std::size_t production) const { return removed[production]; }
+    /**
+     * The productions of a nonterminal that aren't removed, in the order they were added.
+     */
+    std::span<const std::uint32_t> get_productions(SymbolId nonterminal) const;
+
+  private:
+    struct Occurrence {
+        std::uint32_t production;
+        std::uint32_t position;
+    };
+    /**
+     * Productions and occurrences in a RHS of every nonterminal, by nonterminal index. Only
+     * updates need them, so they are built on first use.
+     */
+    struct Dependencies {
+        std::vector<std::vector<std::uint32_t>> productions;
+        std::vector<std::vector<Occurrence>> occurrences;
+    };
+    const Dependencies &get_dependencies() const;
+    Changes update(SymbolId LHS, const GrammarRule *rule);
+    /**
+     * Makes room for the symbols interned since the sets were last sized.
+     */
+    void add_symbols();
+    /**
+     * Delete and rederive for nullable after the productions of changed were swapped, lost tells
+     * whether a removed one was nullable. Returns the nonterminal indices that changed.
+     */
+    std::vector<std::uint32_t> update_nullable(std::uint32_t changed, bool lost);
+
+    void compute_first_sets();
+    void compute_follow_sets();
+    /**
+     * Repeatedly merges the set of a nonterminal into the sets of its dependents until nothing
+     * changes anymore. Only nonterminals whose set grew are put back on the worklist.
+     */
+    static void propagate(std::vector<DenseBitset> &sets,
+                          std::vector<std::vector<std::uint32_t>> &dependents);
+
+    SymbolTable symbols;
+    DenseBitset nullable;
+    std::vector<SymbolId> production_LHS;
+    std::vector<std::uint32_t> RHS_offsets;
+    std::vector<SymbolId> RHS_symbols;
+    std::vector<bool> removed;
+    mutable std::optional<Dependencies> dependencies;
+
+    std::vector<DenseBitset> first_sets;
+    std::vector<DenseBitset> follow_sets;
+};
+
+#endif // FIRST_FOLLOW_ENGINE_H_
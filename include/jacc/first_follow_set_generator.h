@@ -1,14 +1,23 @@
 #ifndef FIRST_FOLLOW_SET_GENERATOR_H_
 #define FIRST_FOLLOW_SET_GENERATOR_H_
 
+#include <jacc/first_follow_engine.h>
 #include <jacc/grammar.h>
 #include <map>
+#include <memory>
 #include <set>
 
 class FirstFollowSetGenerator
 {
   public:
-    explicit FirstFollowSetGenerator(const Grammar &g) : grammar(g) {};
+    /**
+     * Recursive is the original engine working directly on ProductionSymbols.
+     * Bitset runs FirstFollowEngine once and translates its results back to ProductionSymbols.
+     */
+    enum class Engine { Recursive, Bitset };
+
+    explicit FirstFollowSetGenerator(const Grammar &g, Engine engine = Engine::Bitset)
+        : grammar(g), engine(engine) {};
     template <class T> using set_map = std::map<ProductionSymbol, std::set<T>>;
     std::set<ProductionSymbol> first(const Production &p);
     std::set<ProductionSymbol> first(const ProductionSymbol &p);
@@ -19,7 +28,24 @@ class FirstFollowSetGenerator
     set_map<ProductionSymbol> follow_sets{};
     Grammar grammar;
 
+    /**
+     * The bitset engine, computed on first use.
+     */
+    const FirstFollowEngine &get_engine();
+    /**
+     * Changes a rule of grammar and updates the bitset engine incrementally, see
+     * FirstFollowEngine::replace_rule(). The symbol sets are translated again on their next use.
+     */
+    FirstFollowEngine::Changes replace_rule(const GrammarRule &rule);
+    FirstFollowEngine::Changes remove_rule(const ProductionSymbol &LHS);
+
   private:
+    std::set<ProductionSymbol> to_symbol_set(const DenseBitset &terminals, bool with_epsilon) const;
+    FirstFollowEngine &get_mutable_engine();
+    void forget_sets();
+
+    Engine engine;
+    std::shared_ptr<FirstFollowEngine> bitset_engine;
     bool first_initialized = false;
     bool follow_initialized = false;
 };
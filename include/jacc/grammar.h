@@ -2,62 +2,24 @@
 #define GRAMMAR_H_
 
 #include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <numeric>
 #include <optional>
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include <jacc/dense_bitset.h>
+#include <jacc/production_symbol.h>
+#include <jacc/symbol_table.h>
+#include <jacc/token_definition.h>
+
 #include "fmt/ranges.h"
 #include "fmt/format.h"
 #include "fmt/base.h"
 
-class ProductionSymbol
-{
-  public:
-    enum class Kind { Uninitialized, NonTerminal, Terminal, EndOfInput };
-    ProductionSymbol(const std::optional<std::string> &symbol, Kind kind)
-        : kind(kind), raw_symbol(symbol)
-    {
-    }
-
-    ProductionSymbol() : kind(Kind::Uninitialized) {}
-
-    bool is_terminal() const { return kind == Kind::Terminal; }
-    bool is_nonTerminal() const { return kind == Kind::NonTerminal; }
-    bool is_initialized() const { return kind != Kind::Uninitialized; }
-    bool is_epsilon() const { return !raw_symbol.has_value(); }
-    bool is_EOI() const { return kind == Kind::EndOfInput; }
-    const std::optional<std::string>& get_raw_symbol() const {
-      return raw_symbol;
-    }
-
-    static ProductionSymbol create_epsilon();
-    static ProductionSymbol create_EOI();
-
-    bool operator<(const ProductionSymbol &other) const
-    {
-        return this->raw_symbol < other.raw_symbol;
-    }
-    bool operator==(const ProductionSymbol &other) const
-    {
-        return this->raw_symbol == other.raw_symbol && this->kind == other.kind;
-    }
-    bool operator!=(const ProductionSymbol &other) const { return !(*this == other); }
-
-  private:
-    Kind kind;
-    std::optional<std::string> raw_symbol;
-    friend struct fmt::formatter<ProductionSymbol>;
-};
-
-template <> struct fmt::formatter<ProductionSymbol> {
-    constexpr auto parse(format_parse_context &ctx) { return ctx.end(); }
-    template <typename FormatContext>
-    auto format(const ProductionSymbol & ps, FormatContext& ctx) const {
-        return fmt::format_to(ctx.out(), "{}", ps.raw_symbol.value_or("epsilon"));
-    }
-};
-
 /**
  * A production is a one-to-one mapping between LHS and RHS
  * A grammar rule is made of one or more productions
@@ -70,7 +32,7 @@ class Production
   public:
     Production() : production_symbols({}) {}
 
-    explicit Production(std::vector<ProductionSymbol> RHS) : production_symbols(RHS) {}
+    explicit Production(std::vector<ProductionSymbol> RHS) : production_symbols(std::move(RHS)) {}
 
     explicit Production(ProductionSymbol RHS) : Production(std::vector<ProductionSymbol>{RHS}) {}
 
@@ -131,9 +93,11 @@ class GrammarRule
 {
   public:
     GrammarRule() : LHS(), RHS({}) {}
-    explicit GrammarRule(ProductionSymbol LHS, std::vector<Production> RHSs) : LHS(LHS), RHS(RHSs)
+    explicit GrammarRule(ProductionSymbol LHS, std::vector<Production> RHSs)
+        : LHS(std::move(LHS)), RHS(std::move(RHSs))
     {
-        std::for_each(RHS.begin(), RHS.end(), [LHS](Production &p) { p.synthesized_LHS = LHS; });
+        std::for_each(RHS.begin(), RHS.end(),
+                      [this](Production &p) { p.synthesized_LHS = this->LHS; });
     }
 
     explicit GrammarRule(ProductionSymbol LHS, Production RHS)
@@ -170,20 +134,89 @@ struct fmt::formatter<GrammarRule> {
     }
 };
 
+/**
+ * Where a symbol appears in a grammar: rules[rule].get_productions()[production], at position.
+ */
+struct SymbolOccurrence {
+    std::uint32_t rule;
+    std::uint32_t production;
+    std::uint32_t position;
+};
+
 class Grammar
 {
   public:
-    Grammar() : rules({}) {}
-    explicit Grammar(GrammarRule rule) : rules({rule}) {}
-    explicit Grammar(std::vector<GrammarRule> rules) : rules(rules) {}
+    Grammar() : Grammar(std::vector<GrammarRule>{}) {}
+    explicit Grammar(GrammarRule rule) : Grammar(std::vector<GrammarRule>{rule}) {}
+    explicit Grammar(std::vector<GrammarRule> rules) : Grammar(rules, SymbolTable{}) {}
+    /**
+     * Takes over a symbol table that was already filled while loading the rules,
+     * like the one the grammar parser builds up in its actions.
+     */
+    explicit Grammar(std::vector<GrammarRule> rules, SymbolTable symbols);
 
     const std::vector<GrammarRule> &get_rules() const { return rules; }
     const std::optional<GrammarRule> get_production(const ProductionSymbol &p) const;
     std::optional<std::vector<Production>> get_rules_containing_symbol(const ProductionSymbol &p);
 
+    /**
+     * The rule for a nonterminal, or nullptr. Unlike get_production() this is an index lookup
+     * and doesn't copy the rule.
+     */
+    const GrammarRule *find_rule(const ProductionSymbol &LHS) const;
+    /**
+     * Every place symbol appears in a RHS, in grammar order. A symbol that appears twice in a
+     * production has two occurrences.
+     */
+    std::span<const SymbolOccurrence> get_occurrences(const ProductionSymbol &symbol) const;
+
+    /**
+     * The nonterminals that derive ε, by dense nonterminal index. Computed once for the whole
+     * grammar, FIRST, FOLLOW and table generation all use this.
+     */
+    const DenseBitset &get_nullable() const;
+    /**
+     * True for ε and nullable nonterminals, false for terminals and unknown symbols.
+     */
+    bool is_nullable(const ProductionSymbol &symbol) const;
+    const SymbolTable &get_symbol_table() const { return symbols; }
+
+    /**
+     * Replaces the rule for the LHS of rule where it is, or appends rule if there is none. New
+     * symbols are interned after the known ones, whose ids don't change.
+     */
+    void replace_rule(GrammarRule rule);
+    /**
+     * Drops the rule for LHS if there is one. The first rule holds the start symbol and can't be
+     * removed.
+     */
+    void remove_rule(const ProductionSymbol &LHS);
+
+    /**
+     * Regex definitions of the terminals, in the order they appear in the grammar file. Empty
+     * for grammars that leave lexing to someone else.
+     */
+    const std::vector<TokenDefinition> &get_token_definitions() const { return token_definitions; }
+    void set_token_definitions(std::vector<TokenDefinition> definitions)
+    {
+        token_definitions = std::move(definitions);
+    }
+
   private:
     std::optional<std::string> grammar_string = std::nullopt;
     std::vector<GrammarRule> rules;
+    SymbolTable symbols;
+    std::vector<TokenDefinition> token_definitions;
+
+    /**
+     * Rule and occurrence lookups by symbol id and the nullable set, built once on first use
+     * even when several threads ask at the same time. Copies share it, a grammar whose rules
+     * change starts over with a new one.
+     */
+    struct Index;
+    const Index &get_index() const;
+    void build_index(Index &built) const;
+    std::shared_ptr<Index> index;
     friend class fmt::formatter<Grammar>;
 };
 
@@ -0,0 +1,131 @@
+#ifndef GRAMMAR_CACHE_H_
+#define GRAMMAR_CACHE_H_
+
+#include <jacc/dfa_lexer.h>
+#include <jacc/first_follow_engine.h>
+#include <jacc/grammar.h>
+#include <jacc/ll_table.h>
+#include <jacc/symbol_table.h>
+#include <jacc/token_definition.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * Content hash of a grammar file, compiled grammars are keyed by it. 64 bit FNV-1a.
+ */
+std::uint64_t hash_grammar(std::string_view text);
+/**
+ * hash_grammar() of the file at path, or nullopt if it can't be read.
+ */
+std::optional<std::uint64_t> hash_grammar_file(const std::string &path);
+
+/**
+ * Serializes everything jacc derives from a grammar file: the symbol table, the productions,
+ * nullable, FIRST and FOLLOW, the dense LL(1) table with its perfect hash, the token definitions
+ * and the lexer generated from them. table has to be generate_dense_ll_table() of the grammar
+ * engine was built for, in the Dense encoding. Throws std::invalid_argument like
+ * generate_lexer() if a token pattern doesn't parse.
+ *
+ * The result is an image to be written to a file as is and mapped back in with
+ * CompiledGrammar::open(). It is made of 16 byte aligned arrays in native byte order, laid out
+ * like the arrays of the tables themselves.
+ */
+std::string serialize_compiled_grammar(std::uint64_t grammar_hash, const Grammar &grammar,
+                                       const FirstFollowEngine &engine, const LLTable &table);
+
+/**
+ * A grammar compiled by serialize_compiled_grammar(), mapped read-only from its file.
+ *
+ * Opening one is a single mmap plus a check of the contents, every accessor is a view into the
+ * mapping. So are the tables for the parsers, ll_table() and lexer_table() only wrap the mapped
+ * arrays. The to_ functions build heap based copies of the rest.
+ */
+class CompiledGrammar
+{
+  public:
+    using ProductionIndex = LLTable::ProductionIndex;
+    // bump whenever the layout changes, files in another version are ignored
+    static constexpr std::uint32_t format_version = 2;
+
+    /**
+     * Returns nullopt if the file doesn't exist, is damaged, has another format version or byte
+     * order, or was compiled from a grammar whose hash isn't grammar_hash. Damage is anything
+     * that would make an accessor read out of bounds, the FIRST and FOLLOW bits aren't checked.
+     */
+    static std::optional<CompiledGrammar> open(const std::string &path, std::uint64_t grammar_hash);
+
+    std::size_t num_symbols() const;
+    std::size_t num_terminals() const;
+    std::size_t num_nonterminals() const;
+    /**
+     * Symbols have the ids the grammar's SymbolTable gave them, ε has an empty name.
+     */
+    std::string_view symbol_name(SymbolId id) const;
+    ProductionSymbol::Kind symbol_kind(SymbolId id) const;
+    SymbolId get_start_symbol() const;
+
+    std::size_t num_productions() const;
+    SymbolId get_LHS(ProductionIndex production) const;
+    std::span<const SymbolId> get_RHS(ProductionIndex production) const;
+
+    /**
+     * FIRST and FOLLOW are bitsets over the dense terminal indices in DenseBitset's word layout.
+     */
+    bool is_nullable(SymbolId nonterminal) const;
+    std::span<const std::uint64_t> first(SymbolId nonterminal) const;
+    std::span<const std::uint64_t> follow(SymbolId nonterminal) const;
+    /**
+     * The cells of the LL(1) table, laid out like LLTable::get_cells().
+     */
+    std::span<const ProductionIndex> get_cells() const;
+
+    /**
+     * The dense LL(1) table, its symbol table and its perfect hash as views into the mapping,
+     * which the returned pointer keeps alive. Nothing is copied, only get_symbol() and find() of
+     * the symbol table build the symbols the first time they are called.
+     */
+    std::shared_ptr<const LLTable> ll_table() const;
+    /**
+     * The lexer for the token definitions as a view into the mapping, like ll_table().
+     */
+    std::shared_ptr<const LexerTable> lexer_table() const;
+    std::vector<TokenDefinition> to_token_definitions() const;
+    /**
+     * FOLLOW of every nonterminal by dense index, the synchronizing tokens for
+     * LLParser::set_recovery().
+     */
+    std::vector<DenseBitset> to_follow_sets() const;
+
+  private:
+    explicit CompiledGrammar(std::shared_ptr<const std::byte> mapping)
+        : mapping(std::move(mapping)), data(this->mapping.get())
+    {
+    }
+    template <typename T> std::span<const T> section(std::size_t index) const;
+    template <typename T> MappedArray<T> view(std::size_t index) const
+    {
+        return MappedArray<T>::view(section<T>(index));
+    }
+    /**
+     * Whether every id, offset and index in the sections is in range, once the section sizes
+     * are known to match the header.
+     */
+    bool is_consistent() const;
+    // the same for the lexer sections
+    bool is_lexer_consistent() const;
+    std::span<const std::uint64_t> set(std::size_t section_index, SymbolId nonterminal) const;
+
+    // unmapped once the last copy and the last table from it are gone
+    std::shared_ptr<const std::byte> mapping;
+    const std::byte *data = nullptr;
+};
+
+#endif // GRAMMAR_CACHE_H_
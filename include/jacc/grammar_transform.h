@@ -0,0 +1,38 @@
+#ifndef GRAMMAR_TRANSFORM_H_
+#define GRAMMAR_TRANSFORM_H_
+
+#include <jacc/grammar.h>
+
+/**
+ * Rewrites left recursion into right recursion with Paull's algorithm. Nonterminals that derive
+ * each other in leftmost position are substituted into the earliest of them, and then
+ * A : A a | b; becomes A : b A'; A' : a A' | ε;. A production that also ends in A, like the
+ * ambiguous E : E + E;, gets the tail + E instead of + E E', which describes the same language
+ * without an LL(1) conflict.
+ *
+ * Substitution only happens inside a cycle of leftmost derivations, so rules that aren't part of
+ * one stay as they are. Left recursion hidden behind a nullable prefix is exposed first by
+ * replacing the prefix with its alternatives, A : B A x; B : ε | z; is treated as
+ * A : A x | z A x;.
+ */
+Grammar eliminate_left_recursion(const Grammar &grammar);
+
+/**
+ * Pulls the longest common prefix of alternatives out of a rule, A : x y | x z; becomes
+ * A : x A'; A' : y | z;, repeated until no two alternatives of a rule start with the same symbol.
+ */
+Grammar left_factor(const Grammar &grammar);
+
+/**
+ * The rewrite that runs between loading a grammar and building its LL(1) table: eliminates left
+ * recursion and left factors. Alternatives whose FIRST sets still overlap after that have their
+ * leading nonterminal replaced by its productions, so factoring sees the common prefix, for a
+ * bounded number of rounds.
+ *
+ * In all three, new nonterminals are named after the rule they came from with ' appended, and
+ * rules that are no longer reachable from the start symbol are dropped. Token definitions are
+ * kept.
+ */
+Grammar rewrite_for_ll(const Grammar &grammar);
+
+#endif // GRAMMAR_TRANSFORM_H_
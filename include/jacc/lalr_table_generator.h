@@ -0,0 +1,30 @@
+#ifndef LALR_TABLE_GENERATOR_H_
+#define LALR_TABLE_GENERATOR_H_
+
+#include <jacc/dense_bitset.h>
+#include <jacc/first_follow_engine.h>
+#include <jacc/first_follow_set_generator.h>
+#include <jacc/lr_automaton.h>
+#include <jacc/lr_table.h>
+
+#include <vector>
+
+/**
+ * LALR(1) lookaheads for every reduction of the automaton, indexed by reduction slot.
+ *
+ * Uses the relations of DeRemer and Pennello: direct reads and reads give Read(p, A) for every
+ * nonterminal transition, includes turns those into Follow(p, A), and lookback collects them into
+ * the lookahead sets. Both closures are computed with their digraph algorithm, which is linear in
+ * the size of the relation.
+ */
+std::vector<DenseBitset> compute_lalr_lookaheads(const LRAutomaton &automaton,
+                                                 const FirstFollowEngine &sets);
+
+/**
+ * Builds the LR(0) automaton of the grammar and fills ACTION and GOTO using LALR(1) lookaheads.
+ * Conflicts are resolved in favour of shifting, or of the earlier production, and are counted in
+ * LRTable::conflicts.
+ */
+LRTable generate_lalr_table(FirstFollowSetGenerator &sets_generator);
+
+#endif // LALR_TABLE_GENERATOR_H_
@@ -0,0 +1,24 @@
+#ifndef LEXER_GENERATOR_H_
+#define LEXER_GENERATOR_H_
+
+#include <jacc/dfa_lexer.h>
+#include <jacc/symbol_table.h>
+#include <jacc/token_definition.h>
+
+#include <vector>
+
+/**
+ * Builds a minimized DFA for the token definitions: every pattern becomes a Thompson NFA, their
+ * union is turned into a DFA by subset construction over byte equivalence classes, and Hopcroft's
+ * algorithm minimizes it. Classes whose columns end up identical are merged afterwards.
+ *
+ * Token i of the table is definitions[i], and stands for the terminal of the same name in symbols.
+ *
+ * Patterns support literals, escapes (\n, \t, \d, \w, \s and escaped metacharacters), ., character
+ * classes like [^a-z_], grouping, | and the *, + and ? operators. Throws std::invalid_argument
+ * for a pattern that doesn't parse.
+ */
+LexerTable generate_lexer(const std::vector<TokenDefinition> &definitions,
+                          const SymbolTable &symbols);
+
+#endif // LEXER_GENERATOR_H_
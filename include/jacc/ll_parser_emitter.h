@@ -0,0 +1,33 @@
+#ifndef LL_PARSER_EMITTER_H_
+#define LL_PARSER_EMITTER_H_
+
+#include <jacc/ll_table.h>
+
+#include <string>
+
+/**
+ * Source code of a generated parser, together with the file names the source expects.
+ */
+struct EmittedParser {
+    std::string header_name;
+    std::string header;
+    std::string source_name;
+    std::string source;
+};
+
+/**
+ * Emits a self-contained table driven LL(1) parser for the given table.
+ *
+ * Everything the parser needs is baked into constant arrays: the parse table, the production
+ * pool and the terminal spellings. The generated code only depends on the C++20 standard library,
+ * so it can be compiled into a project without jacc, spdlog or fmt. The parse loop is a template
+ * in the header, so semantic actions passed to Parser::parse() are called directly. The parse
+ * table keeps the encoding of table, a compressed one is emitted as its row displacement arrays.
+ *
+ * Symbols are identified by codes: terminals keep their dense index from the table, so $ is 0,
+ * and nonterminals are numbered after the terminals. Everything is wrapped in namespace `name`,
+ * with any character that can't be part of an identifier replaced by an underscore.
+ */
+EmittedParser emit_ll_parser(const LLTable &table, const std::string &name);
+
+#endif // LL_PARSER_EMITTER_H_
@@ -0,0 +1,211 @@
+#ifndef LL_TABLE_H_
+#define LL_TABLE_H_
+
+#include <jacc/grammar.h>
+#include <jacc/mapped_array.h>
+#include <jacc/perfect_hash.h>
+#include <jacc/symbol_table.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * Size of an LL(1) table and of its cells in other encodings, to choose a representation and to
+ * notice grammars that grow unexpectedly. Byte counts only cover the cells, the production pool
+ * is the same for every encoding.
+ */
+struct LLTableStats {
+    std::size_t rows = 0;
+    std::size_t columns = 0;
+    std::size_t filled_cells = 0;
+    std::size_t productions = 0;
+    std::size_t conflicts = 0;
+    double fill_ratio = 0;
+    // bytes of the cells in each LLTable::Encoding
+    std::size_t dense_bytes = 0;
+    std::size_t compressed_bytes = 0;
+    std::size_t default_rows_bytes = 0;
+};
+
+/**
+ * An LL(1) parse table.
+ *
+ * Cells only hold a small index into a shared pool of productions, so a production that fills
+ * several cells is stored once. Symbol ids are mapped to rows and columns through flat arrays.
+ * A table is filled in the Dense encoding, one contiguous [nonterminal × terminal] array, and
+ * can then be compress()ed. lookup() stays a handful of array reads without ever allocating in
+ * every encoding.
+ *
+ * The arrays can also be views into a CompiledGrammar mapped from a file, see
+ * CompiledGrammar::ll_table(). Changing such a table copies what it changes first.
+ */
+class LLTable
+{
+  public:
+    using ProductionIndex = std::uint32_t;
+    static constexpr ProductionIndex no_production = std::numeric_limits<ProductionIndex>::max();
+
+    /**
+     * FIRST/FIRST: two productions start with the same terminal. FIRST/FOLLOW: a nullable
+     * production would be chosen on a terminal that another production starts with.
+     * FOLLOW/FOLLOW: two productions of the same nonterminal derive ε.
+     */
+    enum class ConflictKind { FirstFirst, FirstFollow, FollowFollow };
+    struct Conflict {
+        ConflictKind kind;
+        SymbolId nonterminal;
+        SymbolId terminal;
+        // the production that keeps the cell and the one that was turned away
+        ProductionIndex kept;
+        ProductionIndex dropped;
+    };
+
+    /**
+     * Dense: every cell is stored, mostly as no_production.
+     * RowDisplacement: the rows are overlaid into one comb vector, each shifted by its own
+     * displacement so that its filled cells land on free entries. A check array holds the row
+     * each entry belongs to, anything else is an empty cell.
+     * DefaultRows: like RowDisplacement, but the production a row holds most often becomes the
+     * default of the row and is left out of the comb vector. Empty cells of such a row return the
+     * default instead of no_production. That is still safe for LL parsing: the parser expands
+     * the default and fails at the next terminal without consuming the offending token.
+     */
+    enum class Encoding { Dense, RowDisplacement, DefaultRows };
+
+    LLTable() = default;
+    LLTable(SymbolTable symbols, SymbolId start_symbol);
+
+    /**
+     * Adds a production to the pool. ε symbols are dropped, so ε productions have an empty RHS.
+     */
+    ProductionIndex add_production(SymbolId LHS, std::span<const SymbolId> RHS);
+    /**
+     * Only for Dense tables.
+     */
+    void set(SymbolId nonterminal, SymbolId terminal, ProductionIndex production);
+    /**
+     * Empties the row of a nonterminal. Only for Dense tables.
+     */
+    void clear_row(SymbolId nonterminal);
+    /**
+     * Takes over symbols, a symbol table that starts with the symbols of this one. Rows and
+     * columns of the new symbols are empty. Only for Dense tables.
+     */
+    void extend_symbols(SymbolTable symbols);
+    /**
+     * Re-encodes a Dense table, the dense cells are released. Does nothing for other tables.
+     */
+    void compress(Encoding target);
+
+    ProductionIndex lookup(SymbolId nonterminal, SymbolId terminal) const noexcept
+    {
+        if (nonterminal >= row_of.size() || terminal >= column_of.size())
+            return no_production;
+        const auto row = row_of[nonterminal];
+        const auto column = column_of[terminal];
+        if (row == SymbolTable::no_index || column == SymbolTable::no_index)
+            return no_production;
+        if (encoding == Encoding::Dense)
+            return cells[static_cast<std::size_t>(row) * num_columns() + column];
+        // the comb vector is padded by a row's width, so this never reads past its end
+        const auto slot = static_cast<std::size_t>(displacements[row]) + column;
+        return checks[slot] == row ? entries[slot] : defaults[row];
+    }
+
+    SymbolId get_LHS(ProductionIndex production) const { return production_LHS[production]; }
+    std::span<const SymbolId> get_RHS(ProductionIndex production) const
+    {
+        return std::span<const SymbolId>{RHS_symbols}.subspan(
+            RHS_offsets[production], RHS_offsets[production + 1] - RHS_offsets[production]);
+    }
+    /**
+     * The production LHS → RHS, or no_production. ε symbols in RHS are ignored like in
+     * add_production().
+     */
+    ProductionIndex find_production(SymbolId LHS, std::span<const SymbolId> RHS) const;
+    /**
+     * Rebuilds a Production the way generate_ll_table() stores it, ε productions included.
+     */
+    Production to_production(ProductionIndex production) const;
+
+    /**
+     * The terminal spelled spelling, or invalid_id. One perfect hash lookup and one compare, see
+     * get_terminal_hash().
+     */
+    SymbolId find_terminal(std::string_view spelling) const noexcept
+    {
+        const auto slot = terminal_hash.slot(spelling);
+        if (slot == PerfectHash::no_slot)
+            return SymbolTable::invalid_id;
+        const auto terminal = terminal_of_slot[slot];
+        return symbols.name(terminal) == spelling ? terminal : SymbolTable::invalid_id;
+    }
+    /**
+     * Perfect hash over the spellings of all terminals except $, built with the table. Slot s
+     * belongs to terminal get_terminal_of_slot()[s].
+     */
+    const PerfectHash &get_terminal_hash() const { return terminal_hash; }
+    std::span<const SymbolId> get_terminal_of_slot() const { return terminal_of_slot; }
+
+    const SymbolTable &get_symbol_table() const { return symbols; }
+    SymbolId get_start_symbol() const { return start_symbol; }
+    std::size_t num_productions() const { return production_LHS.size(); }
+    std::size_t num_rows() const { return symbols.num_nonterminals(); }
+    std::size_t num_columns() const { return symbols.num_terminals(); }
+    Encoding get_encoding() const { return encoding; }
+    /**
+     * The cells of a Dense table, row by row. Empty for the other encodings.
+     */
+    std::span<const ProductionIndex> get_cells() const { return cells; }
+    /**
+     * The arrays of a compressed table: row r owns entries[displacements[r] + column] where
+     * checks[] is r, every other cell of the row is defaults[r].
+     */
+    std::span<const std::uint32_t> get_displacements() const { return displacements; }
+    std::span<const ProductionIndex> get_entries() const { return entries; }
+    std::span<const std::uint32_t> get_checks() const { return checks; }
+    std::span<const ProductionIndex> get_defaults() const { return defaults; }
+
+    /**
+     * Sizes are computed from the dense cells, so only rows, columns, productions and conflicts
+     * are filled in once a table is compressed.
+     */
+    LLTableStats compute_stats() const;
+    /**
+     * Like "FIRST/FIRST conflict in E on id: E -> id kept over E -> id ( )".
+     */
+    std::string describe(const Conflict &conflict) const;
+
+    // every cell that more than one production claimed while the table was generated, see
+    // generate_dense_ll_table() for which one wins
+    std::vector<Conflict> conflicts;
+
+  private:
+    friend class CompiledGrammar;
+
+    void index_symbols();
+    void build_terminal_hash();
+
+    SymbolTable symbols;
+    SymbolId start_symbol = SymbolTable::invalid_id;
+    MappedArray<std::uint32_t> row_of;
+    MappedArray<std::uint32_t> column_of;
+    PerfectHash terminal_hash;
+    MappedArray<SymbolId> terminal_of_slot;
+    Encoding encoding = Encoding::Dense;
+    MappedArray<ProductionIndex> cells;
+    MappedArray<std::uint32_t> displacements;
+    MappedArray<ProductionIndex> entries;
+    MappedArray<std::uint32_t> checks;
+    MappedArray<ProductionIndex> defaults;
+
+    MappedArray<SymbolId> production_LHS;
+    MappedArray<std::uint32_t> RHS_offsets{std::vector<std::uint32_t>{0}};
+    MappedArray<SymbolId> RHS_symbols;
+};
+
+#endif // LL_TABLE_H_
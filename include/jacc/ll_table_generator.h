@@ -3,12 +3,41 @@
 
 #include <jacc/first_follow_set_generator.h>
 #include <jacc/grammar.h>
+#include <jacc/ll_table.h>
 
 #include <map>
 
+/**
+ * When productions claim the same cell, the FIRST entries win over the ε production and an
+ * earlier production over a later one. Conflicts are counted in a warning.
+ */
 std::map<ProductionSymbol, std::map<ProductionSymbol, Production>>
 generate_ll_table(Grammar &grammar, FirstFollowSetGenerator &sets_generator);
 
+/**
+ * Same table as generate_ll_table(), built straight from the bitset engine into a dense LLTable.
+ * Conflicts are resolved the same way and every one of them is kept in LLTable::conflicts.
+ * The table is filled densely and then compressed into encoding.
+ */
+LLTable generate_dense_ll_table(FirstFollowSetGenerator &sets_generator,
+                                LLTable::Encoding encoding = LLTable::Encoding::Dense);
+
+/**
+ * Brings a Dense table from generate_dense_ll_table() up to date after rules of sets_generator
+ * were changed, by filling only the rows in changes again. The table takes over new symbols
+ * with empty rows and columns first. All Changes since the table was generated have to be
+ * patched in, in any order.
+ */
+void patch_ll_table(LLTable &table, FirstFollowSetGenerator &sets_generator,
+                    const FirstFollowEngine::Changes &changes);
+
+/**
+ * Converts a table from generate_ll_table() into a dense LLTable.
+ */
+LLTable
+to_dense_ll_table(const std::map<ProductionSymbol, std::map<ProductionSymbol, Production>> &table,
+                  const ProductionSymbol &start_symbol);
+
 bool is_nullable(const Production &p, const Grammar &g);
 bool is_nullable(const ProductionSymbol &p, const Grammar &g);
 
@@ -0,0 +1,96 @@
+#ifndef LR_AUTOMATON_H_
+#define LR_AUTOMATON_H_
+
+#include <jacc/first_follow_engine.h>
+#include <jacc/symbol_table.h>
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+/**
+ * The canonical collection of LR(0) item sets for a grammar, augmented with S' → S.
+ *
+ * Production 0 is the augmented production, production p + 1 is production p of the
+ * FirstFollowEngine the automaton was built from. An item is a single integer, the item for
+ * production p with the dot before symbol d is get_item(p, d).
+ *
+ * States only store their kernel items, their outgoing transitions sorted by symbol id and the
+ * productions they can reduce by. Everything lives in flat arrays indexed through offsets, so
+ * building thousands of states doesn't mean thousands of small containers.
+ */
+class LRAutomaton
+{
+  public:
+    using StateId = std::uint32_t;
+    using Item = std::uint32_t;
+    static constexpr StateId no_state = std::numeric_limits<StateId>::max();
+
+    struct Transition {
+        SymbolId symbol;
+        StateId target;
+    };
+
+    explicit LRAutomaton(const FirstFollowEngine &sets);
+
+    std::size_t num_states() const { return kernel_offsets.size() - 1; }
+    std::size_t num_productions() const { return production_LHS.size(); }
+
+    SymbolId get_production_LHS(std::size_t production) const { return production_LHS[production]; }
+    std::span<const SymbolId> get_production_RHS(std::size_t production) const;
+    std::span<const std::uint32_t> get_productions_of(SymbolId nonterminal) const;
+
+    Item get_item(std::size_t production, std::size_t dot) const
+    {
+        return item_base[production] + static_cast<Item>(dot);
+    }
+    std::size_t get_item_production(Item item) const { return item_production[item]; }
+    std::size_t get_item_dot(Item item) const { return item - item_base[item_production[item]]; }
+
+    std::span<const Item> get_kernel(StateId state) const;
+    std::span<const Transition> get_transitions(StateId state) const;
+    /**
+     * Productions whose item is complete in the closure of the state, ε productions included.
+     * The augmented production is left out, reaching S' → S• means accepting instead.
+     */
+    std::span<const std::uint32_t> get_reductions(StateId state) const;
+    /**
+     * Reductions of all states are numbered consecutively, the first reduction of a state has
+     * number get_reduction_slot(state).
+     */
+    std::size_t get_reduction_slot(StateId state) const { return reduction_offsets[state]; }
+    std::size_t num_reduction_slots() const { return reductions.size(); }
+    /**
+     * Target of the transition on symbol, or no_state. Binary search over the sorted transitions.
+     */
+    StateId get_transition(StateId state, SymbolId symbol) const;
+
+    const SymbolTable &get_symbol_table() const { return symbols; }
+
+  private:
+    void closure(std::span<const Item> kernel, std::vector<Item> &items);
+
+    SymbolTable symbols;
+
+    std::vector<SymbolId> production_LHS;
+    std::vector<std::uint32_t> RHS_offsets;
+    std::vector<SymbolId> RHS_symbols;
+    std::vector<std::uint32_t> productions_of_offsets;
+    std::vector<std::uint32_t> productions_of;
+    std::vector<Item> item_base;
+    std::vector<std::uint32_t> item_production;
+
+    std::vector<std::uint32_t> kernel_offsets;
+    std::vector<Item> kernel_items;
+    std::vector<std::uint32_t> transition_offsets;
+    std::vector<Transition> transitions;
+    std::vector<std::uint32_t> reduction_offsets;
+    std::vector<std::uint32_t> reductions;
+
+    // scratch space for closure(), stamped with the state being closed
+    std::vector<std::uint32_t> closure_stamps;
+    std::uint32_t closure_stamp = 0;
+};
+
+#endif // LR_AUTOMATON_H_
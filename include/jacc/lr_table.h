@@ -0,0 +1,94 @@
+#ifndef LR_TABLE_H_
+#define LR_TABLE_H_
+
+#include <jacc/symbol_table.h>
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+/**
+ * ACTION and GOTO tables of an LR parser.
+ *
+ * Both are dense [state × symbol] arrays of 32 bit cells. An ACTION cell packs the kind of action
+ * into its top two bits and the shift target or production into the rest, and an all zero cell
+ * is an error. Productions are kept in one shared pool like in LLTable.
+ */
+class LRTable
+{
+  public:
+    using StateId = std::uint32_t;
+    using ProductionIndex = std::uint32_t;
+    static constexpr StateId no_state = std::numeric_limits<StateId>::max();
+
+    enum class ActionKind : std::uint32_t { Error = 0, Shift = 1, Reduce = 2, Accept = 3 };
+    struct Action {
+        ActionKind kind = ActionKind::Error;
+        // target state of a shift, or production of a reduction
+        std::uint32_t value = 0;
+        bool operator==(const Action &) const = default;
+    };
+
+    struct Conflicts {
+        std::size_t shift_reduce = 0;
+        std::size_t reduce_reduce = 0;
+    };
+
+    LRTable() = default;
+    LRTable(SymbolTable symbols, std::size_t num_states);
+
+    Action get_action(StateId state, SymbolId terminal) const noexcept
+    {
+        if (terminal >= column_of.size() || column_of[terminal] == SymbolTable::no_index)
+            return {};
+        const auto cell = actions[static_cast<std::size_t>(state) * num_terminals() +
+                                  column_of[terminal]];
+        return {static_cast<ActionKind>(cell >> value_bits), cell & value_mask};
+    }
+    StateId get_goto(StateId state, SymbolId nonterminal) const noexcept
+    {
+        if (nonterminal >= row_of.size() || row_of[nonterminal] == SymbolTable::no_index)
+            return no_state;
+        return gotos[static_cast<std::size_t>(state) * num_nonterminals() + row_of[nonterminal]];
+    }
+
+    void set_action(StateId state, SymbolId terminal, Action action);
+    void set_goto(StateId state, SymbolId nonterminal, StateId target);
+
+    ProductionIndex add_production(SymbolId LHS, std::span<const SymbolId> RHS);
+    SymbolId get_LHS(ProductionIndex production) const { return production_LHS[production]; }
+    std::span<const SymbolId> get_RHS(ProductionIndex production) const
+    {
+        return std::span{RHS_symbols}.subspan(RHS_offsets[production],
+                                              RHS_offsets[production + 1] -
+                                                  RHS_offsets[production]);
+    }
+
+    const SymbolTable &get_symbol_table() const { return symbols; }
+    std::size_t num_states() const { return states; }
+    std::size_t num_terminals() const { return symbols.num_terminals(); }
+    std::size_t num_nonterminals() const { return symbols.num_nonterminals(); }
+    std::size_t num_productions() const { return production_LHS.size(); }
+
+    // conflicts that were resolved while filling the table, shifts win over reductions and
+    // earlier productions over later ones
+    Conflicts conflicts;
+
+  private:
+    static constexpr unsigned value_bits = 30;
+    static constexpr std::uint32_t value_mask = (std::uint32_t{1} << value_bits) - 1;
+
+    SymbolTable symbols;
+    std::size_t states = 0;
+    std::vector<std::uint32_t> row_of;
+    std::vector<std::uint32_t> column_of;
+    std::vector<std::uint32_t> actions;
+    std::vector<StateId> gotos;
+
+    std::vector<SymbolId> production_LHS;
+    std::vector<std::uint32_t> RHS_offsets{0};
+    std::vector<SymbolId> RHS_symbols;
+};
+
+#endif // LR_TABLE_H_
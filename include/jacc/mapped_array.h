@@ -0,0 +1,55 @@
+#ifndef MAPPED_ARRAY_H_
+#define MAPPED_ARRAY_H_
+
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * An array that either owns its elements or views elements that something else keeps alive,
+ * like the mapping of a CompiledGrammar. Reading works the same either way. A copy of a view
+ * views the same elements, and the first edit() of a view copies them into a vector of its own.
+ */
+template <typename T> class MappedArray
+{
+  public:
+    MappedArray() = default;
+    MappedArray(std::vector<T> elements) : owned(std::move(elements)) {}
+
+    static MappedArray view(std::span<const T> elements)
+    {
+        MappedArray array;
+        array.viewed = elements.data();
+        array.viewed_size = elements.size();
+        return array;
+    }
+
+    const T &operator[](std::size_t i) const { return data()[i]; }
+    const T *data() const { return viewed ? viewed : owned.data(); }
+    std::size_t size() const { return viewed ? viewed_size : owned.size(); }
+    bool empty() const { return size() == 0; }
+    const T *begin() const { return data(); }
+    const T *end() const { return data() + size(); }
+
+    /**
+     * The elements to change, copied out of the view first if this is one.
+     */
+    std::vector<T> &edit()
+    {
+        if (viewed) {
+            owned.assign(viewed, viewed + viewed_size);
+            viewed = nullptr;
+            viewed_size = 0;
+        }
+        return owned;
+    }
+    bool is_view() const { return viewed != nullptr; }
+
+  private:
+    std::vector<T> owned;
+    const T *viewed = nullptr;
+    std::size_t viewed_size = 0;
+};
+
+#endif // MAPPED_ARRAY_H_
@@ -0,0 +1,29 @@
+#ifndef PARSE_BATCH_H_
+#define PARSE_BATCH_H_
+
+#include <jacc/symbol_table.h>
+#include <jacc/table_driven_ll_parser.h>
+
+#include <span>
+#include <vector>
+
+struct BatchResult {
+    bool accepted = false;
+    // LLParser::get_errors() of a rejected input, empty for accepted ones
+    std::vector<LLParser::ParseError> errors;
+};
+
+/**
+ * Parses independent token streams on up to threads threads, 0 means one per core, and returns
+ * their results in input order.
+ *
+ * Every worker parses with its own copy of parser, so they all share its table and recovery
+ * settings, but not its syntax tree or trace sink. The inputs are split evenly between the
+ * workers up front. A worker that has finished its share steals the back half of the largest
+ * share that is left, so a few long inputs don't keep the other threads idle.
+ */
+std::vector<BatchResult> parse_batch(const LLParser &parser,
+                                     std::span<const std::vector<SymbolId>> inputs,
+                                     unsigned threads = 0);
+
+#endif // PARSE_BATCH_H_
@@ -0,0 +1,87 @@
+#ifndef PERFECT_HASH_H_
+#define PERFECT_HASH_H_
+
+#include <jacc/mapped_array.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * A minimal perfect hash over a fixed set of distinct keys, built with hash and displace (CHD):
+ * keys are spread over buckets of about four keys by one half of their hash, then buckets are
+ * placed largest first, each with the first displacement that sends all of its keys to free
+ * slots. Every key gets its own slot in [0, size()).
+ *
+ * Any other string maps to some slot as well, so callers keep the key of every slot and compare
+ * against it: one hash and one string compare per lookup. The emitted parsers compute the same
+ * hash, keep hash() in sync with ll_parser_emitter.cpp.
+ */
+class PerfectHash
+{
+  public:
+    static constexpr std::uint32_t no_slot = std::numeric_limits<std::uint32_t>::max();
+
+    PerfectHash() = default;
+    /**
+     * The slot of keys[i] is not i, use slot() to find it.
+     */
+    explicit PerfectHash(std::span<const std::string_view> keys);
+    /**
+     * The hash that was built with this seed, size and displacements before.
+     */
+    PerfectHash(std::uint32_t seed, std::size_t size, MappedArray<std::uint32_t> displacements)
+        : seed(seed), num_slots(size), displacements(std::move(displacements))
+    {
+    }
+
+    std::uint32_t slot(std::string_view key) const noexcept
+    {
+        if (displacements.empty())
+            return no_slot;
+        const auto h = hash(key, seed);
+        const auto bucket = reduce(static_cast<std::uint32_t>(h >> 32), displacements.size());
+        return reduce(mix(static_cast<std::uint32_t>(h) ^ displacements[bucket]), num_slots);
+    }
+
+    /**
+     * FNV-1a with a final avalanche, so both halves are usable.
+     */
+    static std::uint64_t hash(std::string_view key, std::uint32_t seed) noexcept
+    {
+        std::uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+        for (unsigned char c : key)
+            h = (h ^ c) * 0x100000001b3ULL;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        return h ^ (h >> 33);
+    }
+    static std::uint32_t mix(std::uint32_t x) noexcept
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        return x ^ (x >> 16);
+    }
+    // maps x to [0, n) with a multiply instead of a division
+    static std::uint32_t reduce(std::uint32_t x, std::size_t n) noexcept
+    {
+        return static_cast<std::uint32_t>((std::uint64_t{x} * n) >> 32);
+    }
+
+    std::size_t size() const { return num_slots; }
+    std::uint32_t get_seed() const { return seed; }
+    std::span<const std::uint32_t> get_displacements() const { return displacements; }
+
+  private:
+    std::uint32_t seed = 0;
+    std::size_t num_slots = 0;
+    MappedArray<std::uint32_t> displacements;
+};
+
+#endif // PERFECT_HASH_H_
@@ -0,0 +1,58 @@
+#ifndef PRODUCTION_SYMBOL_H_
+#define PRODUCTION_SYMBOL_H_
+
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "fmt/format.h"
+#include "fmt/base.h"
+
+class ProductionSymbol
+{
+  public:
+    enum class Kind { Uninitialized, NonTerminal, Terminal, EndOfInput };
+    ProductionSymbol(std::optional<std::string> symbol, Kind kind)
+        : kind(kind), raw_symbol(std::move(symbol))
+    {
+    }
+
+    ProductionSymbol() : kind(Kind::Uninitialized) {}
+
+    bool is_terminal() const { return kind == Kind::Terminal; }
+    bool is_nonTerminal() const { return kind == Kind::NonTerminal; }
+    bool is_initialized() const { return kind != Kind::Uninitialized; }
+    bool is_epsilon() const { return !raw_symbol.has_value(); }
+    bool is_EOI() const { return kind == Kind::EndOfInput; }
+    const std::optional<std::string>& get_raw_symbol() const {
+      return raw_symbol;
+    }
+
+    static ProductionSymbol create_epsilon();
+    static ProductionSymbol create_EOI();
+
+    bool operator<(const ProductionSymbol &other) const
+    {
+        return this->raw_symbol < other.raw_symbol;
+    }
+    bool operator==(const ProductionSymbol &other) const
+    {
+        return this->raw_symbol == other.raw_symbol && this->kind == other.kind;
+    }
+    bool operator!=(const ProductionSymbol &other) const { return !(*this == other); }
+
+  private:
+    Kind kind;
+    std::optional<std::string> raw_symbol;
+    friend struct fmt::formatter<ProductionSymbol>;
+};
+
+template <> struct fmt::formatter<ProductionSymbol> {
+    constexpr auto parse(format_parse_context &ctx) { return ctx.end(); }
+    template <typename FormatContext>
+    auto format(const ProductionSymbol & ps, FormatContext& ctx) const {
+        return fmt::format_to(ctx.out(), "{}", ps.raw_symbol.value_or("epsilon"));
+    }
+};
+
+#endif // PRODUCTION_SYMBOL_H_
@@ -0,0 +1,83 @@
+#ifndef SEMANTIC_ACTIONS_H_
+#define SEMANTIC_ACTIONS_H_
+
+#include <jacc/grammar.h>
+#include <jacc/ll_table.h>
+#include <jacc/symbol_table.h>
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+/**
+ * Semantic actions for LLParser that compute a Value per node, bison style.
+ *
+ * Actions are registered per production and kept in a table indexed by production, each entry a
+ * plain function pointer. Every matched token pushes the value of its token action, and every
+ * completed production replaces the values of its RHS with the result of its action. Productions
+ * without an action pass on the value of their first child.
+ *
+ * Context is handed to every action, it's where the actions find the input and can keep state.
+ * The table the actions were registered against has to outlive them.
+ */
+template <typename Value, typename Context> class SemanticActions
+{
+  public:
+    using Action = Value (*)(Context &context, std::span<Value> children);
+    using TokenAction = Value (*)(Context &context, SymbolId token, std::size_t position);
+
+    SemanticActions(const LLTable &table, Context &context)
+        : table(&table), context(&context), actions(table.num_productions(), nullptr)
+    {
+    }
+
+    void on(LLTable::ProductionIndex production, Action action) { actions[production] = action; }
+    /**
+     * Registers an action for LHS → RHS. Returns false if the table has no such production.
+     */
+    bool on(const ProductionSymbol &LHS, const std::vector<ProductionSymbol> &RHS, Action action)
+    {
+        const auto &symbols = table->get_symbol_table();
+        std::vector<SymbolId> ids;
+        for (const auto &symbol : RHS)
+            ids.push_back(symbols.find(symbol));
+        const auto production = table->find_production(symbols.find(LHS), ids);
+        if (production == LLTable::no_production)
+            return false;
+        on(production, action);
+        return true;
+    }
+    void on_token(TokenAction action) { token_action = action; }
+
+    void shift(SymbolId token, std::size_t position)
+    {
+        values.push_back(token_action ? token_action(*context, token, position) : Value{});
+    }
+    void reduce(LLTable::ProductionIndex production)
+    {
+        const auto arity = table->get_RHS(production).size();
+        const auto children = std::span{values}.last(arity);
+        Value result{};
+        if (actions[production])
+            result = actions[production](*context, children);
+        else if (!children.empty())
+            result = std::move(children.front());
+        values.resize(values.size() - arity);
+        values.push_back(std::move(result));
+    }
+
+    /**
+     * Value of the start symbol after a successful parse.
+     */
+    Value &result() { return values.back(); }
+    void clear() { values.clear(); }
+
+  private:
+    const LLTable *table;
+    Context *context;
+    std::vector<Action> actions;
+    TokenAction token_action = nullptr;
+    std::vector<Value> values;
+};
+
+#endif // SEMANTIC_ACTIONS_H_
@@ -0,0 +1,129 @@
+#ifndef SYMBOL_TABLE_H_
+#define SYMBOL_TABLE_H_
+
+#include <jacc/mapped_array.h>
+#include <jacc/production_symbol.h>
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using SymbolId = std::uint32_t;
+
+/**
+ * Interns every symbol of a grammar once and hands out compact integer ids.
+ *
+ * Ids are assigned in order of first appearance, with epsilon and the end of input marker
+ * reserved up front. On top of the global id, terminals (including $) and nonterminals each get
+ * a dense index of their own, so sets over terminals can be bitsets and tables can be indexed
+ * [nonterminal][terminal] directly.
+ *
+ * A table that CompiledGrammar maps from a file answers everything but get_symbol() and find()
+ * straight from the mapping. Those two build the symbols and the lookup the first time they are
+ * called.
+ */
+class SymbolTable
+{
+  public:
+    static constexpr SymbolId epsilon_id = 0;
+    static constexpr SymbolId eoi_id = 1;
+    static constexpr SymbolId invalid_id = std::numeric_limits<SymbolId>::max();
+    static constexpr std::uint32_t no_index = std::numeric_limits<std::uint32_t>::max();
+
+    SymbolTable();
+
+    /**
+     * A mapped table is copied into one of its own first.
+     */
+    SymbolId intern(const ProductionSymbol &symbol);
+    /**
+     * Only copies name the first time it is seen, looking up a known name doesn't allocate.
+     */
+    SymbolId intern(std::string_view name, ProductionSymbol::Kind kind);
+
+    /**
+     * Returns the id of an already interned symbol, or invalid_id if it is unknown.
+     */
+    SymbolId find(const ProductionSymbol &symbol) const;
+    SymbolId find(std::string_view name, ProductionSymbol::Kind kind) const;
+
+    const ProductionSymbol &get_symbol(SymbolId id) const
+    {
+        return mapped ? intern_mapped().symbols[id] : symbols[id];
+    }
+    /**
+     * The raw symbol of id without going through get_symbol(), empty for ε.
+     */
+    std::string_view name(SymbolId id) const;
+
+    bool is_epsilon(SymbolId id) const { return id == epsilon_id; }
+    bool is_terminal(SymbolId id) const
+    {
+        return id != epsilon_id && kinds[id] != nonterminal_kind;
+    }
+    bool is_nonterminal(SymbolId id) const { return kinds[id] == nonterminal_kind; }
+
+    std::uint32_t terminal_index(SymbolId id) const
+    {
+        return is_terminal(id) ? dense_indices[id] : no_index;
+    }
+    std::uint32_t nonterminal_index(SymbolId id) const
+    {
+        return is_nonterminal(id) ? dense_indices[id] : no_index;
+    }
+    SymbolId terminal_at(std::uint32_t index) const { return terminal_ids[index]; }
+    SymbolId nonterminal_at(std::uint32_t index) const { return nonterminal_ids[index]; }
+
+    std::span<const SymbolId> get_terminals() const { return terminal_ids; }
+    std::span<const SymbolId> get_nonterminals() const { return nonterminal_ids; }
+
+    std::size_t size() const { return kinds.size(); }
+    std::size_t num_terminals() const { return terminal_ids.size(); }
+    std::size_t num_nonterminals() const { return nonterminal_ids.size(); }
+
+  private:
+    // lets the lookups take a string_view without building a std::string first
+    struct NameHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view name) const
+        {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+    using Lookup = std::unordered_map<std::string, SymbolId, NameHash, std::equal_to<>>;
+    // the names of a mapped table, and its symbols and lookups once they are built. Copies of
+    // the table share them
+    struct Mapped {
+        std::span<const std::uint32_t> name_offsets;
+        std::span<const char> names;
+        std::once_flag interned;
+        std::vector<ProductionSymbol> symbols;
+        Lookup terminal_lookup;
+        Lookup nonterminal_lookup;
+    };
+    friend class CompiledGrammar;
+    static constexpr auto nonterminal_kind =
+        static_cast<std::uint8_t>(ProductionSymbol::Kind::NonTerminal);
+
+    const Mapped &intern_mapped() const;
+
+    // ProductionSymbol::Kind of every symbol
+    MappedArray<std::uint8_t> kinds;
+    MappedArray<std::uint32_t> dense_indices;
+    MappedArray<SymbolId> terminal_ids;
+    MappedArray<SymbolId> nonterminal_ids;
+    // empty for a mapped table
+    std::vector<ProductionSymbol> symbols;
+    Lookup terminal_lookup;
+    Lookup nonterminal_lookup;
+    std::shared_ptr<Mapped> mapped;
+};
+
+#endif // SYMBOL_TABLE_H_
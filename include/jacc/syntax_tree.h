@@ -0,0 +1,230 @@
+#ifndef SYNTAX_TREE_H_
+#define SYNTAX_TREE_H_
+
+#include <jacc/symbol_table.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A concrete syntax tree whose nodes live in an arena.
+ *
+ * Nodes are allocated from chunks of 2^16 nodes that never move, and refer to each other with
+ * 32 bit indices instead of pointers. A tree of a million nodes is a handful of allocations, and
+ * clear() forgets all nodes in O(1) while keeping the chunks around for the next parse.
+ *
+ * The LL parser adds the children of a node all at once when it expands it, so siblings are
+ * adjacent in memory, except for the links of a list and nodes LLParser::reparse() moved.
+ *
+ * A node expanded with a tail recursive production X : α X; is a list. Rather than nesting one
+ * X in the next, the whole chain of expansions is stored flat: the children of the list are its
+ * links, one node of symbol X per production in the chain, each with the children of that
+ * production minus the tail X. The last link is the production that ends the chain. So a list
+ * of a million elements is as shallow as a list of one, and a list is a single node wherever the
+ * tree is walked.
+ *
+ * Every node knows how many tokens it spans, but not where they start. So LLParser::reparse()
+ * can reuse the subtrees after an edit as they are, even when the edit moved them. Nodes it
+ * replaces are freed, merged with free neighbours and handed out again by later allocations.
+ */
+class SyntaxTree
+{
+  public:
+    using NodeId = std::uint32_t;
+    static constexpr NodeId no_node = std::numeric_limits<NodeId>::max();
+
+    struct Node {
+        SymbolId symbol;
+        NodeId parent = no_node;
+        NodeId first_child = no_node;
+        NodeId next_sibling = no_node;
+        // the position of the token in the input for terminals, the production a nonterminal
+        // was expanded with otherwise. After a reparse() terminals that were reused keep the
+        // position they were parsed at, see start()
+        std::uint32_t value = 0;
+        // number of tokens, a nonterminal gets it once its whole production was matched
+        std::uint32_t length = 0;
+    };
+
+    /**
+     * A link of a list, index counts the links in front of it and start is its first token
+     * relative to the start of the list.
+     */
+    struct Link {
+        std::size_t index;
+        NodeId id;
+        std::size_t start;
+    };
+
+    SyntaxTree() = default;
+    SyntaxTree(SyntaxTree &&) = default;
+    SyntaxTree &operator=(SyntaxTree &&) = default;
+
+    /**
+     * Forgets every node, the root included. Allocated chunks are reused.
+     */
+    void clear();
+    /**
+     * Like clear(), but also gives the memory back.
+     */
+    void release();
+
+    NodeId add_root(SymbolId symbol);
+    /**
+     * Adds a node without parent and keeps all others, unlike add_root().
+     */
+    NodeId add_node(SymbolId symbol);
+    /**
+     * Adds one child per symbol to parent, in order. Returns the id of the first one, the others
+     * follow consecutively.
+     */
+    NodeId add_children(NodeId parent, std::span<const SymbolId> symbols);
+    /**
+     * Adds a link to list after previous, or as its first one if previous is no_node. The link
+     * gets the symbol of the list.
+     */
+    NodeId add_link(NodeId list, NodeId previous);
+
+    /**
+     * Gives the nodes of the sibling chain from first up to last, not included, and everything
+     * below them back to the arena. The nodes in kept, sorted, were moved elsewhere: they and
+     * what is below them stay.
+     */
+    void free_siblings(NodeId first, NodeId last, std::span<const NodeId> kept = {});
+    /**
+     * Moves node into the place of placeholder, which has no children, and frees placeholder.
+     */
+    void splice(NodeId placeholder, NodeId node);
+    /**
+     * Gives id the production, children and length of with, and frees with.
+     */
+    void replace(NodeId id, NodeId with);
+
+    /**
+     * A list can't start with its own symbol, as X : X α; is left recursive.
+     */
+    bool is_list(NodeId id) const
+    {
+        const auto &node = (*this)[id];
+        return node.first_child != no_node && (*this)[node.first_child].symbol == node.symbol;
+    }
+    bool is_link(NodeId id) const
+    {
+        return (*this)[id].parent != no_node && is_list((*this)[id].parent);
+    }
+    /**
+     * The link of list whose tokens include the one offset tokens into it, or one with id
+     * no_node if the list is shorter. The first call for a list indexes the lengths of its links,
+     * from then on this takes time logarithmic in their number.
+     */
+    Link find_link(NodeId list, std::size_t offset);
+    /**
+     * Updates the index of list after the link at index changed its length to length.
+     */
+    void resize_link(NodeId list, std::size_t index, std::uint32_t length);
+    /**
+     * Replaces the links [first, last) of an indexed list by the chain of new links starting at
+     * links, with last past the end for all remaining links. The links replaced are unlinked but
+     * not freed.
+     */
+    void replace_links(NodeId list, std::size_t first, std::size_t last, NodeId links);
+
+    NodeId root() const { return num_nodes > 0 ? 0 : no_node; }
+    /**
+     * Number of nodes in the tree, and number of nodes taken from the arena including the freed
+     * ones.
+     */
+    std::size_t size() const { return num_nodes - num_free; }
+    std::size_t num_allocated() const { return num_nodes; }
+
+    Node &operator[](NodeId id) { return chunks[id >> chunk_bits][id & chunk_mask]; }
+    const Node &operator[](NodeId id) const { return chunks[id >> chunk_bits][id & chunk_mask]; }
+
+    /**
+     * Position of the first token of a node, from the lengths of everything before it. Takes
+     * time in the depth of the node and the number of siblings before it and its ancestors.
+     */
+    std::size_t start(NodeId id) const;
+
+    template <typename Function> void for_each_child(NodeId id, Function &&f) const
+    {
+        for (auto child = (*this)[id].first_child; child != no_node;
+             child = (*this)[child].next_sibling)
+            f(child);
+    }
+
+  private:
+    static constexpr unsigned chunk_bits = 16;
+    static constexpr std::size_t chunk_size = std::size_t{1} << chunk_bits;
+    static constexpr NodeId chunk_mask = chunk_size - 1;
+
+    /**
+     * The lengths of the links of a list in an implicit treap, ordered like the links and
+     * summed up in every subtree.
+     */
+    class ListIndex
+    {
+      public:
+        ListIndex(const SyntaxTree &tree, NodeId list);
+
+        std::size_t size() const { return count(root); }
+        Link find(std::size_t offset) const;
+        NodeId at(std::size_t index) const;
+        void resize(std::size_t index, std::uint32_t length);
+        void replace(std::size_t first, std::size_t last, const SyntaxTree &tree, NodeId links);
+
+      private:
+        static constexpr std::uint32_t no_entry = std::numeric_limits<std::uint32_t>::max();
+        struct Entry {
+            NodeId link;
+            std::uint32_t length;
+            std::uint32_t priority;
+            std::uint32_t count;
+            std::uint64_t sum;
+            std::uint32_t left;
+            std::uint32_t right;
+        };
+
+        std::uint32_t count(std::uint32_t entry) const
+        {
+            return entry == no_entry ? 0 : entries[entry].count;
+        }
+        std::uint64_t sum(std::uint32_t entry) const
+        {
+            return entry == no_entry ? 0 : entries[entry].sum;
+        }
+        void update(std::uint32_t entry);
+        std::uint32_t build(const SyntaxTree &tree, NodeId links);
+        std::uint32_t merge(std::uint32_t left, std::uint32_t right);
+        void split(std::uint32_t entry, std::size_t index, std::uint32_t &left,
+                   std::uint32_t &right);
+        void resize(std::uint32_t entry, std::size_t index, std::uint32_t length);
+
+        std::vector<Entry> entries;
+        std::vector<std::uint32_t> unused;
+        std::uint32_t root = no_entry;
+        std::uint32_t seed = 0x9e3779b9;
+    };
+
+    NodeId allocate(std::size_t count);
+    void free_run(NodeId first, std::size_t count);
+
+    std::vector<std::unique_ptr<Node[]>> chunks;
+    std::size_t num_nodes = 0;
+    // freed runs of consecutive nodes by their first node and by their length, adjacent runs are
+    // merged so the holes left by moved nodes don't pile up
+    std::map<NodeId, std::size_t> free_runs;
+    std::set<std::pair<std::size_t, NodeId>> free_lengths;
+    std::size_t num_free = 0;
+    // built by find_link(), dropped when the list is freed or replaced
+    std::unordered_map<NodeId, ListIndex> lists;
+};
+
+#endif // SYNTAX_TREE_H_
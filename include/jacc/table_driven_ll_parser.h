@@ -1,30 +1,239 @@
 #ifndef TABLE_DRIVEN_LL_PARSER_H_
 #define TABLE_DRIVEN_LL_PARSER_H_
+#include <jacc/dense_bitset.h>
 #include <jacc/grammar.h>
+#include <jacc/ll_table.h>
+#include <jacc/symbol_table.h>
+#include <jacc/syntax_tree.h>
+#include <jacc/trace.h>
+#include <iterator>
+#include <limits>
 #include <map>
-#include <spdlog/spdlog.h>
-#include <stack>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+class FirstFollowSetGenerator;
 class LLParser
 {
     using ParseTable = std::map<ProductionSymbol, std::map<ProductionSymbol, Production>>;
 
   public:
-    bool parse(std::vector<ProductionSymbol> &input);
-    LLParser(ParseTable table, ProductionSymbol start_symbol)
-        : parse_table(table), context(start_symbol)
+    enum class ErrorType {
+        NOERROR,
+        NOMATCHINGPRODUCTION,
+        TERMINALMISMATCH,
+        TRAILINGINPUT,
+    };
+    struct ParseError {
+        ErrorType type;
+        // index of the offending token in the input
+        std::size_t position;
+        SymbolId token;
+        // the symbol on top of the parse stack, what the parser wanted instead of token
+        SymbolId expected;
+    };
+    /**
+     * None: the parser stops at the first error.
+     * PanicMode: when no production of the nonterminal A on top of the stack matches, input is
+     * skipped until a token that A can start with, or a synchronizing token from FOLLOW(A) on
+     * which A is given up. A terminal that doesn't match is popped as if it had been there.
+     * PhraseLevel: like PanicMode, but a terminal that doesn't match is only treated as missing
+     * when the token fits after it, otherwise the token is deleted instead.
+     */
+    enum class Recovery { None, PanicMode, PhraseLevel };
+    /**
+     * Tokens [position, position + removed) of the last input were replaced by inserted new
+     * ones. between() finds the edit from the tokens before and after, so a text edit only has
+     * to be lexed again.
+     */
+    struct TokenEdit {
+        std::size_t position = 0;
+        std::size_t removed = 0;
+        std::size_t inserted = 0;
+
+        static TokenEdit between(std::span<const SymbolId> before,
+                                 std::span<const SymbolId> after);
+    };
+
+    bool parse(const std::vector<ProductionSymbol> &input);
+    /**
+     * Parses any token source, elements may be SymbolIds or ProductionSymbols. Tokens are fed
+     * one at a time, so a source that reads lazily never has to be buffered.
+     */
+    template <std::input_iterator Iterator, std::sentinel_for<Iterator> Sentinel>
+    bool parse(Iterator first, Sentinel last)
+    {
+        NoActions actions;
+        return parse(first, last, actions);
+    }
+    /**
+     * Parses while calling semantic actions. Actions can be any type with the members
+     *
+     *   void shift(SymbolId token, std::size_t position);
+     *   void reduce(LLTable::ProductionIndex production);
+     *
+     * shift() is called for every matched token except the end of input, reduce() once the whole
+     * RHS of a production was matched, so like in a bottom-up parser children are reduced before
+     * their parents. Both are plain member calls on the template parameter, there is no type
+     * erasure in between. SemanticActions is a ready made implementation with a value stack.
+     */
+    template <std::input_iterator Iterator, std::sentinel_for<Iterator> Sentinel,
+              typename Actions>
+    bool parse(Iterator first, Sentinel last, Actions &actions)
+    {
+        for (; first != last; ++first) {
+            if (!feed(*first, actions))
+                return false;
+        }
+        return finish(actions);
+    }
+    /**
+     * Streaming interface. feed() consumes a single token and returns false as soon as the input
+     * can't be a prefix of a sentence anymore, later tokens are ignored until reset(). finish()
+     * marks the end of the input and returns whether it was accepted. Memory only depends on the
+     * depth of the parse stack, not on the length of the input.
+     *
+     * With recovery on, feed() keeps returning true and the whole input is read, finish() is
+     * false if get_errors() isn't empty.
+     */
+    bool feed(SymbolId token)
+    {
+        NoActions actions;
+        return feed(token, actions);
+    }
+    bool feed(const ProductionSymbol &token) { return feed(find_token(token)); }
+    bool finish()
+    {
+        NoActions actions;
+        return finish(actions);
+    }
+    template <typename Actions> bool feed(SymbolId token, Actions &actions);
+    template <typename Actions> bool feed(const ProductionSymbol &token, Actions &actions)
+    {
+        return feed(find_token(token), actions);
+    }
+    template <typename Actions> bool finish(Actions &actions)
     {
+        // the end of input may already have been fed as a token
+        if (!context.done)
+            feed(SymbolTable::eoi_id, actions);
+        return finished();
     }
+    /**
+     * Parses input, the last input with edit applied, by patching the syntax tree of the last
+     * parse. Parsing starts over at the smallest nonterminal around the edit and is done once it
+     * ends at the same token as before, where the parse stack is the same as last time, or, in a
+     * list, once it gets to a link after the edit that starts at the same token as before. Inside
+     * it, subtrees whose tokens and lookahead weren't edited are reused instead of parsed again.
+     * Lists find the link around the edit through an index of their links, so the time taken
+     * depends on the size of the edit, the nesting around it and the logarithm of the length of
+     * the lists it is in, not on the length of the input.
+     *
+     * Falls back to parsing the whole input if the last parse wasn't accepted or built no tree,
+     * and if the new input is rejected, so errors are reported like by parse(). There are no
+     * semantic actions, reused subtrees couldn't replay them. Replaced nodes are freed, so the
+     * tree doesn't grow from editing back and forth.
+     */
+    bool reparse(std::span<const SymbolId> input, const TokenEdit &edit);
+    /**
+     * Number of tokens matched so far, after an error this is the position of the offending one.
+     */
+    std::size_t tokens_consumed() const { return context.tokens_consumed; }
+    /**
+     * Every error found since the last reset(). Without recovery that is at most one. While
+     * recovering from an error no further errors are reported until a token matched again, so
+     * one mistake doesn't show up as a cascade. Semantic actions are no longer called after the
+     * first error and the syntax tree is left incomplete.
+     */
+    const std::vector<ParseError> &get_errors() const { return context.errors; }
+    /**
+     * Like "3: unexpected ')', expected id".
+     */
+    std::string describe(const ParseError &error) const;
+    /**
+     * Turns on error recovery with FOLLOW sets as synchronizing tokens, either by nonterminal
+     * index of the table's symbol table or taken from the generator the table was built from.
+     * Resets the parser.
+     */
+    void set_recovery(Recovery mode, std::vector<DenseBitset> follow_sets);
+    void set_recovery(Recovery mode, FirstFollowSetGenerator &sets_generator);
+    /**
+     * The parser only works on symbol ids, the input is translated token by token as it is
+     * consumed.
+     *
+     * The table is immutable and shared, a copy of a parser only duplicates the parse state. So
+     * each thread can parse with its own copy of one parser, see parse_batch().
+     */
+    explicit LLParser(LLTable table);
+    explicit LLParser(std::shared_ptr<const LLTable> table);
+    LLParser(const ParseTable &table, ProductionSymbol start_symbol);
     bool done() const { return context.done; }
     void reset() { context.reset(); };
+    const LLTable &get_table() const { return *parse_table; }
+    const std::shared_ptr<const LLTable> &get_shared_table() const { return parse_table; }
+    /**
+     * Sink for structured TraceEvents, only used when built with JACC_TRACE_EVENTS. The parser
+     * doesn't own the sink.
+     */
+    void set_trace_sink(TraceSink *sink) { trace_sink = sink; }
+    /**
+     * Builds the concrete syntax tree of the input into tree while parsing, or stops building
+     * one when tree is null. Resets the parser, and every reset() clears the tree again. The
+     * parser doesn't own the tree.
+     */
+    void set_syntax_tree(SyntaxTree *tree)
+    {
+        context.tree = tree;
+        context.reset();
+    }
 
   private:
+    struct NoActions {
+        void shift(SymbolId, std::size_t) {}
+        void reduce(LLTable::ProductionIndex) {}
+    };
+    /**
+     * What a single call to handle_current_symbol() did. Completed is only reported for
+     * productions that were expanded while completion markers were requested.
+     */
+    struct Step {
+        enum class Kind : std::uint8_t { Expanded, Matched, Completed, Failed };
+        Kind kind;
+        LLTable::ProductionIndex production = LLTable::no_production;
+    };
+    /**
+     * A nonterminal around the edit that reparse() can start over at, link is its index in its
+     * list if it is a link.
+     */
+    struct Enclosing {
+        SyntaxTree::NodeId node;
+        std::size_t start;
+        std::size_t link;
+    };
+    /**
+     * Parsing old_node again into new_node. A link is parsed into a chain of new links of the
+     * same list, until resync, the old link the list goes on with like before.
+     */
+    struct Attempt {
+        SyntaxTree::NodeId old_node;
+        std::size_t start;
+        SyntaxTree::NodeId list = SyntaxTree::no_node;
+        std::size_t list_start = 0;
+        std::size_t link = 0;
+        SyntaxTree::NodeId new_node = SyntaxTree::no_node;
+        // placeholders in the new subtree for the old nodes that are reused
+        std::vector<std::pair<SyntaxTree::NodeId, SyntaxTree::NodeId>> reused;
+        SyntaxTree::Link resync{0, SyntaxTree::no_node, 0};
+    };
+    static constexpr std::size_t no_link = std::numeric_limits<std::size_t>::max();
+    // a production on the parse stack whose RHS is matched once it gets to the top
+    static constexpr SymbolId completion_marker = SymbolId{1} << 31;
+    static constexpr std::size_t initial_stack_capacity = 64;
+
     struct ParseContext {
-        enum class ErrorType {
-            NOERROR,
-            NOMATCHINGPRODUCTION,
-            TERMINALMISMATCH,
-        };
-        std::string parse_error_to_string(ErrorType err)
+        using ErrorType = LLParser::ErrorType;
+        static std::string parse_error_to_string(ErrorType err)
         {
             switch (err) {
             case ErrorType::NOERROR:
@@ -33,29 +242,100 @@ class LLParser
                 return "No matching production";
             case ErrorType::TERMINALMISMATCH:
                 return "Terminal mismatch";
+            case ErrorType::TRAILINGINPUT:
+                return "Expected end of input";
             default:
                 return "what the hell";
             }
         };
-        ParseContext(ProductionSymbol start_symbol) : start_symbol(start_symbol) {};
+        ParseContext(SymbolId start_symbol) : start_symbol(start_symbol)
+        {
+            parse_stack.reserve(initial_stack_capacity);
+            reset();
+        };
         bool done = false;
         ErrorType error = ErrorType::NOERROR;
-        size_t inputIndex = 0;
-        std::stack<ProductionSymbol> parse_stack;
-        ProductionSymbol start_symbol;
+        std::vector<ParseError> errors;
+        // set from an error until the next matched token, errors in between aren't reported
+        bool recovering = false;
+        // a missing terminal was already made up in front of the current token
+        bool inserted = false;
+        size_t tokens_consumed = 0;
+        // push completion markers when expanding, needed for semantic actions and to know the
+        // lengths of tree nodes
+        bool mark_completions = false;
+        // plain vectors that keep their capacity across reset(), so once a parser has seen an
+        // input as deep as the next one parsing doesn't allocate
+        std::vector<SymbolId> parse_stack;
+        SymbolId start_symbol;
+        // tree nodes of the symbols on parse_stack, only kept while building a tree
+        SyntaxTree *tree = nullptr;
+        std::vector<SyntaxTree::NodeId> node_stack;
         void reset()
         {
             done = false;
             error = ErrorType::NOERROR;
-            inputIndex = 0;
-            parse_stack = std::stack<ProductionSymbol>();
+            errors.clear();
+            recovering = false;
+            inserted = false;
+            tokens_consumed = 0;
+            parse_stack.clear();
+            parse_stack.push_back(SymbolTable::eoi_id);
+            parse_stack.push_back(start_symbol);
+            node_stack.clear();
+            if (tree) {
+                node_stack.push_back(SyntaxTree::no_node);
+                node_stack.push_back(tree->add_root(start_symbol));
+            }
         }
     };
-    void handle_current_symbol(const ProductionSymbol &current, const ProductionSymbol &top);
-    void push_production_to_stack(const Production &production);
-    ParseTable parse_table;
+    bool start_token(SymbolId token);
+    bool finished();
+    Step handle_current_symbol(SymbolId current, SymbolId top);
+    void report_error(ErrorType type, SymbolId current, SymbolId top);
+    void recover(SymbolId current);
+    bool accepts(SymbolId top, SymbolId current) const;
+    void pop_symbol();
+    void push_production_to_stack(LLTable::ProductionIndex production);
+    bool reparse_subtree(std::span<const SymbolId> input, const TokenEdit &edit,
+                         Attempt &attempt);
+    // X : α X; with α not empty, a node expanded with one is a list
+    bool is_tail_recursive(LLTable::ProductionIndex production) const;
+    const SymbolTable &symbols() const { return parse_table->get_symbol_table(); }
+    // terminals go through the perfect hash of the table
+    SymbolId find_token(const ProductionSymbol &token) const
+    {
+        if (token.is_terminal() && token.get_raw_symbol())
+            return parse_table->find_terminal(*token.get_raw_symbol());
+        return symbols().find(token);
+    }
+    std::shared_ptr<const LLTable> parse_table;
     ParseContext context;
-    ProductionSymbol eoi_symbol = ProductionSymbol::create_EOI();
+    Recovery recovery = Recovery::None;
+    // FOLLOW(A) by nonterminal index, as terminal indices, shared between copies like the table
+    std::shared_ptr<const std::vector<DenseBitset>> sync_sets;
+    TraceSink *trace_sink = nullptr;
 };
 
+template <typename Actions> bool LLParser::feed(SymbolId token, Actions &actions)
+{
+    if (!start_token(token))
+        return context.error == ParseContext::ErrorType::NOERROR;
+    context.mark_completions = !std::is_same_v<Actions, NoActions> || context.tree;
+    const auto position = context.tokens_consumed;
+    while (context.tokens_consumed == position &&
+           context.error == ParseContext::ErrorType::NOERROR) {
+        const auto step = handle_current_symbol(token, context.parse_stack.back());
+        if (step.kind == Step::Kind::Failed && recovery != Recovery::None)
+            recover(token);
+        else if (!context.errors.empty())
+            continue;
+        else if (step.kind == Step::Kind::Matched && token != SymbolTable::eoi_id)
+            actions.shift(token, position);
+        else if (step.kind == Step::Kind::Completed)
+            actions.reduce(step.production);
+    }
+    return context.error == ParseContext::ErrorType::NOERROR;
+}
+
 #endif // TABLE_DRIVEN_LL_PARSER_H_
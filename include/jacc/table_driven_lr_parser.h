@@ -0,0 +1,75 @@
+#ifndef TABLE_DRIVEN_LR_PARSER_H_
+#define TABLE_DRIVEN_LR_PARSER_H_
+#include <jacc/grammar.h>
+#include <jacc/lr_table.h>
+#include <jacc/symbol_table.h>
+#include <jacc/trace.h>
+#include <iterator>
+#include <vector>
+class LRParser
+{
+  public:
+    bool parse(const std::vector<ProductionSymbol> &input);
+    /**
+     * Same token source and streaming interface as LLParser.
+     */
+    template <std::input_iterator Iterator, std::sentinel_for<Iterator> Sentinel>
+    bool parse(Iterator first, Sentinel last)
+    {
+        for (; first != last; ++first) {
+            if (!feed(*first))
+                return false;
+        }
+        return finish();
+    }
+    bool feed(SymbolId token);
+    bool feed(const ProductionSymbol &token) { return feed(symbols().find(token)); }
+    bool finish();
+    std::size_t tokens_consumed() const { return context.tokens_consumed; }
+    explicit LRParser(LRTable table) : parse_table(std::move(table)) {}
+    bool done() const { return context.done; }
+    void reset() { context.reset(); };
+    void set_trace_sink(TraceSink *sink) { trace_sink = sink; }
+
+  private:
+    struct ParseContext {
+        enum class ErrorType {
+            NOERROR,
+            NOACTION,
+            TRAILINGINPUT,
+        };
+        std::string parse_error_to_string(ErrorType err)
+        {
+            switch (err) {
+            case ErrorType::NOERROR:
+                return "No Error";
+            case ErrorType::NOACTION:
+                return "No action for input";
+            case ErrorType::TRAILINGINPUT:
+                return "Input after end of input";
+            default:
+                return "what the hell";
+            }
+        };
+        ParseContext() { reset(); }
+        bool done = false;
+        ErrorType error = ErrorType::NOERROR;
+        size_t tokens_consumed = 0;
+        std::vector<LRTable::StateId> state_stack;
+        void reset()
+        {
+            done = false;
+            error = ErrorType::NOERROR;
+            tokens_consumed = 0;
+            state_stack.clear();
+            state_stack.push_back(0);
+        }
+    };
+    void handle_current_symbol(SymbolId current);
+    const SymbolTable &symbols() const { return parse_table.get_symbol_table(); }
+    LRTable parse_table;
+    ParseContext context;
+    TraceSink *trace_sink = nullptr;
+};
+
+#endif // TABLE_DRIVEN_LR_PARSER_H_
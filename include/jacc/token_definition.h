@@ -0,0 +1,24 @@
+#ifndef TOKEN_DEFINITION_H_
+#define TOKEN_DEFINITION_H_
+
+#include <string>
+
+/**
+ * A terminal defined by a regular expression, written as
+ *
+ *   id : /[a-z_][a-z0-9_]+/;
+ *
+ * in a grammar file. Input matched by a definition named _ is skipped, use it for whitespace
+ * and comments.
+ */
+struct TokenDefinition {
+    std::string name;
+    std::string pattern;
+
+    bool is_skipped() const { return name == skip_name; }
+    static constexpr auto skip_name = "_";
+
+    bool operator==(const TokenDefinition &) const = default;
+};
+
+#endif // TOKEN_DEFINITION_H_
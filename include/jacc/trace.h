@@ -0,0 +1,66 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <jacc/symbol_table.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <spdlog/spdlog.h>
+
+/**
+ * Logging on hot paths goes through these macros instead of spdlog::debug and friends. Calls
+ * below SPDLOG_ACTIVE_LEVEL are removed by the preprocessor, arguments included, so a release
+ * build never formats a stack or a set just to throw the result away. The level is chosen with
+ * the JACC_LOG_LEVEL cmake option.
+ */
+#define JACC_TRACE(...) SPDLOG_TRACE(__VA_ARGS__)
+#define JACC_DEBUG(...) SPDLOG_DEBUG(__VA_ARGS__)
+
+/**
+ * A single step of a table-driven parser, in terms of symbol ids instead of formatted text.
+ */
+struct TraceEvent {
+    enum class Kind : std::uint8_t {
+        // LL: a nonterminal was replaced by a production
+        Expand,
+        // LL: a terminal on the stack matched the input
+        Match,
+        // LR: the input was shifted, value is the new state
+        Shift,
+        // value is the production that was reduced by. LL parsers report a production once its
+        // RHS is matched, but only while semantic actions are used
+        Reduce,
+        Accept,
+        Error,
+    };
+    Kind kind;
+    // the current input token
+    SymbolId token;
+    std::uint32_t value;
+    // number of tokens consumed before this step
+    std::size_t position;
+};
+
+/**
+ * Receives TraceEvents from a parser, see set_trace_sink() of LLParser and LRParser. Events are
+ * only emitted when jacc is built with JACC_TRACE_EVENTS, otherwise the sink is never called and
+ * the parsers don't even check for it.
+ */
+class TraceSink
+{
+  public:
+    virtual ~TraceSink() = default;
+    virtual void on_event(const TraceEvent &event) = 0;
+};
+
+#ifdef JACC_ENABLE_TRACE_EVENTS
+#define JACC_TRACE_EVENT(sink, ...)                                                               \
+    do {                                                                                           \
+        if (sink)                                                                                  \
+            (sink)->on_event(TraceEvent{__VA_ARGS__});                                             \
+    } while (false)
+#else
+#define JACC_TRACE_EVENT(sink, ...) ((void)0)
+#endif
+
+#endif // TRACE_H_
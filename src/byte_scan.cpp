@@ -0,0 +1,119 @@
+#include <jacc/byte_scan.h>
+
+#include <bit>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JACC_X86 1
+#endif
+
+namespace
+{
+std::size_t scan_scalar(const ByteSet &set, std::string_view input, std::size_t from)
+{
+    while (from < input.size() && set.contains(static_cast<unsigned char>(input[from])))
+        from++;
+    return from;
+}
+
+#ifdef JACC_X86
+__attribute__((target("ssse3"))) std::size_t scan_ssse3(const ByteSet &set,
+                                                         std::string_view input, std::size_t from)
+{
+    const auto low_table = _mm_load_si128(reinterpret_cast<const __m128i *>(set.low.data()));
+    const auto high_table = _mm_load_si128(reinterpret_cast<const __m128i *>(set.high.data()));
+    const auto bit_of = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const auto nibble = _mm_set1_epi8(0x0f);
+    const auto seven = _mm_set1_epi8(7);
+    for (; from + 16 <= input.size(); from += 16) {
+        const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input.data() + from));
+        const auto low = _mm_and_si128(bytes, nibble);
+        const auto high = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+        const auto upper = _mm_cmpgt_epi8(low, seven);
+        const auto row = _mm_or_si128(_mm_and_si128(upper, _mm_shuffle_epi8(high_table, high)),
+                                      _mm_andnot_si128(upper, _mm_shuffle_epi8(low_table, high)));
+        const auto bit = _mm_shuffle_epi8(bit_of, low);
+        const auto in_set = _mm_cmpeq_epi8(_mm_and_si128(row, bit), bit);
+        const auto outside = ~static_cast<unsigned>(_mm_movemask_epi8(in_set)) & 0xffffu;
+        if (outside != 0)
+            return from + static_cast<std::size_t>(std::countr_zero(outside));
+    }
+    return scan_scalar(set, input, from);
+}
+
+__attribute__((target("avx2"))) std::size_t scan_avx2(const ByteSet &set, std::string_view input,
+                                                       std::size_t from)
+{
+    // vpshufb looks up within each 128 bit lane, so both lanes get the whole table
+    const auto low_table = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i *>(set.low.data())));
+    const auto high_table = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i *>(set.high.data())));
+    const auto bit_of = _mm256_broadcastsi128_si256(
+        _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128));
+    const auto nibble = _mm256_set1_epi8(0x0f);
+    const auto seven = _mm256_set1_epi8(7);
+    for (; from + 32 <= input.size(); from += 32) {
+        const auto bytes =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input.data() + from));
+        const auto low = _mm256_and_si256(bytes, nibble);
+        const auto high = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble);
+        const auto upper = _mm256_cmpgt_epi8(low, seven);
+        const auto row = _mm256_blendv_epi8(_mm256_shuffle_epi8(low_table, high),
+                                            _mm256_shuffle_epi8(high_table, high), upper);
+        const auto bit = _mm256_shuffle_epi8(bit_of, low);
+        const auto in_set = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit);
+        const auto outside = ~static_cast<std::uint32_t>(_mm256_movemask_epi8(in_set));
+        if (outside != 0)
+            return from + static_cast<std::size_t>(std::countr_zero(outside));
+    }
+    return scan_ssse3(set, input, from);
+}
+#endif
+
+ByteScan detect_byte_scan()
+{
+#ifdef JACC_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return ByteScan::AVX2;
+    if (__builtin_cpu_supports("ssse3"))
+        return ByteScan::SSSE3;
+#endif
+    return ByteScan::Scalar;
+}
+} // namespace
+
+std::size_t ByteSet::size() const
+{
+    std::size_t size = 0;
+    for (std::size_t row = 0; row < 16; row++)
+        size += static_cast<std::size_t>(std::popcount(low[row]) + std::popcount(high[row]));
+    return size;
+}
+
+ByteScan best_byte_scan()
+{
+    static const ByteScan best = detect_byte_scan();
+    return best;
+}
+
+std::size_t find_first_not_in(const ByteSet &set, std::string_view input, std::size_t from)
+{
+    return find_first_not_in(set, input, from, best_byte_scan());
+}
+
+std::size_t find_first_not_in(const ByteSet &set, std::string_view input, std::size_t from,
+                              ByteScan scan)
+{
+    switch (scan) {
+#ifdef JACC_X86
+    case ByteScan::AVX2:
+        return scan_avx2(set, input, from);
+    case ByteScan::SSSE3:
+        return scan_ssse3(set, input, from);
+#endif
+    default:
+        return scan_scalar(set, input, from);
+    }
+}
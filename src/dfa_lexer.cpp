@@ -0,0 +1,67 @@
+#include <jacc/dfa_lexer.h>
+
+LexerTable::LexerTable(std::array<std::uint8_t, 256> byte_classes, std::size_t num_classes,
+                       std::vector<StateId> transitions, std::vector<TokenIndex> accepting)
+    : byte_classes(byte_classes), classes(num_classes), transitions(std::move(transitions)),
+      accepting(std::move(accepting))
+{
+    auto &loop_of_state = loop_of.edit();
+    auto &state_loops = loops.edit();
+    loop_of_state.assign(num_states(), no_loop);
+    for (StateId state = start_state; state < num_states(); state++) {
+        ByteSet loop;
+        for (unsigned byte = 0; byte < 256; byte++) {
+            if (next(state, static_cast<unsigned char>(byte)) == state)
+                loop.insert(static_cast<unsigned char>(byte));
+        }
+        if (loop.size() == 0)
+            continue;
+        loop_of_state[state] = static_cast<std::uint32_t>(state_loops.size());
+        state_loops.push_back(loop);
+    }
+}
+
+LexerTable::LexerTable(std::array<std::uint8_t, 256> byte_classes, std::size_t num_classes,
+                       MappedArray<StateId> transitions, MappedArray<TokenIndex> accepting,
+                       MappedArray<std::uint32_t> loop_of, MappedArray<ByteSet> loops)
+    : byte_classes(byte_classes), classes(num_classes), transitions(std::move(transitions)),
+      accepting(std::move(accepting)), loop_of(std::move(loop_of)), loops(std::move(loops))
+{
+}
+
+bool Scanner::next(Token &token)
+{
+    while (!error && offset < input.size()) {
+        // run the DFA as far as it goes and remember the last accepting state on the way
+        auto state = LexerTable::start_state;
+        auto match = LexerTable::no_token;
+        std::size_t match_end = offset;
+        for (auto i = offset; i < input.size(); i++) {
+            const auto previous = state;
+            state = table->next(state, static_cast<unsigned char>(input[i]));
+            if (state == LexerTable::dead_state)
+                break;
+            // a state that repeats is probably in a long run, skip the rest of it in bulk
+            if (state == previous)
+                i = find_first_not_in(*table->self_loop(state), input, i + 1) - 1;
+            if (const auto accepted = table->accepts(state); accepted != LexerTable::no_token) {
+                match = accepted;
+                match_end = i + 1;
+            }
+        }
+
+        if (match == LexerTable::no_token) {
+            error = true;
+            return false;
+        }
+        const auto start = offset;
+        offset = match_end;
+        const auto symbol = table->token_symbols[match];
+        if (symbol == SymbolTable::epsilon_id)
+            continue;
+        token = {symbol, static_cast<std::uint32_t>(start),
+                 static_cast<std::uint32_t>(match_end - start)};
+        return true;
+    }
+    return false;
+}
@@ -1,19 +1,116 @@
+#include <jacc/byte_scan.h>
 #include <jacc/driver.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 /*
  * Shamelessly "inspired" from GNU Bison example code
  */
 
+namespace
+{
+ByteSet blanks()
+{
+    ByteSet set;
+    for (unsigned char byte : {' ', '\t', '\r', '\n'})
+        set.insert(byte);
+    return set;
+}
+
+// everything a // comment runs over until the end of its line
+ByteSet comment_bytes()
+{
+    ByteSet set;
+    for (unsigned byte = 0; byte < 256; byte++) {
+        if (byte != '\n')
+            set.insert(static_cast<unsigned char>(byte));
+    }
+    return set;
+}
+} // namespace
+
 Driver::Driver() : trace_parsing(false), trace_scanning(false) {}
 
 int Driver::parse(const std::string &f)
 {
     file = f;
+    symbols = SymbolTable();
+    token_definitions.clear();
     location.initialize(&file);
+    map_input();
     scan_begin();
     yy::parser parse(*this);
     parse.set_debug_level(trace_parsing);
     int res = parse();
     scan_end();
+    unmap_input();
     return res;
 }
+
+void Driver::map_input()
+{
+    const int fd = open(file.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0) {
+        spdlog::error("File opening failed! Does it exist?");
+        exit(EXIT_FAILURE);
+    }
+    const auto file_size = static_cast<std::size_t>(status.st_size);
+
+    // Reserve zeroed memory for the file and the two zero bytes, then map the file over the
+    // start of it. Flex writes into the buffer while scanning, a private mapping keeps that from
+    // reaching the file, and only copies the pages that are written to.
+    input_size = file_size + 2;
+    void *memory =
+        mmap(nullptr, input_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED && file_size > 0 &&
+        mmap(memory, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) ==
+            MAP_FAILED) {
+        munmap(memory, input_size);
+        memory = MAP_FAILED;
+    }
+    close(fd);
+    if (memory == MAP_FAILED) {
+        spdlog::error("Could not map {} into memory", file);
+        exit(EXIT_FAILURE);
+    }
+    input = static_cast<char *>(memory);
+}
+
+void Driver::unmap_input()
+{
+    munmap(input, input_size);
+    input = nullptr;
+    input_size = 0;
+}
+
+std::size_t Driver::skip_layout(std::size_t offset)
+{
+    static const ByteSet blank_set = blanks();
+    static const ByteSet comment_set = comment_bytes();
+    const std::string_view text{input, input_size - 2};
+    for (;;) {
+        const auto end = find_first_not_in(blank_set, text, offset);
+        const auto run = text.substr(offset, end - offset);
+        if (const auto lines = std::count(run.begin(), run.end(), '\n'); lines > 0) {
+            location.lines(static_cast<int>(lines));
+            location.columns(static_cast<int>(run.size() - run.rfind('\n') - 1));
+        } else {
+            location.columns(static_cast<int>(run.size()));
+        }
+        offset = end;
+        if (!text.substr(offset).starts_with("//"))
+            break;
+        const auto comment_end = find_first_not_in(comment_set, text, offset + 2);
+        location.columns(static_cast<int>(comment_end - offset));
+        offset = comment_end;
+    }
+    location.step();
+    return offset;
+}
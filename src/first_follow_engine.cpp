@@ -0,0 +1,583 @@
+#include <jacc/first_follow_engine.h>
+#include <jacc/grammar.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+/**
+ * A nonterminal whose equation changed, with every bit it might have lost through that.
+ */
+using Lost = std::pair<std::uint32_t, DenseBitset>;
+
+/**
+ * Delete and rederive for sets that are the union of terminals of their own and the sets of
+ * their predecessors, like FIRST and FOLLOW. Whatever a changed set might have lost is taken out
+ * of it and of every set after it that has it, as that may have come through the changed one.
+ * Every set that lost something is then evaluated again and grows back from its predecessors
+ * like in a full computation. Sets that never had a bit that was taken out keep their value
+ * without being looked at.
+ *
+ * for_each_successor(index, f) calls f for the sets that include the one at index, evaluate(index,
+ * set) merges what the one at index gets from its own productions and predecessors into set.
+ * Returns the indices whose set differs from before, with their value from before.
+ */
+template <class Successors, class Evaluate>
+std::vector<Lost> rederive(std::vector<DenseBitset> &sets, std::vector<Lost> changed,
+                           Successors &&for_each_successor, Evaluate &&evaluate)
+{
+    constexpr auto untouched = SymbolTable::no_index;
+    // every set that was changed keeps its value from before in saved[slot[index]]
+    std::vector<std::uint32_t> slot(sets.size(), untouched);
+    std::vector<Lost> saved;
+    auto touch = [&](std::uint32_t index, const DenseBitset &before) {
+        if (slot[index] != untouched)
+            return;
+        slot[index] = static_cast<std::uint32_t>(saved.size());
+        saved.emplace_back(index, before);
+    };
+
+    std::vector<Lost> deleted;
+    for (auto &[index, lost] : changed) {
+        touch(index, sets[index]);
+        lost.intersect(sets[index]);
+        sets[index].remove(lost);
+        deleted.emplace_back(index, std::move(lost));
+    }
+    while (!deleted.empty()) {
+        auto [source, lost] = std::move(deleted.back());
+        deleted.pop_back();
+        for_each_successor(source, [&](std::uint32_t target) {
+            auto taken = lost;
+            taken.intersect(sets[target]);
+            if (taken.none())
+                return;
+            touch(target, sets[target]);
+            sets[target].remove(taken);
+            deleted.emplace_back(target, std::move(taken));
+        });
+    }
+
+    std::vector<std::uint32_t> worklist;
+    std::vector<bool> queued(sets.size());
+    for (const auto &[index, before] : saved) {
+        evaluate(index, sets[index]);
+        queued[index] = true;
+        worklist.push_back(index);
+    }
+    DenseBitset before;
+    while (!worklist.empty()) {
+        const auto source = worklist.back();
+        worklist.pop_back();
+        queued[source] = false;
+        for_each_successor(source, [&](std::uint32_t target) {
+            before = sets[target];
+            if (!sets[target].merge(sets[source]))
+                return;
+            touch(target, before);
+            if (!queued[target]) {
+                queued[target] = true;
+                worklist.push_back(target);
+            }
+        });
+    }
+    std::erase_if(saved, [&](const Lost &entry) { return sets[entry.first] == entry.second; });
+    return saved;
+}
+} // namespace
+
+FirstFollowEngine::FirstFollowEngine(const Grammar &grammar)
+    : symbols(grammar.get_symbol_table()), nullable(grammar.get_nullable())
+{
+    RHS_offsets.push_back(0);
+    for (const auto &rule : grammar.get_rules()) {
+        const auto LHS = symbols.find(rule.get_LHS());
+        for (const auto &production : rule.get_productions()) {
+            for (const auto &symbol : production.get_production_symbols()) {
+                if (!symbol.is_epsilon())
+                    RHS_symbols.push_back(symbols.find(symbol));
+            }
+            production_LHS.push_back(LHS);
+            RHS_offsets.push_back(static_cast<std::uint32_t>(RHS_symbols.size()));
+        }
+    }
+    removed.assign(production_LHS.size(), false);
+
+    compute_first_sets();
+    compute_follow_sets();
+}
+
+std::span<const SymbolId> FirstFollowEngine::get_production_RHS(std::size_t production) const
+{
+    return std::span{RHS_symbols}.subspan(RHS_offsets[production],
+                                          RHS_offsets[production + 1] - RHS_offsets[production]);
+}
+
+bool FirstFollowEngine::is_nullable(SymbolId symbol) const
+{
+    if (symbols.is_epsilon(symbol))
+        return true;
+    return symbols.is_nonterminal(symbol) && nullable.test(symbols.nonterminal_index(symbol));
+}
+
+const DenseBitset &FirstFollowEngine::first(SymbolId nonterminal) const
+{
+    return first_sets[symbols.nonterminal_index(nonterminal)];
+}
+
+const DenseBitset &FirstFollowEngine::follow(SymbolId nonterminal) const
+{
+    return follow_sets[symbols.nonterminal_index(nonterminal)];
+}
+
+DenseBitset FirstFollowEngine::first(std::span<const SymbolId> sequence,
+                                     bool &sequence_nullable) const
+{
+    DenseBitset result(symbols.num_terminals());
+    sequence_nullable = true;
+    for (auto symbol : sequence) {
+        if (symbols.is_epsilon(symbol))
+            continue;
+        if (symbols.is_terminal(symbol)) {
+            result.set(symbols.terminal_index(symbol));
+            sequence_nullable = false;
+            break;
+        }
+        result.merge(first(symbol));
+        if (!is_nullable(symbol)) {
+            sequence_nullable = false;
+            break;
+        }
+    }
+    return result;
+}
+
+void FirstFollowEngine::compute_first_sets()
+{
+    const auto num_nonterminals = symbols.num_nonterminals();
+    first_sets.assign(num_nonterminals, DenseBitset(symbols.num_terminals()));
+    // dependents[Y] are the nonterminals whose FIRST set includes FIRST(Y)
+    std::vector<std::vector<std::uint32_t>> dependents(num_nonterminals);
+
+    for (std::size_t p = 0; p < num_productions(); p++) {
+        const auto LHS = symbols.nonterminal_index(production_LHS[p]);
+        for (auto symbol : get_production_RHS(p)) {
+            if (symbols.is_terminal(symbol)) {
+                first_sets[LHS].set(symbols.terminal_index(symbol));
+                break;
+            }
+            const auto index = symbols.nonterminal_index(symbol);
+            // left recursion adds nothing to FIRST, so there is no need to follow it
+            if (index != LHS)
+                dependents[index].push_back(LHS);
+            if (!nullable.test(index))
+                break;
+        }
+    }
+    propagate(first_sets, dependents);
+}
+
+/**
+ * For a production A → αBβ, FOLLOW(B) gets FIRST(β), and if β is nullable FOLLOW(B) depends on
+ * FOLLOW(A). The RHS is walked backwards so FIRST(β) can be built up incrementally.
+ */
+void FirstFollowEngine::compute_follow_sets()
+{
+    const auto num_nonterminals = symbols.num_nonterminals();
+    follow_sets.assign(num_nonterminals, DenseBitset(symbols.num_terminals()));
+    std::vector<std::vector<std::uint32_t>> dependents(num_nonterminals);
+    if (num_nonterminals == 0)
+        return;
+
+    // assuming start symbol is the first symbol
+    follow_sets[0].set(symbols.terminal_index(SymbolTable::eoi_id));
+
+    DenseBitset suffix_first(symbols.num_terminals());
+    for (std::size_t p = 0; p < num_productions(); p++) {
+        const auto LHS = symbols.nonterminal_index(production_LHS[p]);
+        const auto RHS = get_production_RHS(p);
+        suffix_first.clear();
+        bool suffix_nullable = true;
+        for (auto it = RHS.rbegin(); it != RHS.rend(); ++it) {
+            if (symbols.is_terminal(*it)) {
+                suffix_first.clear();
+                suffix_first.set(symbols.terminal_index(*it));
+                suffix_nullable = false;
+                continue;
+            }
+            const auto index = symbols.nonterminal_index(*it);
+            follow_sets[index].merge(suffix_first);
+            if (suffix_nullable && index != LHS)
+                dependents[LHS].push_back(index);
+
+            if (nullable.test(index)) {
+                suffix_first.merge(first_sets[index]);
+            } else {
+                suffix_first = first_sets[index];
+                suffix_nullable = false;
+            }
+        }
+    }
+    propagate(follow_sets, dependents);
+}
+
+void FirstFollowEngine::propagate(std::vector<DenseBitset> &sets,
+                                  std::vector<std::vector<std::uint32_t>> &dependents)
+{
+    for (auto &edges : dependents) {
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    }
+
+    std::vector<std::uint32_t> worklist(sets.size());
+    std::vector<bool> queued(sets.size(), true);
+    for (std::size_t i = 0; i < sets.size(); i++)
+        worklist[i] = static_cast<std::uint32_t>(sets.size() - 1 - i);
+
+    while (!worklist.empty()) {
+        const auto source = worklist.back();
+        worklist.pop_back();
+        queued[source] = false;
+        for (auto target : dependents[source]) {
+            if (sets[target].merge(sets[source]) && !queued[target]) {
+                queued[target] = true;
+                worklist.push_back(target);
+            }
+        }
+    }
+}
+
+std::span<const std::uint32_t> FirstFollowEngine::get_productions(SymbolId nonterminal) const
+{
+    return get_dependencies().productions[symbols.nonterminal_index(nonterminal)];
+}
+
+const FirstFollowEngine::Dependencies &FirstFollowEngine::get_dependencies() const
+{
+    if (dependencies)
+        return *dependencies;
+    auto &built = dependencies.emplace();
+    built.productions.resize(symbols.num_nonterminals());
+    built.occurrences.resize(symbols.num_nonterminals());
+    for (std::uint32_t p = 0; p < num_productions(); p++) {
+        if (removed[p])
+            continue;
+        built.productions[symbols.nonterminal_index(production_LHS[p])].push_back(p);
+        const auto RHS = get_production_RHS(p);
+        for (std::uint32_t position = 0; position < RHS.size(); position++) {
+            if (symbols.is_nonterminal(RHS[position]))
+                built.occurrences[symbols.nonterminal_index(RHS[position])].push_back(
+                    {p, position});
+        }
+    }
+    return built;
+}
+
+FirstFollowEngine::Changes FirstFollowEngine::replace_rule(const GrammarRule &rule)
+{
+    const auto LHS = symbols.intern(rule.get_LHS());
+    for (const auto &production : rule.get_productions())
+        for (const auto &symbol : production.get_production_symbols())
+            symbols.intern(symbol);
+    add_symbols();
+    return update(LHS, &rule);
+}
+
+FirstFollowEngine::Changes FirstFollowEngine::remove_rule(const ProductionSymbol &LHS)
+{
+    const auto id = symbols.find(LHS);
+    if (id == SymbolTable::invalid_id || !symbols.is_nonterminal(id))
+        return {};
+    if (symbols.nonterminal_index(id) == 0)
+        throw std::invalid_argument("the rule of the start symbol can't be removed");
+    return update(id, nullptr);
+}
+
+void FirstFollowEngine::add_symbols()
+{
+    const auto num_nonterminals = symbols.num_nonterminals();
+    const auto num_terminals = symbols.num_terminals();
+    if (!first_sets.empty() && first_sets.front().size() != num_terminals) {
+        for (auto *sets : {&first_sets, &follow_sets})
+            for (auto &set : *sets)
+                set.resize(num_terminals);
+    }
+    first_sets.resize(num_nonterminals, DenseBitset(num_terminals));
+    follow_sets.resize(num_nonterminals, DenseBitset(num_terminals));
+    nullable.resize(num_nonterminals);
+    if (dependencies) {
+        dependencies->productions.resize(num_nonterminals);
+        dependencies->occurrences.resize(num_nonterminals);
+    }
+}
+
+/**
+ * Swaps the productions of LHS, then updates nullable, FIRST and FOLLOW in that order. Each
+ * analysis starts from the nonterminals whose equations the steps before changed, and from what
+ * the removed productions contributed to them: nullable from LHS, FIRST from LHS and the rules
+ * using a nonterminal whose nullable changed, FOLLOW from the nonterminals in the swapped
+ * productions and those in front of a nonterminal whose nullable or FIRST changed.
+ */
+FirstFollowEngine::Changes FirstFollowEngine::update(SymbolId LHS, const GrammarRule *rule)
+{
+    get_dependencies();
+    auto &productions = dependencies->productions;
+    auto &occurrences = dependencies->occurrences;
+    const auto index = symbols.nonterminal_index(LHS);
+    const auto num_terminals = symbols.num_terminals();
+    auto LHS_index = [&](std::uint32_t production) {
+        return symbols.nonterminal_index(production_LHS[production]);
+    };
+
+    std::vector<std::vector<SymbolId>> added;
+    if (rule) {
+        for (const auto &production : rule->get_productions()) {
+            auto &RHS = added.emplace_back();
+            for (const auto &symbol : production.get_production_symbols()) {
+                if (!symbol.is_epsilon())
+                    RHS.push_back(symbols.find(symbol));
+            }
+        }
+    }
+    // productions the new rule starts with stay, so production indices stay in rule order
+    auto &own = productions[index];
+    std::size_t kept = 0;
+    while (kept < own.size() && kept < added.size() &&
+           std::ranges::equal(get_production_RHS(own[kept]), added[kept]))
+        kept++;
+
+    // the removed productions take what they contributed with them, with the sets from before
+    bool lost_nullable = false;
+    std::vector<Lost> first_lost{{index, DenseBitset(num_terminals)}};
+    std::vector<Lost> follow_lost;
+    DenseBitset suffix_first(num_terminals);
+    for (auto p = own.begin() + static_cast<std::ptrdiff_t>(kept); p != own.end(); ++p) {
+        const auto RHS = get_production_RHS(*p);
+        bool production_nullable = false;
+        first_lost.front().second.merge(first(RHS, production_nullable));
+        lost_nullable |= production_nullable;
+        suffix_first = follow_sets[index];
+        for (auto it = RHS.rbegin(); it != RHS.rend(); ++it) {
+            if (symbols.is_terminal(*it)) {
+                suffix_first.clear();
+                suffix_first.set(symbols.terminal_index(*it));
+                continue;
+            }
+            const auto occurring = symbols.nonterminal_index(*it);
+            follow_lost.emplace_back(occurring, suffix_first);
+            if (nullable.test(occurring))
+                suffix_first.merge(first_sets[occurring]);
+            else
+                suffix_first = first_sets[occurring];
+            std::erase_if(occurrences[occurring], [p](const Occurrence &occurrence) {
+                return occurrence.production == *p;
+            });
+        }
+        removed[*p] = true;
+    }
+    own.resize(kept);
+    for (auto RHS = added.begin() + static_cast<std::ptrdiff_t>(kept); RHS != added.end(); ++RHS) {
+        const auto p = static_cast<std::uint32_t>(num_productions());
+        for (std::uint32_t position = 0; position < RHS->size(); position++) {
+            const auto symbol = (*RHS)[position];
+            if (!symbols.is_nonterminal(symbol))
+                continue;
+            occurrences[symbols.nonterminal_index(symbol)].push_back({p, position});
+            follow_lost.emplace_back(symbols.nonterminal_index(symbol),
+                                     DenseBitset(num_terminals));
+        }
+        RHS_symbols.insert(RHS_symbols.end(), RHS->begin(), RHS->end());
+        production_LHS.push_back(LHS);
+        RHS_offsets.push_back(static_cast<std::uint32_t>(RHS_symbols.size()));
+        removed.push_back(false);
+        own.push_back(p);
+    }
+
+    const auto nullable_changed = update_nullable(index, lost_nullable);
+
+    // a nullable change can cut a production short anywhere, those start over from nothing
+    for (auto changed : nullable_changed) {
+        for (const auto &occurrence : occurrences[changed]) {
+            const auto target = LHS_index(occurrence.production);
+            first_lost.emplace_back(target, first_sets[target]);
+        }
+    }
+    const auto first_changed = rederive(
+        first_sets, std::move(first_lost),
+        [&](std::uint32_t source, auto &&f) {
+            // the rules where source comes first, after nothing but nullable nonterminals
+            for (const auto &occurrence : occurrences[source]) {
+                const auto RHS = get_production_RHS(occurrence.production);
+                if (std::all_of(RHS.begin(), RHS.begin() + occurrence.position,
+                                [&](SymbolId symbol) { return is_nullable(symbol); }))
+                    f(LHS_index(occurrence.production));
+            }
+        },
+        [&](std::uint32_t target, DenseBitset &set) {
+            for (auto p : productions[target]) {
+                for (auto symbol : get_production_RHS(p)) {
+                    if (symbols.is_terminal(symbol)) {
+                        set.set(symbols.terminal_index(symbol));
+                        break;
+                    }
+                    set.merge(first_sets[symbols.nonterminal_index(symbol)]);
+                    if (!is_nullable(symbol))
+                        break;
+                }
+            }
+        });
+
+    // a nonterminal gets FIRST of what comes after it, up to the first one that isn't nullable
+    auto in_front_of = [&](std::uint32_t nonterminal, auto &&f) {
+        for (const auto &occurrence : occurrences[nonterminal]) {
+            const auto RHS = get_production_RHS(occurrence.production);
+            for (auto position = occurrence.position; position-- > 0;) {
+                if (!symbols.is_nonterminal(RHS[position]))
+                    break;
+                f(symbols.nonterminal_index(RHS[position]));
+                if (!is_nullable(RHS[position]))
+                    break;
+            }
+        }
+    };
+    for (auto changed : nullable_changed)
+        in_front_of(changed, [&](std::uint32_t target) {
+            follow_lost.emplace_back(target, follow_sets[target]);
+        });
+    for (const auto &[changed, before] : first_changed) {
+        auto lost = before;
+        lost.remove(first_sets[changed]);
+        in_front_of(changed, [&](std::uint32_t target) { follow_lost.emplace_back(target, lost); });
+    }
+    const auto follow_changed = rederive(
+        follow_sets, std::move(follow_lost),
+        [&](std::uint32_t source, auto &&f) {
+            // the nonterminals at the end of a production of source, up to nullable ones
+            for (auto p : productions[source]) {
+                const auto RHS = get_production_RHS(p);
+                for (auto it = RHS.rbegin(); it != RHS.rend(); ++it) {
+                    if (!symbols.is_nonterminal(*it))
+                        break;
+                    f(symbols.nonterminal_index(*it));
+                    if (!is_nullable(*it))
+                        break;
+                }
+            }
+        },
+        [&](std::uint32_t target, DenseBitset &set) {
+            if (target == 0)
+                set.set(symbols.terminal_index(SymbolTable::eoi_id));
+            for (const auto &occurrence : occurrences[target]) {
+                const auto RHS = get_production_RHS(occurrence.production);
+                auto it = RHS.begin() + occurrence.position + 1;
+                for (; it != RHS.end(); ++it) {
+                    if (symbols.is_terminal(*it)) {
+                        set.set(symbols.terminal_index(*it));
+                        break;
+                    }
+                    set.merge(first_sets[symbols.nonterminal_index(*it)]);
+                    if (!is_nullable(*it))
+                        break;
+                }
+                if (it == RHS.end())
+                    set.merge(follow_sets[LHS_index(occurrence.production)]);
+            }
+        });
+
+    // a row depends on the productions of its nonterminal, FIRST and nullable of what they
+    // start with and its FOLLOW set
+    Changes changes;
+    std::vector<std::uint32_t> rows{index};
+    auto report = [&](std::uint32_t nonterminal, std::vector<SymbolId> &changed) {
+        changed.push_back(symbols.nonterminal_at(nonterminal));
+        for (const auto &occurrence : occurrences[nonterminal])
+            rows.push_back(LHS_index(occurrence.production));
+    };
+    for (auto nonterminal : nullable_changed)
+        report(nonterminal, changes.nullable);
+    for (const auto &[nonterminal, before] : first_changed)
+        report(nonterminal, changes.first);
+    for (const auto &[nonterminal, before] : follow_changed) {
+        changes.follow.push_back(symbols.nonterminal_at(nonterminal));
+        rows.push_back(nonterminal);
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    for (auto nonterminal : rows)
+        changes.rows.push_back(symbols.nonterminal_at(nonterminal));
+    return changes;
+}
+
+/**
+ * Like rederive() for FIRST and FOLLOW, with a single bit per nonterminal. If lost, changed and
+ * everything that is only nullable through it are no longer nullable. Then whatever has a
+ * production made of nullable nonterminals is nullable again, starting from changed.
+ */
+std::vector<std::uint32_t> FirstFollowEngine::update_nullable(std::uint32_t changed, bool lost)
+{
+    const auto &[productions, occurrences] = get_dependencies();
+    // 0 for untouched, else 1 + whether it was nullable before
+    std::vector<std::uint8_t> before(symbols.num_nonterminals(), 0);
+    std::vector<std::uint32_t> touched;
+    auto touch = [&](std::uint32_t index) {
+        if (before[index] == 0) {
+            before[index] = 1 + nullable.test(index);
+            touched.push_back(index);
+        }
+    };
+    auto LHS_index = [&](std::uint32_t production) {
+        return symbols.nonterminal_index(production_LHS[production]);
+    };
+
+    std::vector<std::uint32_t> worklist;
+    touch(changed);
+    if (lost && nullable.test(changed)) {
+        nullable.reset(changed);
+        worklist.push_back(changed);
+    }
+    while (!worklist.empty()) {
+        const auto source = worklist.back();
+        worklist.pop_back();
+        for (const auto &occurrence : occurrences[source]) {
+            const auto target = LHS_index(occurrence.production);
+            if (nullable.test(target)) {
+                touch(target);
+                nullable.reset(target);
+                worklist.push_back(target);
+            }
+        }
+    }
+
+    auto production_nullable = [&](std::uint32_t p) {
+        const auto RHS = get_production_RHS(p);
+        return std::all_of(RHS.begin(), RHS.end(),
+                           [&](SymbolId symbol) { return is_nullable(symbol); });
+    };
+    auto derive = [&](std::uint32_t index) {
+        touch(index);
+        nullable.set(index);
+        worklist.push_back(index);
+    };
+    for (std::size_t i = 0; i < touched.size(); i++) {
+        const auto index = touched[i];
+        if (!nullable.test(index) &&
+            std::any_of(productions[index].begin(), productions[index].end(), production_nullable))
+            derive(index);
+    }
+    while (!worklist.empty()) {
+        const auto source = worklist.back();
+        worklist.pop_back();
+        for (const auto &occurrence : occurrences[source]) {
+            const auto target = LHS_index(occurrence.production);
+            if (!nullable.test(target) && production_nullable(occurrence.production))
+                derive(target);
+        }
+    }
+
+    std::vector<std::uint32_t> result;
+    for (auto index : touched) {
+        if (nullable.test(index) != (before[index] == 2))
+            result.push_back(index);
+    }
+    return result;
+}
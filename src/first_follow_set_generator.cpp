@@ -1,8 +1,8 @@
 #include <jacc/first_follow_set_generator.h>
 #include <jacc/grammar.h>
+#include <jacc/trace.h>
 #include <algorithm>
 #include <iterator>
-#include <spdlog/spdlog.h>
 
 namespace
 {
@@ -13,6 +13,59 @@ bool set_contains_epsilon(const std::set<ProductionSymbol> &set)
 
 } // namespace
 
+const FirstFollowEngine &FirstFollowSetGenerator::get_engine()
+{
+    if (!bitset_engine)
+        bitset_engine = std::make_shared<FirstFollowEngine>(grammar);
+    return *bitset_engine;
+}
+
+FirstFollowEngine &FirstFollowSetGenerator::get_mutable_engine()
+{
+    get_engine();
+    // copies of a generator share the engine until one of them changes it
+    if (bitset_engine.use_count() > 1)
+        bitset_engine = std::make_shared<FirstFollowEngine>(*bitset_engine);
+    return *bitset_engine;
+}
+
+void FirstFollowSetGenerator::forget_sets()
+{
+    first_sets.clear();
+    follow_sets.clear();
+    first_initialized = false;
+    follow_initialized = false;
+}
+
+FirstFollowEngine::Changes FirstFollowSetGenerator::replace_rule(const GrammarRule &rule)
+{
+    auto &sets = get_mutable_engine();
+    grammar.replace_rule(rule);
+    forget_sets();
+    return sets.replace_rule(rule);
+}
+
+FirstFollowEngine::Changes FirstFollowSetGenerator::remove_rule(const ProductionSymbol &LHS)
+{
+    auto &sets = get_mutable_engine();
+    grammar.remove_rule(LHS);
+    forget_sets();
+    return sets.remove_rule(LHS);
+}
+
+std::set<ProductionSymbol> FirstFollowSetGenerator::to_symbol_set(const DenseBitset &terminals,
+                                                                  bool with_epsilon) const
+{
+    const auto &symbols = bitset_engine->get_symbol_table();
+    std::set<ProductionSymbol> result;
+    terminals.for_each([&](std::size_t index) {
+        result.insert(symbols.get_symbol(symbols.terminal_at(static_cast<std::uint32_t>(index))));
+    });
+    if (with_epsilon)
+        result.insert(ProductionSymbol::create_epsilon());
+    return result;
+}
+
 /**
  * 1. If X is a terminal then First(X) is just X!
  * 2. If there is a Production X → ε then add ε to first(X)
@@ -27,11 +80,20 @@ FirstFollowSetGenerator::set_map<ProductionSymbol> FirstFollowSetGenerator::gene
 {
     if (first_initialized)
         return first_sets;
+    if (engine == Engine::Bitset) {
+        const auto &sets = get_engine();
+        for (auto &rule : grammar.get_rules()) {
+            const auto LHS = sets.get_symbol_table().find(rule.get_LHS());
+            first_sets[rule.get_LHS()] = to_symbol_set(sets.first(LHS), sets.is_nullable(LHS));
+        }
+        first_initialized = true;
+        return first_sets;
+    }
     set_map<ProductionSymbol> first_sets;
     for (auto &rule : grammar.get_rules()) {
         auto LHS = rule.get_LHS();
         std::set<ProductionSymbol> current_first_set{};
-        spdlog::debug("loop {}", LHS);
+        JACC_TRACE("loop {}", LHS);
         auto first_set = first(LHS);
         first_sets[LHS] = first_set;
     }
@@ -41,6 +103,33 @@ FirstFollowSetGenerator::set_map<ProductionSymbol> FirstFollowSetGenerator::gene
 
 std::set<ProductionSymbol> FirstFollowSetGenerator::first(const Production &p)
 {
+    if (engine == Engine::Bitset) {
+        const auto &sets = get_engine();
+        std::set<ProductionSymbol> first_set;
+        bool all_nullable = true;
+        for (const ProductionSymbol &symbol : p.get_production_symbols()) {
+            if (symbol.is_epsilon())
+                continue;
+            if (symbol.is_terminal() || symbol.is_EOI()) {
+                first_set.insert(symbol);
+                all_nullable = false;
+                break;
+            }
+            const auto id = sets.get_symbol_table().find(symbol);
+            if (id == SymbolTable::invalid_id) {
+                all_nullable = false;
+                break;
+            }
+            first_set.merge(to_symbol_set(sets.first(id), false));
+            if (!sets.is_nullable(id)) {
+                all_nullable = false;
+                break;
+            }
+        }
+        if (all_nullable)
+            first_set.insert(ProductionSymbol::create_epsilon());
+        return first_set;
+    }
     std::set<ProductionSymbol> first_sets;
     bool all_contains_epsilon = true; // To keep track of rule 3
     for (const ProductionSymbol &symbol : p.get_production_symbols()) {
@@ -59,24 +148,29 @@ std::set<ProductionSymbol> FirstFollowSetGenerator::first(const Production &p)
 }
 std::set<ProductionSymbol> FirstFollowSetGenerator::first(const ProductionSymbol &p)
 {
-    spdlog::debug("{}({})", __func__, p);
+    JACC_TRACE("{}({})", __func__, p);
     // rule 1
     if (p.is_terminal())
         return {p};
+    if (engine == Engine::Bitset) {
+        const auto &sets = get_engine();
+        const auto id = sets.get_symbol_table().find(p);
+        if (id == SymbolTable::invalid_id || !p.is_nonTerminal())
+            return {};
+        return to_symbol_set(sets.first(id), sets.is_nullable(id));
+    }
     else if (first_sets.find(p) != first_sets.end()) {
-        spdlog::debug("found cached value {}. returning", first_sets[p]);
+        JACC_TRACE("found cached value {}. returning", first_sets[p]);
         return first_sets[p];
     }
     assert(p.is_nonTerminal());
     std::set<ProductionSymbol> first_set{};
 
-    bool should_contain_epsilon = false; // to keep track of rule 2
-    if (auto rule = grammar.get_production(p); rule.has_value()) {
-        auto productions = rule.value().get_productions();
-        for (const auto &production : productions) {
-            if (production.is_epsilon())
-                should_contain_epsilon = true;
-            else if (production.get_production_symbols().front() == p)
+    // rules 2 and 3, ε is in FIRST exactly when p is nullable
+    const bool should_contain_epsilon = grammar.is_nullable(p);
+    if (const auto *rule = grammar.find_rule(p)) {
+        for (const auto &production : rule->get_productions()) {
+            if (!production.is_epsilon() && production.get_production_symbols().front() == p)
                 break;
 
             auto set = first(production);
@@ -84,7 +178,9 @@ std::set<ProductionSymbol> FirstFollowSetGenerator::first(const ProductionSymbol
         }
     }
 
-    if (!should_contain_epsilon)
+    if (should_contain_epsilon)
+        first_set.insert(ProductionSymbol::create_epsilon());
+    else
         first_set.erase(ProductionSymbol::create_epsilon());
     first_sets[p] = first_set;
     return first_set;
@@ -101,7 +197,16 @@ FirstFollowSetGenerator::set_map<ProductionSymbol> FirstFollowSetGenerator::gene
 {
     if (follow_initialized)
         return follow_sets;
-    const auto rules = grammar.get_rules();
+    if (engine == Engine::Bitset) {
+        const auto &sets = get_engine();
+        for (const auto &rule : grammar.get_rules()) {
+            const auto LHS = sets.get_symbol_table().find(rule.get_LHS());
+            follow_sets[rule.get_LHS()] = to_symbol_set(sets.follow(LHS), false);
+        }
+        follow_initialized = true;
+        return follow_sets;
+    }
+    const auto &rules = grammar.get_rules();
     // assuming start symbol is the first symbol
     follow_sets[rules.front().get_LHS()] =
         std::set<ProductionSymbol>{ProductionSymbol::create_EOI()};
@@ -112,12 +217,12 @@ FirstFollowSetGenerator::set_map<ProductionSymbol> FirstFollowSetGenerator::gene
 
         for (const auto &rule : rules) {
             const auto LHS = rule.get_LHS();
-            spdlog::debug("rule {}", rule);
+            JACC_TRACE("rule {}", rule);
             if (follow_sets.find(LHS) == follow_sets.end())
                 follow_sets[LHS] = std::set<ProductionSymbol>{};
 
             auto temp = follow(LHS);
-            spdlog::debug("merging {} with {}", follow_sets[LHS], temp);
+            JACC_TRACE("merging {} with {}", follow_sets[LHS], temp);
             auto old_length = follow_sets[LHS].size();
             follow_sets[LHS].insert(temp.cbegin(), temp.cend());
             if (old_length != follow_sets[LHS].size()) {
@@ -131,38 +236,38 @@ FirstFollowSetGenerator::set_map<ProductionSymbol> FirstFollowSetGenerator::gene
 
 std::set<ProductionSymbol> FirstFollowSetGenerator::follow(const ProductionSymbol &p)
 {
-    spdlog::debug("{}({})", __func__, p);
-    auto follow_set = std::set<ProductionSymbol>{};
-    auto productions_with_symbol = grammar.get_rules_containing_symbol(p);
-    if (!productions_with_symbol.has_value()) {
-        spdlog::debug("didnt find any productions with {}", p);
-        return {};
+    JACC_TRACE("{}({})", __func__, p);
+    if (engine == Engine::Bitset) {
+        const auto &sets = get_engine();
+        const auto id = sets.get_symbol_table().find(p);
+        if (id == SymbolTable::invalid_id || !p.is_nonTerminal())
+            return {};
+        return to_symbol_set(sets.follow(id), false);
     }
-    for (auto &production : productions_with_symbol.value()) {
-        auto LHS = production.synthesized_LHS.value();
-        auto RHS = production.get_production_symbols();
-        auto production_it = std::find(RHS.begin(), RHS.end(), p);
-        while (production_it != RHS.end()) {
-            auto next_it = production_it + 1;
-            while (next_it != RHS.end()) {
-                auto next_symbol = *next_it;
-                auto first_of_next = first(next_symbol);
-                spdlog::debug("{}:{} - current symbol: {}, next_symbol: {}. first_of_next: {}", LHS,
-                              production, *production_it, next_symbol, first_of_next);
-
-                std::copy_if(first_of_next.cbegin(), first_of_next.cend(),
-                             std::inserter(follow_set, follow_set.end()),
-                             [](ProductionSymbol val) { return !val.is_epsilon(); });
-
-                if (!set_contains_epsilon(first_of_next))
-                    break;
-                next_it++;
-            }
+    auto follow_set = std::set<ProductionSymbol>{};
+    for (const auto &occurrence : grammar.get_occurrences(p)) {
+        const auto &rule = grammar.get_rules()[occurrence.rule];
+        const auto &LHS = rule.get_LHS();
+        const auto &production = rule.get_productions()[occurrence.production];
+        const auto &RHS = production.get_production_symbols();
+        auto next_it = RHS.begin() + occurrence.position + 1;
+        while (next_it != RHS.end()) {
+            const auto &next_symbol = *next_it;
+            auto first_of_next = first(next_symbol);
+            JACC_TRACE("{}:{} - current symbol: {}, next_symbol: {}. first_of_next: {}", LHS,
+                       production, p, next_symbol, first_of_next);
 
-            if (next_it == RHS.end()) {
-                follow_set.insert(follow_sets[LHS].cbegin(), follow_sets[LHS].cend());
-            }
-            production_it = std::find(production_it + 1, RHS.end(), p);
+            std::copy_if(first_of_next.cbegin(), first_of_next.cend(),
+                         std::inserter(follow_set, follow_set.end()),
+                         [](ProductionSymbol val) { return !val.is_epsilon(); });
+
+            if (!set_contains_epsilon(first_of_next))
+                break;
+            next_it++;
+        }
+
+        if (next_it == RHS.end()) {
+            follow_set.insert(follow_sets[LHS].cbegin(), follow_sets[LHS].cend());
         }
     }
     return follow_set;
@@ -1,5 +1,9 @@
 #include <jacc/grammar.h>
-#include <spdlog/spdlog.h>
+#include <jacc/trace.h>
+
+#include <limits>
+#include <mutex>
+#include <stdexcept>
 
 ProductionSymbol ProductionSymbol::create_epsilon()
 {
@@ -30,26 +34,210 @@ std::optional<std::vector<Production>>
 Grammar::get_rules_containing_symbol(const ProductionSymbol &p)
 {
     std::vector<Production> rules_containing_symbol{};
-    for (auto &rule : get_rules()) {
-        auto LHS = rule.get_LHS();
-        for (auto &production : rule.get_productions()) {
-            auto symbols = production.get_production_symbols();
-            spdlog::debug("looking for {} in {}", p, symbols);
-            if (std::find(symbols.begin(), symbols.end(), p) != symbols.end()) {
-                spdlog::debug("found {} in {}!", p, rule);
-                rules_containing_symbol.push_back(production);
-            }
-        }
+    const SymbolOccurrence *previous = nullptr;
+    for (const auto &occurrence : get_occurrences(p)) {
+        // a production that contains the symbol twice is still only returned once
+        if (previous && previous->rule == occurrence.rule &&
+            previous->production == occurrence.production)
+            continue;
+        previous = &occurrence;
+        rules_containing_symbol.push_back(
+            rules[occurrence.rule].get_productions()[occurrence.production]);
     }
     return rules_containing_symbol;
 }
 
 const std::optional<GrammarRule> Grammar::get_production(const ProductionSymbol &p) const
 {
-    for (const GrammarRule &gr : rules) {
-        if (gr.get_LHS() == p) {
-            return gr;
+    if (const auto *rule = find_rule(p))
+        return *rule;
+    return std::nullopt;
+}
+
+struct Grammar::Index {
+    static constexpr std::uint32_t no_rule = std::numeric_limits<std::uint32_t>::max();
+    std::once_flag built;
+    // by dense nonterminal index
+    std::vector<std::uint32_t> rule_of;
+    // the occurrences of symbol id s are occurrences[occurrence_offsets[s], [s + 1])
+    std::vector<std::uint32_t> occurrence_offsets;
+    std::vector<SymbolOccurrence> occurrences;
+    DenseBitset nullable;
+};
+
+namespace
+{
+/**
+ * Every production keeps a count of nonterminals in its RHS that are not known to be nullable yet.
+ * Whenever a nonterminal becomes nullable, the counts of the productions it occurs in drop, and a
+ * production whose count hits zero makes its LHS nullable. Productions containing a terminal can
+ * never reach zero. Each occurrence is visited at most once, left recursion included.
+ */
+DenseBitset compute_nullable(const std::vector<GrammarRule> &rules, const SymbolTable &symbols,
+                             const std::vector<std::uint32_t> &occurrence_offsets,
+                             const std::vector<SymbolOccurrence> &occurrences)
+{
+    constexpr auto never = std::numeric_limits<std::uint32_t>::max();
+    DenseBitset nullable(symbols.num_nonterminals());
+    std::vector<std::uint32_t> first_production;
+    std::vector<std::uint32_t> remaining;
+    std::vector<SymbolId> worklist;
+
+    auto mark_nullable = [&](const GrammarRule &rule) {
+        const auto id = symbols.find(rule.get_LHS());
+        const auto index = symbols.nonterminal_index(id);
+        if (!nullable.test(index)) {
+            nullable.set(index);
+            worklist.push_back(id);
+        }
+    };
+
+    for (const auto &rule : rules) {
+        first_production.push_back(static_cast<std::uint32_t>(remaining.size()));
+        for (const auto &production : rule.get_productions()) {
+            std::uint32_t count = 0;
+            for (const auto &symbol : production.get_production_symbols()) {
+                if (symbol.is_nonTerminal())
+                    count++;
+                else if (!symbol.is_epsilon())
+                    count = never;
+                if (count == never)
+                    break;
+            }
+            remaining.push_back(count);
+            if (count == 0)
+                mark_nullable(rule);
         }
     }
-    return std::nullopt;
+
+    while (!worklist.empty()) {
+        const auto nonterminal = worklist.back();
+        worklist.pop_back();
+        const auto end = occurrence_offsets[nonterminal + 1];
+        for (auto o = occurrence_offsets[nonterminal]; o < end; o++) {
+            const auto &occurrence = occurrences[o];
+            auto &count = remaining[first_production[occurrence.rule] + occurrence.production];
+            if (count != never && --count == 0)
+                mark_nullable(rules[occurrence.rule]);
+        }
+    }
+    return nullable;
+}
+} // namespace
+
+const Grammar::Index &Grammar::get_index() const
+{
+    std::call_once(index->built, [this] { build_index(*index); });
+    return *index;
+}
+
+void Grammar::build_index(Index &built) const
+{
+    built.rule_of.assign(symbols.num_nonterminals(), Index::no_rule);
+
+    // count the occurrences of every symbol first, then fill them in place
+    std::vector<SymbolId> ids;
+    auto &offsets = built.occurrence_offsets;
+    offsets.assign(symbols.size() + 1, 0);
+    for (std::uint32_t r = 0; r < rules.size(); r++) {
+        const auto LHS = symbols.nonterminal_index(symbols.find(rules[r].get_LHS()));
+        if (built.rule_of[LHS] == Index::no_rule)
+            built.rule_of[LHS] = r;
+        for (const auto &production : rules[r].get_productions()) {
+            for (const auto &symbol : production.get_production_symbols()) {
+                ids.push_back(symbols.find(symbol));
+                if (ids.back() != SymbolTable::invalid_id)
+                    offsets[ids.back() + 1]++;
+            }
+        }
+    }
+    for (std::size_t s = 1; s < offsets.size(); s++)
+        offsets[s] += offsets[s - 1];
+
+    auto next = offsets;
+    built.occurrences.resize(ids.size());
+    auto id = ids.begin();
+    for (std::uint32_t r = 0; r < rules.size(); r++) {
+        const auto &productions = rules[r].get_productions();
+        for (std::uint32_t p = 0; p < productions.size(); p++) {
+            const auto num_symbols = productions[p].get_num_symbols();
+            for (std::uint32_t position = 0; position < num_symbols; position++, id++) {
+                if (*id != SymbolTable::invalid_id)
+                    built.occurrences[next[*id]++] = {r, p, position};
+            }
+        }
+    }
+    built.nullable = compute_nullable(rules, symbols, offsets, built.occurrences);
+}
+
+const GrammarRule *Grammar::find_rule(const ProductionSymbol &LHS) const
+{
+    const auto id = symbols.find(LHS);
+    if (id == SymbolTable::invalid_id || !symbols.is_nonterminal(id))
+        return nullptr;
+    const auto nonterminal = symbols.nonterminal_index(id);
+    const auto rule = get_index().rule_of[nonterminal];
+    return rule == Index::no_rule ? nullptr : &rules[rule];
+}
+
+std::span<const SymbolOccurrence> Grammar::get_occurrences(const ProductionSymbol &symbol) const
+{
+    const auto id = symbols.find(symbol);
+    if (id == SymbolTable::invalid_id)
+        return {};
+    const auto &built = get_index();
+    const auto &offsets = built.occurrence_offsets;
+    return std::span{built.occurrences}.subspan(offsets[id], offsets[id + 1] - offsets[id]);
+}
+
+Grammar::Grammar(std::vector<GrammarRule> rules, SymbolTable symbols)
+    : rules(std::move(rules)), symbols(std::move(symbols)), index(std::make_shared<Index>())
+{
+    // Symbols are interned in textual order, so the start symbol is always nonterminal 0.
+    // For tables that came from the grammar parser every lookup here is a hit.
+    for (const auto &rule : this->rules) {
+        this->symbols.intern(rule.get_LHS());
+        for (const auto &production : rule.get_productions())
+            for (const auto &symbol : production.get_production_symbols())
+                this->symbols.intern(symbol);
+    }
+}
+
+void Grammar::replace_rule(GrammarRule rule)
+{
+    symbols.intern(rule.get_LHS());
+    for (const auto &production : rule.get_productions())
+        for (const auto &symbol : production.get_production_symbols())
+            symbols.intern(symbol);
+    const auto LHS = rule.get_LHS();
+    auto same_LHS = [&](const GrammarRule &other) { return other.get_LHS() == LHS; };
+    auto it = std::find_if(rules.begin(), rules.end(), same_LHS);
+    if (it == rules.end()) {
+        rules.push_back(std::move(rule));
+    } else {
+        *it = std::move(rule);
+        // a nonterminal written as several rules ends up with only the replacement
+        rules.erase(std::remove_if(std::next(it), rules.end(), same_LHS), rules.end());
+    }
+    index = std::make_shared<Index>();
+}
+
+void Grammar::remove_rule(const ProductionSymbol &LHS)
+{
+    if (!rules.empty() && rules.front().get_LHS() == LHS)
+        throw std::invalid_argument("the rule of the start symbol can't be removed");
+    std::erase_if(rules, [&](const GrammarRule &rule) { return rule.get_LHS() == LHS; });
+    index = std::make_shared<Index>();
+}
+
+const DenseBitset &Grammar::get_nullable() const { return get_index().nullable; }
+
+bool Grammar::is_nullable(const ProductionSymbol &symbol) const
+{
+    if (symbol.is_epsilon())
+        return true;
+    const auto id = symbols.find(symbol);
+    if (id == SymbolTable::invalid_id || !symbols.is_nonterminal(id))
+        return false;
+    return get_nullable().test(symbols.nonterminal_index(id));
 }
@@ -0,0 +1,654 @@
+#include <jacc/grammar_cache.h>
+#include <jacc/lexer_generator.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+#include <utility>
+
+namespace
+{
+constexpr char magic[8] = "JACCGRM";
+// reads back differently when the file was written on a machine with another byte order
+constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+enum Section : std::size_t {
+    SymbolKinds,
+    DenseIndices,
+    TerminalIds,
+    NonterminalIds,
+    NameOffsets,
+    Names,
+    ProductionLHS,
+    RHSOffsets,
+    RHSSymbols,
+    Nullable,
+    FirstSets,
+    FollowSets,
+    RowOf,
+    ColumnOf,
+    Cells,
+    HashDisplacements,
+    TerminalOfSlot,
+    TokenOffsets,
+    TokenText,
+    ByteClasses,
+    LexerTransitions,
+    LexerAccepting,
+    LexerLoopOf,
+    LexerLoops,
+    TokenSymbols,
+    NumSections,
+};
+
+constexpr std::size_t element_sizes[NumSections] = {
+    sizeof(std::uint8_t),  sizeof(std::uint32_t),
+    sizeof(SymbolId),      sizeof(SymbolId),
+    sizeof(std::uint32_t), sizeof(char),
+    sizeof(SymbolId),      sizeof(std::uint32_t),
+    sizeof(SymbolId),      sizeof(std::uint64_t),
+    sizeof(std::uint64_t), sizeof(std::uint64_t),
+    sizeof(std::uint32_t), sizeof(std::uint32_t),
+    sizeof(LLTable::ProductionIndex), sizeof(std::uint32_t),
+    sizeof(SymbolId),      sizeof(std::uint32_t),
+    sizeof(char),          sizeof(std::uint8_t),
+    sizeof(LexerTable::StateId), sizeof(LexerTable::TokenIndex),
+    sizeof(std::uint32_t), sizeof(ByteSet),
+    sizeof(SymbolId)};
+// enough for every element type, ByteSet included
+constexpr std::size_t section_alignment = 16;
+
+struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t grammar_hash;
+    std::uint32_t start_symbol;
+    std::uint32_t num_symbols;
+    std::uint32_t num_terminals;
+    std::uint32_t num_nonterminals;
+    std::uint32_t num_productions;
+    std::uint32_t num_token_definitions;
+    std::uint32_t hash_seed;
+    std::uint32_t num_hash_slots;
+    std::uint32_t num_lexer_states;
+    std::uint32_t num_lexer_classes;
+    // offset and size in bytes of every section
+    std::uint64_t sections[NumSections][2];
+};
+
+std::size_t words_per_set(const Header &header) { return (header.num_terminals + 63) / 64; }
+
+/**
+ * Number of elements every section must have, the header is trusted once this matches.
+ */
+std::size_t expected_count(const Header &header, std::size_t section)
+{
+    const std::size_t symbols = header.num_symbols;
+    switch (section) {
+    case SymbolKinds:
+    case DenseIndices:
+    case RowOf:
+    case ColumnOf:
+        return symbols;
+    case TerminalIds:
+        return header.num_terminals;
+    case NonterminalIds:
+        return header.num_nonterminals;
+    case NameOffsets:
+        return symbols + 1;
+    case ProductionLHS:
+        return header.num_productions;
+    case RHSOffsets:
+        return header.num_productions + std::size_t{1};
+    case Nullable:
+        return (header.num_nonterminals + std::size_t{63}) / 64;
+    case FirstSets:
+    case FollowSets:
+        return header.num_nonterminals * words_per_set(header);
+    case Cells:
+        return std::size_t{header.num_nonterminals} * header.num_terminals;
+    case TerminalOfSlot:
+        return header.num_hash_slots;
+    case TokenOffsets:
+        return 2 * std::size_t{header.num_token_definitions} + 1;
+    case ByteClasses:
+        return 256;
+    case LexerTransitions:
+        return std::size_t{header.num_lexer_states} * header.num_lexer_classes;
+    case LexerAccepting:
+    case LexerLoopOf:
+        return header.num_lexer_states;
+    case TokenSymbols:
+        return header.num_token_definitions;
+    default:
+        // the variable length ones are checked against their offsets
+        return std::numeric_limits<std::size_t>::max();
+    }
+}
+
+class ImageWriter
+{
+  public:
+    ImageWriter() : image(sizeof(Header), '\0') {}
+
+    template <typename T> void add(Section section, std::span<const T> elements)
+    {
+        image.resize((image.size() + section_alignment - 1) / section_alignment *
+                         section_alignment,
+                     '\0');
+        header.sections[section][0] = image.size();
+        header.sections[section][1] = elements.size_bytes();
+        image.append(reinterpret_cast<const char *>(elements.data()), elements.size_bytes());
+    }
+    template <typename T> void add(Section section, const std::vector<T> &elements)
+    {
+        add(section, std::span<const T>{elements});
+    }
+
+    std::string finish()
+    {
+        std::memcpy(image.data(), &header, sizeof(Header));
+        return std::move(image);
+    }
+
+    Header header{};
+
+  private:
+    std::string image;
+};
+
+/**
+ * Appends strings to one blob and records where each one ends.
+ */
+void append_string(std::string_view text, std::string &blob, std::vector<std::uint32_t> &offsets)
+{
+    blob += text;
+    offsets.push_back(static_cast<std::uint32_t>(blob.size()));
+}
+} // namespace
+
+std::uint64_t hash_grammar(std::string_view text)
+{
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (auto c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+std::optional<std::uint64_t> hash_grammar_file(const std::string &path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0) {
+        if (fd >= 0)
+            close(fd);
+        return std::nullopt;
+    }
+    const auto file_size = static_cast<std::size_t>(status.st_size);
+    if (file_size == 0) {
+        close(fd);
+        return hash_grammar({});
+    }
+    void *memory = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+        return std::nullopt;
+    const auto hash = hash_grammar({static_cast<const char *>(memory), file_size});
+    munmap(memory, file_size);
+    return hash;
+}
+
+std::string serialize_compiled_grammar(std::uint64_t grammar_hash, const Grammar &grammar,
+                                       const FirstFollowEngine &engine, const LLTable &table)
+{
+    const auto &symbols = table.get_symbol_table();
+    if (symbols.size() != engine.get_symbol_table().size() ||
+        table.num_productions() != engine.num_productions())
+        throw std::invalid_argument("the LL table was not generated from this engine");
+    if (table.get_encoding() != LLTable::Encoding::Dense)
+        throw std::invalid_argument("only dense LL tables can be compiled");
+
+    ImageWriter writer;
+    auto &header = writer.header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = CompiledGrammar::format_version;
+    header.byte_order = byte_order_mark;
+    header.grammar_hash = grammar_hash;
+    header.start_symbol = table.get_start_symbol();
+    header.num_symbols = static_cast<std::uint32_t>(symbols.size());
+    header.num_terminals = static_cast<std::uint32_t>(symbols.num_terminals());
+    header.num_nonterminals = static_cast<std::uint32_t>(symbols.num_nonterminals());
+    header.num_productions = static_cast<std::uint32_t>(table.num_productions());
+
+    std::vector<std::uint8_t> kinds;
+    std::vector<std::uint32_t> dense_indices, row_of, column_of;
+    std::vector<std::uint32_t> name_offsets{0};
+    std::string names;
+    for (SymbolId id = 0; id < symbols.size(); id++) {
+        const auto &symbol = symbols.get_symbol(id);
+        auto kind = ProductionSymbol::Kind::Terminal;
+        if (symbol.is_EOI())
+            kind = ProductionSymbol::Kind::EndOfInput;
+        else if (symbols.is_nonterminal(id))
+            kind = ProductionSymbol::Kind::NonTerminal;
+        kinds.push_back(static_cast<std::uint8_t>(kind));
+        dense_indices.push_back(symbols.is_nonterminal(id) ? symbols.nonterminal_index(id)
+                                                           : symbols.terminal_index(id));
+        row_of.push_back(symbols.nonterminal_index(id));
+        column_of.push_back(symbols.terminal_index(id));
+        append_string(symbol.get_raw_symbol().value_or(""), names, name_offsets);
+    }
+    writer.add(SymbolKinds, kinds);
+    writer.add(DenseIndices, dense_indices);
+    writer.add(TerminalIds, symbols.get_terminals());
+    writer.add(NonterminalIds, symbols.get_nonterminals());
+    writer.add(NameOffsets, name_offsets);
+    writer.add(Names, std::span<const char>{names});
+
+    std::vector<SymbolId> LHS;
+    std::vector<std::uint32_t> RHS_offsets{0};
+    std::vector<SymbolId> RHS_symbols;
+    for (LLTable::ProductionIndex production = 0; production < table.num_productions();
+         production++) {
+        LHS.push_back(table.get_LHS(production));
+        const auto RHS = table.get_RHS(production);
+        RHS_symbols.insert(RHS_symbols.end(), RHS.begin(), RHS.end());
+        RHS_offsets.push_back(static_cast<std::uint32_t>(RHS_symbols.size()));
+    }
+    writer.add(ProductionLHS, LHS);
+    writer.add(RHSOffsets, RHS_offsets);
+    writer.add(RHSSymbols, RHS_symbols);
+
+    DenseBitset nullable(symbols.num_nonterminals());
+    std::vector<std::uint64_t> first_sets, follow_sets;
+    for (auto nonterminal : symbols.get_nonterminals()) {
+        if (engine.is_nullable(nonterminal))
+            nullable.set(symbols.nonterminal_index(nonterminal));
+        const auto &first = engine.first(nonterminal).get_words();
+        const auto &follow = engine.follow(nonterminal).get_words();
+        first_sets.insert(first_sets.end(), first.begin(), first.end());
+        follow_sets.insert(follow_sets.end(), follow.begin(), follow.end());
+    }
+    writer.add(Nullable, nullable.get_words());
+    writer.add(FirstSets, first_sets);
+    writer.add(FollowSets, follow_sets);
+    writer.add(RowOf, row_of);
+    writer.add(ColumnOf, column_of);
+    writer.add(Cells, table.get_cells());
+    const auto &terminal_hash = table.get_terminal_hash();
+    header.hash_seed = terminal_hash.get_seed();
+    header.num_hash_slots = static_cast<std::uint32_t>(terminal_hash.size());
+    writer.add(HashDisplacements, terminal_hash.get_displacements());
+    writer.add(TerminalOfSlot, table.get_terminal_of_slot());
+
+    std::vector<std::uint32_t> token_offsets{0};
+    std::string token_text;
+    for (const auto &definition : grammar.get_token_definitions()) {
+        append_string(definition.name, token_text, token_offsets);
+        append_string(definition.pattern, token_text, token_offsets);
+    }
+    header.num_token_definitions = static_cast<std::uint32_t>(token_offsets.size() / 2);
+    writer.add(TokenOffsets, token_offsets);
+    writer.add(TokenText, std::span<const char>{token_text});
+
+    const auto lexer = generate_lexer(grammar.get_token_definitions(), symbols);
+    header.num_lexer_states = static_cast<std::uint32_t>(lexer.num_states());
+    header.num_lexer_classes = static_cast<std::uint32_t>(lexer.num_classes());
+    std::vector<std::uint8_t> byte_classes(256);
+    for (unsigned byte = 0; byte < 256; byte++)
+        byte_classes[byte] = lexer.byte_class(static_cast<unsigned char>(byte));
+    writer.add(ByteClasses, byte_classes);
+    writer.add(LexerTransitions, lexer.get_transitions());
+    writer.add(LexerAccepting, lexer.get_accepting());
+    writer.add(LexerLoopOf, lexer.get_loop_of());
+    writer.add(LexerLoops, lexer.get_loops());
+    writer.add(TokenSymbols, std::span<const SymbolId>{lexer.token_symbols});
+    return writer.finish();
+}
+
+std::optional<CompiledGrammar> CompiledGrammar::open(const std::string &path,
+                                                     std::uint64_t grammar_hash)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (fd < 0 || fstat(fd, &status) != 0) {
+        if (fd >= 0)
+            close(fd);
+        return std::nullopt;
+    }
+    const auto file_size = static_cast<std::size_t>(status.st_size);
+    void *memory = file_size < sizeof(Header)
+                       ? MAP_FAILED
+                       : mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+        return std::nullopt;
+    CompiledGrammar compiled(std::shared_ptr<const std::byte>(
+        static_cast<const std::byte *>(memory),
+        [file_size](const std::byte *mapping) {
+            munmap(const_cast<std::byte *>(mapping), file_size);
+        }));
+
+    const auto &header = *reinterpret_cast<const Header *>(memory);
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 ||
+        header.version != format_version || header.byte_order != byte_order_mark ||
+        header.grammar_hash != grammar_hash)
+        return std::nullopt;
+
+    for (std::size_t s = 0; s < NumSections; s++) {
+        const auto [offset, bytes] = header.sections[s];
+        if (offset % section_alignment != 0 || offset > file_size || bytes > file_size - offset ||
+            bytes % element_sizes[s] != 0)
+            return std::nullopt;
+        const auto expected = expected_count(header, s);
+        if (expected != std::numeric_limits<std::size_t>::max() &&
+            bytes / element_sizes[s] != expected)
+            return std::nullopt;
+    }
+    if (!compiled.is_consistent())
+        return std::nullopt;
+    return compiled;
+}
+
+bool CompiledGrammar::is_consistent() const
+{
+    const auto &header = *reinterpret_cast<const Header *>(data);
+    // ε counts as neither
+    if (header.num_symbols < 2 ||
+        std::size_t{header.num_terminals} + header.num_nonterminals + 1 != header.num_symbols)
+        return false;
+
+    // the strings and right hand sides have to end where their offsets say
+    auto ends_at = [&](Section offsets_section, std::size_t end) {
+        const auto offsets = section<std::uint32_t>(offsets_section);
+        return std::is_sorted(offsets.begin(), offsets.end()) && offsets.back() == end;
+    };
+    if (!ends_at(NameOffsets, header.sections[Names][1]) ||
+        !ends_at(RHSOffsets, header.sections[RHSSymbols][1] / sizeof(SymbolId)) ||
+        !ends_at(TokenOffsets, header.sections[TokenText][1]))
+        return false;
+
+    // the dense indices have to be the ones interning in id order hands out
+    const auto kinds = section<std::uint8_t>(SymbolKinds);
+    const auto dense_indices = section<std::uint32_t>(DenseIndices);
+    if (dense_indices[SymbolTable::epsilon_id] != SymbolTable::no_index ||
+        symbol_kind(SymbolTable::eoi_id) != ProductionSymbol::Kind::EndOfInput)
+        return false;
+    std::uint32_t terminals = 0, nonterminals = 0;
+    for (SymbolId id = SymbolTable::eoi_id; id < header.num_symbols; id++) {
+        const auto kind = static_cast<ProductionSymbol::Kind>(kinds[id]);
+        if (kind == ProductionSymbol::Kind::NonTerminal) {
+            if (dense_indices[id] != nonterminals++)
+                return false;
+        } else if ((kind != ProductionSymbol::Kind::Terminal && id != SymbolTable::eoi_id) ||
+                   dense_indices[id] != terminals++) {
+            return false;
+        }
+    }
+    if (terminals != header.num_terminals || nonterminals != header.num_nonterminals)
+        return false;
+    // and the arrays the tables index with are the ones the dense indices make up
+    const auto terminal_ids = section<SymbolId>(TerminalIds);
+    const auto nonterminal_ids = section<SymbolId>(NonterminalIds);
+    const auto row_of = section<std::uint32_t>(RowOf);
+    const auto column_of = section<std::uint32_t>(ColumnOf);
+    for (SymbolId id = 0; id < header.num_symbols; id++) {
+        const bool nonterminal = symbol_kind(id) == ProductionSymbol::Kind::NonTerminal;
+        const auto index = dense_indices[id];
+        if (id != SymbolTable::epsilon_id &&
+            (nonterminal ? nonterminal_ids : terminal_ids)[index] != id)
+            return false;
+        if (row_of[id] != (nonterminal ? index : SymbolTable::no_index) ||
+            column_of[id] != (nonterminal || id == SymbolTable::epsilon_id
+                                  ? SymbolTable::no_index
+                                  : index))
+            return false;
+    }
+    // or interning them again would hand out fewer ids
+    std::unordered_set<std::string_view> names[2];
+    for (SymbolId id = SymbolTable::eoi_id + 1; id < header.num_symbols; id++)
+        if (!names[kinds[id] == static_cast<std::uint8_t>(ProductionSymbol::Kind::NonTerminal)]
+                 .insert(symbol_name(id))
+                 .second)
+            return false;
+
+    auto is_nonterminal = [&](SymbolId id) {
+        return id < header.num_symbols &&
+               symbol_kind(id) == ProductionSymbol::Kind::NonTerminal;
+    };
+    auto is_terminal = [&](SymbolId id) {
+        return id < header.num_symbols && id != SymbolTable::epsilon_id && !is_nonterminal(id);
+    };
+    const auto LHS = section<SymbolId>(ProductionLHS);
+    const auto RHS = section<SymbolId>(RHSSymbols);
+    const auto cells = section<ProductionIndex>(Cells);
+    if (!is_nonterminal(header.start_symbol) ||
+        !std::all_of(LHS.begin(), LHS.end(), is_nonterminal) ||
+        !std::all_of(RHS.begin(), RHS.end(),
+                     [&](SymbolId id) { return id < header.num_symbols; }) ||
+        !std::all_of(cells.begin(), cells.end(), [&](ProductionIndex production) {
+            return production == LLTable::no_production || production < header.num_productions;
+        }))
+        return false;
+
+    // the perfect hash has a slot for every terminal but $
+    const auto terminal_of_slot = section<SymbolId>(TerminalOfSlot);
+    if (header.num_hash_slots + std::size_t{1} != header.num_terminals ||
+        (header.num_hash_slots == 0) != section<std::uint32_t>(HashDisplacements).empty() ||
+        !std::all_of(terminal_of_slot.begin(), terminal_of_slot.end(), is_terminal))
+        return false;
+
+    return is_lexer_consistent();
+}
+
+bool CompiledGrammar::is_lexer_consistent() const
+{
+    const auto &header = *reinterpret_cast<const Header *>(data);
+    const auto states = header.num_lexer_states;
+    const auto byte_classes = section<std::uint8_t>(ByteClasses);
+    const auto transitions = section<LexerTable::StateId>(LexerTransitions);
+    const auto accepting = section<LexerTable::TokenIndex>(LexerAccepting);
+    const auto loop_of = section<std::uint32_t>(LexerLoopOf);
+    const auto loops = section<ByteSet>(LexerLoops);
+    const auto token_symbols = section<SymbolId>(TokenSymbols);
+    if (states <= LexerTable::start_state ||
+        !std::all_of(byte_classes.begin(), byte_classes.end(),
+                     [&](std::uint8_t byte_class) {
+                         return byte_class < header.num_lexer_classes;
+                     }) ||
+        !std::all_of(transitions.begin(), transitions.end(),
+                     [&](LexerTable::StateId state) { return state < states; }) ||
+        !std::all_of(accepting.begin(), accepting.end(),
+                     [&](LexerTable::TokenIndex token) {
+                         return token == LexerTable::no_token ||
+                                token < header.num_token_definitions;
+                     }) ||
+        !std::all_of(loop_of.begin(), loop_of.end(), [&](std::uint32_t loop) {
+            return loop == LexerTable::no_loop || loop < loops.size();
+        }))
+        return false;
+    return std::all_of(token_symbols.begin(), token_symbols.end(), [&](SymbolId id) {
+        return id == SymbolTable::epsilon_id || id == SymbolTable::invalid_id ||
+               (id < header.num_symbols &&
+                symbol_kind(id) != ProductionSymbol::Kind::NonTerminal);
+    });
+}
+
+template <typename T> std::span<const T> CompiledGrammar::section(std::size_t index) const
+{
+    const auto &header = *reinterpret_cast<const Header *>(data);
+    const auto [offset, bytes] = header.sections[index];
+    return {reinterpret_cast<const T *>(data + offset), bytes / sizeof(T)};
+}
+
+std::size_t CompiledGrammar::num_symbols() const
+{
+    return reinterpret_cast<const Header *>(data)->num_symbols;
+}
+
+std::size_t CompiledGrammar::num_terminals() const
+{
+    return reinterpret_cast<const Header *>(data)->num_terminals;
+}
+
+std::size_t CompiledGrammar::num_nonterminals() const
+{
+    return reinterpret_cast<const Header *>(data)->num_nonterminals;
+}
+
+std::string_view CompiledGrammar::symbol_name(SymbolId id) const
+{
+    const auto offsets = section<std::uint32_t>(NameOffsets);
+    const auto names = section<char>(Names);
+    return {names.data() + offsets[id], offsets[id + 1] - offsets[id]};
+}
+
+ProductionSymbol::Kind CompiledGrammar::symbol_kind(SymbolId id) const
+{
+    return static_cast<ProductionSymbol::Kind>(section<std::uint8_t>(SymbolKinds)[id]);
+}
+
+SymbolId CompiledGrammar::get_start_symbol() const
+{
+    return reinterpret_cast<const Header *>(data)->start_symbol;
+}
+
+std::size_t CompiledGrammar::num_productions() const
+{
+    return reinterpret_cast<const Header *>(data)->num_productions;
+}
+
+SymbolId CompiledGrammar::get_LHS(ProductionIndex production) const
+{
+    return section<SymbolId>(ProductionLHS)[production];
+}
+
+std::span<const SymbolId> CompiledGrammar::get_RHS(ProductionIndex production) const
+{
+    const auto offsets = section<std::uint32_t>(RHSOffsets);
+    return section<SymbolId>(RHSSymbols)
+        .subspan(offsets[production], offsets[production + 1] - offsets[production]);
+}
+
+bool CompiledGrammar::is_nullable(SymbolId nonterminal) const
+{
+    const auto index = section<std::uint32_t>(DenseIndices)[nonterminal];
+    return (section<std::uint64_t>(Nullable)[index / 64] >> (index % 64)) & 1;
+}
+
+std::span<const std::uint64_t> CompiledGrammar::set(std::size_t section_index,
+                                                    SymbolId nonterminal) const
+{
+    const auto words = words_per_set(*reinterpret_cast<const Header *>(data));
+    const auto index = section<std::uint32_t>(DenseIndices)[nonterminal];
+    return section<std::uint64_t>(section_index).subspan(index * words, words);
+}
+
+std::span<const std::uint64_t> CompiledGrammar::first(SymbolId nonterminal) const
+{
+    return set(FirstSets, nonterminal);
+}
+
+std::span<const std::uint64_t> CompiledGrammar::follow(SymbolId nonterminal) const
+{
+    return set(FollowSets, nonterminal);
+}
+
+std::span<const CompiledGrammar::ProductionIndex> CompiledGrammar::get_cells() const
+{
+    return section<ProductionIndex>(Cells);
+}
+
+std::shared_ptr<const LLTable> CompiledGrammar::ll_table() const
+{
+    // the table goes with the mapping it views, so both live exactly as long as it is in use
+    struct MappedTable {
+        std::shared_ptr<const std::byte> mapping;
+        LLTable table;
+    };
+    auto owner = std::make_shared<MappedTable>();
+    owner->mapping = mapping;
+    const auto &header = *reinterpret_cast<const Header *>(data);
+
+    auto &symbols = owner->table.symbols;
+    symbols.kinds = view<std::uint8_t>(SymbolKinds);
+    symbols.dense_indices = view<std::uint32_t>(DenseIndices);
+    symbols.terminal_ids = view<SymbolId>(TerminalIds);
+    symbols.nonterminal_ids = view<SymbolId>(NonterminalIds);
+    symbols.symbols.clear();
+    symbols.mapped = std::make_shared<SymbolTable::Mapped>();
+    symbols.mapped->name_offsets = section<std::uint32_t>(NameOffsets);
+    symbols.mapped->names = section<char>(Names);
+
+    auto &table = owner->table;
+    table.start_symbol = header.start_symbol;
+    table.row_of = view<std::uint32_t>(RowOf);
+    table.column_of = view<std::uint32_t>(ColumnOf);
+    table.terminal_hash = PerfectHash(header.hash_seed, header.num_hash_slots,
+                                      view<std::uint32_t>(HashDisplacements));
+    table.terminal_of_slot = view<SymbolId>(TerminalOfSlot);
+    table.cells = view<ProductionIndex>(Cells);
+    table.production_LHS = view<SymbolId>(ProductionLHS);
+    table.RHS_offsets = view<std::uint32_t>(RHSOffsets);
+    table.RHS_symbols = view<SymbolId>(RHSSymbols);
+    return {owner, &owner->table};
+}
+
+std::shared_ptr<const LexerTable> CompiledGrammar::lexer_table() const
+{
+    struct MappedLexer {
+        std::shared_ptr<const std::byte> mapping;
+        LexerTable table;
+    };
+    auto owner = std::make_shared<MappedLexer>();
+    owner->mapping = mapping;
+    const auto &header = *reinterpret_cast<const Header *>(data);
+
+    std::array<std::uint8_t, 256> byte_classes;
+    std::ranges::copy(section<std::uint8_t>(ByteClasses), byte_classes.begin());
+    owner->table = LexerTable(byte_classes, header.num_lexer_classes,
+                              view<LexerTable::StateId>(LexerTransitions),
+                              view<LexerTable::TokenIndex>(LexerAccepting),
+                              view<std::uint32_t>(LexerLoopOf), view<ByteSet>(LexerLoops));
+    owner->table.token_symbols = view<SymbolId>(TokenSymbols);
+    return {owner, &owner->table};
+}
+
+std::vector<DenseBitset> CompiledGrammar::to_follow_sets() const
+{
+    // the sets are stored in dense index order already
+    const auto words = words_per_set(*reinterpret_cast<const Header *>(data));
+    const auto sets = section<std::uint64_t>(FollowSets);
+    std::vector<DenseBitset> follow_sets;
+    for (std::size_t row = 0; row < num_nonterminals(); row++) {
+        auto &follow_set = follow_sets.emplace_back(num_terminals());
+        for (std::size_t column = 0; column < num_terminals(); column++) {
+            if ((sets[row * words + column / 64] >> (column % 64)) & 1)
+                follow_set.set(column);
+        }
+    }
+    return follow_sets;
+}
+
+std::vector<TokenDefinition> CompiledGrammar::to_token_definitions() const
+{
+    const auto offsets = section<std::uint32_t>(TokenOffsets);
+    const auto text = section<char>(TokenText);
+    auto string_at = [&](std::size_t i) {
+        return std::string{text.data() + offsets[i], offsets[i + 1] - offsets[i]};
+    };
+    std::vector<TokenDefinition> definitions;
+    for (std::size_t i = 0; i + 1 < offsets.size(); i += 2)
+        definitions.push_back({string_at(i), string_at(i + 1)});
+    return definitions;
+}
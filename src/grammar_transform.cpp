@@ -0,0 +1,504 @@
+#include <jacc/first_follow_engine.h>
+#include <jacc/grammar_transform.h>
+#include <jacc/trace.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// conflicts that are inherent to the language come back after every expansion, this keeps them
+// from growing the grammar forever
+constexpr int max_expansion_rounds = 8;
+constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+
+// ε productions are empty
+using Alternative = std::vector<ProductionSymbol>;
+
+void push_unique(std::vector<Alternative> &alternatives, Alternative alternative)
+{
+    if (std::find(alternatives.begin(), alternatives.end(), alternative) == alternatives.end())
+        alternatives.push_back(std::move(alternative));
+}
+
+bool starts_with(const Alternative &alternative, const ProductionSymbol &symbol)
+{
+    return !alternative.empty() && alternative.front() == symbol;
+}
+
+/**
+ * A grammar that is cheap to edit, rules are found by name and new rules are appended.
+ */
+struct WorkingGrammar {
+    struct Rule {
+        ProductionSymbol LHS;
+        std::vector<Alternative> alternatives;
+    };
+    std::vector<Rule> rules;
+    std::unordered_map<std::string, std::size_t> rule_of;
+    // every symbol name in use, so new nonterminals don't clash with terminals either
+    std::unordered_set<std::string> names;
+
+    explicit WorkingGrammar(const Grammar &grammar)
+    {
+        const auto &symbols = grammar.get_symbol_table();
+        for (SymbolId id = 0; id < symbols.size(); ++id)
+            if (const auto &name = symbols.get_symbol(id).get_raw_symbol())
+                names.insert(*name);
+
+        for (const auto &rule : grammar.get_rules()) {
+            auto found = rule_of.find(*rule.get_LHS().get_raw_symbol());
+            const auto index = found != rule_of.end() ? found->second
+                                                      : add_rule(rule.get_LHS(), {});
+            for (const auto &production : rule.get_productions()) {
+                Alternative alternative;
+                for (const auto &symbol : production.get_production_symbols())
+                    if (!symbol.is_epsilon())
+                        alternative.push_back(symbol);
+                push_unique(rules[index].alternatives, std::move(alternative));
+            }
+        }
+    }
+
+    const Rule *find(const ProductionSymbol &LHS) const
+    {
+        if (!LHS.is_nonTerminal())
+            return nullptr;
+        auto found = rule_of.find(*LHS.get_raw_symbol());
+        return found != rule_of.end() ? &rules[found->second] : nullptr;
+    }
+
+    std::size_t add_rule(ProductionSymbol LHS, std::vector<Alternative> alternatives)
+    {
+        rule_of.emplace(*LHS.get_raw_symbol(), rules.size());
+        rules.push_back({std::move(LHS), std::move(alternatives)});
+        return rules.size() - 1;
+    }
+
+    ProductionSymbol fresh_nonterminal(const ProductionSymbol &base)
+    {
+        auto name = *base.get_raw_symbol() + "'";
+        while (!names.insert(name).second)
+            name += "'";
+        return ProductionSymbol(std::move(name), ProductionSymbol::Kind::NonTerminal);
+    }
+
+    /**
+     * With reachable_only, rules that can't be reached from the start symbol are left out.
+     */
+    Grammar to_grammar(bool reachable_only) const
+    {
+        std::vector<bool> reachable(rules.size(), !reachable_only);
+        std::vector<std::size_t> worklist;
+        if (reachable_only && !rules.empty()) {
+            reachable[0] = true;
+            worklist.push_back(0);
+        }
+        while (!worklist.empty()) {
+            const auto &rule = rules[worklist.back()];
+            worklist.pop_back();
+            for (const auto &alternative : rule.alternatives)
+                for (const auto &symbol : alternative)
+                    if (const auto *target = find(symbol)) {
+                        const auto index = static_cast<std::size_t>(target - rules.data());
+                        if (!reachable[index]) {
+                            reachable[index] = true;
+                            worklist.push_back(index);
+                        }
+                    }
+        }
+
+        std::vector<GrammarRule> grammar_rules;
+        for (std::size_t index = 0; index < rules.size(); ++index) {
+            if (!reachable[index])
+                continue;
+            std::vector<Production> productions;
+            for (const auto &alternative : rules[index].alternatives)
+                productions.push_back(alternative.empty()
+                                          ? Production(ProductionSymbol::create_epsilon())
+                                          : Production(alternative));
+            grammar_rules.emplace_back(rules[index].LHS, std::move(productions));
+        }
+        return Grammar(std::move(grammar_rules));
+    }
+};
+
+Grammar finish(const WorkingGrammar &working, const Grammar &original)
+{
+    auto grammar = working.to_grammar(true);
+    grammar.set_token_definitions(original.get_token_definitions());
+    JACC_DEBUG("rewrote {} rules into {}", original.get_rules().size(), grammar.get_rules().size());
+    return grammar;
+}
+
+/**
+ * Which rules derive ε, by rule index.
+ */
+std::vector<bool> nullable_rules(const WorkingGrammar &g)
+{
+    std::vector<bool> nullable(g.rules.size());
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (std::size_t index = 0; index < g.rules.size(); ++index) {
+            if (nullable[index])
+                continue;
+            for (const auto &alternative : g.rules[index].alternatives) {
+                if (std::all_of(alternative.begin(), alternative.end(), [&](const auto &symbol) {
+                        const auto *rule = g.find(symbol);
+                        return rule && nullable[static_cast<std::size_t>(rule - g.rules.data())];
+                    })) {
+                    nullable[index] = changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    return nullable;
+}
+
+/**
+ * The rules an alternative can start deriving with, every nonterminal up to and including the
+ * first symbol that isn't nullable.
+ */
+template <typename F>
+void for_each_leftmost(const WorkingGrammar &g, const std::vector<bool> &nullable,
+                       std::span<const ProductionSymbol> alternative, F &&f)
+{
+    for (const auto &symbol : alternative) {
+        const auto *rule = g.find(symbol);
+        if (!rule)
+            return;
+        const auto index = static_cast<std::size_t>(rule - g.rules.data());
+        f(index);
+        if (!nullable[index])
+            return;
+    }
+}
+
+/**
+ * The strongly connected components of the graph with an edge from every rule to the rules
+ * its alternatives can start with, that contain a cycle. Each is a group of nonterminals that
+ * derive each other in leftmost position, sorted in rule order. Iterative Tarjan, so deep
+ * grammars don't overflow the stack.
+ */
+std::vector<std::vector<std::size_t>> left_recursive_components(const WorkingGrammar &g,
+                                                                const std::vector<bool> &nullable)
+{
+    const auto num_rules = g.rules.size();
+    std::vector<std::vector<std::size_t>> edges(num_rules);
+    for (std::size_t index = 0; index < num_rules; ++index)
+        for (const auto &alternative : g.rules[index].alternatives)
+            for_each_leftmost(g, nullable, alternative,
+                              [&](std::size_t target) { edges[index].push_back(target); });
+
+    struct Frame {
+        std::size_t rule;
+        std::size_t next_edge;
+    };
+    std::vector<std::size_t> order(num_rules, none), low(num_rules);
+    std::vector<bool> on_stack(num_rules);
+    std::vector<std::size_t> stack;
+    std::vector<Frame> calls;
+    std::vector<std::vector<std::size_t>> components;
+    std::size_t counter = 0;
+    auto visit = [&](std::size_t rule) {
+        order[rule] = low[rule] = counter++;
+        stack.push_back(rule);
+        on_stack[rule] = true;
+        calls.push_back({rule, 0});
+    };
+
+    for (std::size_t root = 0; root < num_rules; ++root) {
+        if (order[root] != none)
+            continue;
+        visit(root);
+        while (!calls.empty()) {
+            const auto rule = calls.back().rule;
+            if (calls.back().next_edge < edges[rule].size()) {
+                const auto target = edges[rule][calls.back().next_edge++];
+                if (order[target] == none)
+                    visit(target);
+                else if (on_stack[target])
+                    low[rule] = std::min(low[rule], order[target]);
+                continue;
+            }
+            calls.pop_back();
+            if (!calls.empty())
+                low[calls.back().rule] = std::min(low[calls.back().rule], low[rule]);
+            if (low[rule] != order[rule])
+                continue;
+
+            std::vector<std::size_t> component;
+            std::size_t member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                on_stack[member] = false;
+                component.push_back(member);
+            } while (member != rule);
+            const auto &self = edges[rule];
+            if (component.size() > 1 || std::find(self.begin(), self.end(), rule) != self.end()) {
+                std::sort(component.begin(), component.end());
+                components.push_back(std::move(component));
+            }
+        }
+    }
+    return components;
+}
+
+/**
+ * Replaces every alternative of target that starts with the LHS of source by the alternatives of
+ * source, followed by the rest of the alternative.
+ */
+void substitute_leading(WorkingGrammar &g, std::size_t target, std::size_t source)
+{
+    const auto &replacements = g.rules[source].alternatives;
+    const auto &LHS = g.rules[source].LHS;
+    std::vector<Alternative> result;
+    for (auto &alternative : g.rules[target].alternatives) {
+        if (!starts_with(alternative, LHS)) {
+            push_unique(result, std::move(alternative));
+            continue;
+        }
+        for (const auto &replacement : replacements) {
+            auto substituted = replacement;
+            substituted.insert(substituted.end(), alternative.begin() + 1, alternative.end());
+            push_unique(result, std::move(substituted));
+        }
+    }
+    g.rules[target].alternatives = std::move(result);
+}
+
+void remove_direct_left_recursion(WorkingGrammar &g, std::size_t index)
+{
+    const auto LHS = g.rules[index].LHS;
+    auto &alternatives = g.rules[index].alternatives;
+    // A : A; derives nothing new
+    std::erase_if(alternatives, [&](const Alternative &a) { return a.size() == 1 && a[0] == LHS; });
+    const auto recursive = std::count_if(alternatives.begin(), alternatives.end(),
+                                         [&](const Alternative &a) { return starts_with(a, LHS); });
+    if (recursive == 0)
+        return;
+    if (static_cast<std::size_t>(recursive) == alternatives.size()) {
+        JACC_DEBUG("{} is left recursive without another alternative, left as is", LHS);
+        return;
+    }
+
+    const auto tail = g.fresh_nonterminal(LHS);
+    std::vector<Alternative> bases;
+    std::vector<Alternative> tails;
+    for (auto &alternative : alternatives) {
+        if (!starts_with(alternative, LHS)) {
+            alternative.push_back(tail);
+            bases.push_back(std::move(alternative));
+            continue;
+        }
+        Alternative rest(alternative.begin() + 1, alternative.end());
+        // A : A a A; the trailing A already ends in A', so A' : a A; is enough
+        if (rest.back() != LHS)
+            rest.push_back(tail);
+        push_unique(tails, std::move(rest));
+    }
+    tails.emplace_back();
+    alternatives = std::move(bases);
+    g.add_rule(tail, std::move(tails));
+}
+
+/**
+ * Replaces the leading nullable nonterminal of every alternative in a left recursive component
+ * that only reaches the component past that nonterminal, A : B A x; B : ε | z; becomes
+ * A : A x | z A x;, so that Paull's algorithm sees the recursion. Returns the components that
+ * are left once no recursion is hidden anymore, or after a bounded number of rounds.
+ */
+std::vector<std::vector<std::size_t>> expose_hidden_left_recursion(WorkingGrammar &g)
+{
+    auto nullable = nullable_rules(g);
+    auto components = left_recursive_components(g, nullable);
+    for (int round = 0; round < max_expansion_rounds; ++round) {
+        bool expanded = false;
+        for (const auto &component : components) {
+            for (const auto member : component) {
+                auto &rule = g.rules[member];
+                std::vector<Alternative> result;
+                for (auto &alternative : rule.alternatives) {
+                    const auto *leading = alternative.empty() || alternative[0] == rule.LHS
+                                              ? nullptr
+                                              : g.find(alternative[0]);
+                    bool hidden = false;
+                    if (leading && nullable[static_cast<std::size_t>(leading - g.rules.data())])
+                        for_each_leftmost(g, nullable, std::span{alternative}.subspan(1),
+                                          [&](std::size_t target) {
+                                              hidden |= std::binary_search(
+                                                  component.begin(), component.end(), target);
+                                          });
+                    if (!hidden) {
+                        push_unique(result, std::move(alternative));
+                        continue;
+                    }
+                    for (const auto &replacement : leading->alternatives) {
+                        auto substituted = replacement;
+                        substituted.insert(substituted.end(), alternative.begin() + 1,
+                                           alternative.end());
+                        push_unique(result, std::move(substituted));
+                    }
+                    expanded = true;
+                }
+                rule.alternatives = std::move(result);
+            }
+        }
+        if (!expanded)
+            break;
+        nullable = nullable_rules(g);
+        components = left_recursive_components(g, nullable);
+    }
+    return components;
+}
+
+/**
+ * Paull's algorithm, applied to each left recursive component on its own. It runs against rule
+ * order, so the recursion ends up in the earliest rule of the component, which is usually the one
+ * the rest of the grammar refers to, and the later ones often become unreachable.
+ */
+void remove_left_recursion(WorkingGrammar &g)
+{
+    for (auto component : expose_hidden_left_recursion(g)) {
+        std::reverse(component.begin(), component.end());
+        for (std::size_t i = 0; i < component.size(); ++i) {
+            for (std::size_t j = 0; j < i; ++j)
+                substitute_leading(g, component[i], component[j]);
+            remove_direct_left_recursion(g, component[i]);
+        }
+    }
+}
+
+/**
+ * Factors every group of alternatives of a rule that start with the same symbol. The new rules
+ * are appended, so looping over the rules in order factors them as well.
+ */
+void factor_rules(WorkingGrammar &g)
+{
+    for (std::size_t index = 0; index < g.rules.size(); ++index) {
+        for (std::size_t i = 0; i < g.rules[index].alternatives.size(); ++i) {
+            auto &alternatives = g.rules[index].alternatives;
+            const auto &first = alternatives[i];
+            if (first.empty())
+                continue;
+            std::vector<std::size_t> group{i};
+            auto prefix = first.size();
+            for (auto j = i + 1; j < alternatives.size(); ++j) {
+                const auto &other = alternatives[j];
+                if (!starts_with(other, first.front()))
+                    continue;
+                group.push_back(j);
+                const auto common = std::mismatch(first.begin(), first.end(), other.begin(),
+                                                  other.end());
+                prefix = std::min(prefix, static_cast<std::size_t>(common.first - first.begin()));
+            }
+            if (group.size() == 1)
+                continue;
+
+            Alternative factored(first.begin(), first.begin() + static_cast<long>(prefix));
+            std::vector<Alternative> suffixes;
+            for (auto member : group)
+                push_unique(suffixes, Alternative(alternatives[member].begin() +
+                                                      static_cast<long>(prefix),
+                                                  alternatives[member].end()));
+            for (auto member = group.rbegin(); *member != i; ++member)
+                alternatives.erase(alternatives.begin() + static_cast<long>(*member));
+
+            const auto tail = g.fresh_nonterminal(g.rules[index].LHS);
+            factored.push_back(tail);
+            alternatives[i] = std::move(factored);
+            // invalidates alternatives
+            g.add_rule(tail, std::move(suffixes));
+        }
+    }
+}
+
+/**
+ * Replaces the leading nonterminal of every alternative whose FIRST set overlaps with another
+ * alternative of the same rule by that nonterminal's alternatives. Returns whether anything was
+ * expanded.
+ */
+bool expand_overlapping_alternatives(WorkingGrammar &g)
+{
+    const auto grammar = g.to_grammar(false);
+    const FirstFollowEngine engine(grammar);
+    const auto &symbols = grammar.get_symbol_table();
+
+    bool expanded = false;
+    std::vector<SymbolId> ids;
+    std::vector<DenseBitset> firsts;
+    for (auto &rule : g.rules) {
+        firsts.clear();
+        for (const auto &alternative : rule.alternatives) {
+            ids.clear();
+            for (const auto &symbol : alternative)
+                ids.push_back(symbols.find(symbol));
+            bool nullable;
+            firsts.push_back(engine.first(ids, nullable));
+        }
+
+        std::vector<Alternative> result;
+        bool changed = false;
+        for (std::size_t i = 0; i < rule.alternatives.size(); ++i) {
+            auto &alternative = rule.alternatives[i];
+            bool overlaps = false;
+            for (std::size_t j = 0; j < firsts.size() && !overlaps; ++j)
+                overlaps = j != i && firsts[i].intersects(firsts[j]);
+            const auto *corner = overlaps && !alternative.empty() && alternative[0] != rule.LHS
+                                     ? g.find(alternative[0])
+                                     : nullptr;
+            if (!corner) {
+                push_unique(result, std::move(alternative));
+                continue;
+            }
+            for (const auto &replacement : corner->alternatives) {
+                auto substituted = replacement;
+                substituted.insert(substituted.end(), alternative.begin() + 1, alternative.end());
+                push_unique(result, std::move(substituted));
+            }
+            changed = true;
+        }
+        rule.alternatives = std::move(result);
+        expanded |= changed;
+    }
+    return expanded;
+}
+} // namespace
+
+Grammar eliminate_left_recursion(const Grammar &grammar)
+{
+    WorkingGrammar working(grammar);
+    remove_left_recursion(working);
+    return finish(working, grammar);
+}
+
+Grammar left_factor(const Grammar &grammar)
+{
+    WorkingGrammar working(grammar);
+    factor_rules(working);
+    return finish(working, grammar);
+}
+
+Grammar rewrite_for_ll(const Grammar &grammar)
+{
+    WorkingGrammar working(grammar);
+    remove_left_recursion(working);
+    factor_rules(working);
+    for (int round = 0; round < max_expansion_rounds; ++round) {
+        if (!expand_overlapping_alternatives(working))
+            break;
+        // expanding B x into A x | ... can make a rule left recursive again
+        remove_left_recursion(working);
+        factor_rules(working);
+    }
+    return finish(working, grammar);
+}
@@ -0,0 +1,250 @@
+#include <jacc/lalr_table_generator.h>
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+/**
+ * A relation over n nodes in compressed row form: the edges of node x are
+ * targets[offsets[x], offsets[x + 1]).
+ */
+struct Relation {
+    std::vector<std::uint32_t> offsets;
+    std::vector<std::uint32_t> targets;
+
+    static Relation from_pairs(std::size_t n,
+                               const std::vector<std::pair<std::uint32_t, std::uint32_t>> &pairs)
+    {
+        Relation relation;
+        relation.offsets.assign(n + 1, 0);
+        for (const auto &[from, to] : pairs)
+            relation.offsets[from + 1]++;
+        for (std::size_t i = 1; i <= n; i++)
+            relation.offsets[i] += relation.offsets[i - 1];
+        relation.targets.resize(pairs.size());
+        auto fill = relation.offsets;
+        for (const auto &[from, to] : pairs)
+            relation.targets[fill[from]++] = to;
+        return relation;
+    }
+};
+
+/**
+ * The digraph algorithm from DeRemer and Pennello: afterwards sets[x] is the union of its initial
+ * value and sets[y] for every y reachable from x. Nodes of a strongly connected component end up
+ * sharing one set. Written with an explicit call stack, so long chains can't overflow the stack.
+ */
+void digraph(std::vector<DenseBitset> &sets, const Relation &relation)
+{
+    constexpr auto infinity = std::numeric_limits<std::uint32_t>::max();
+    const auto n = sets.size();
+    std::vector<std::uint32_t> depth(n, 0);
+    std::vector<std::uint32_t> stack;
+    struct Frame {
+        std::uint32_t node;
+        std::uint32_t next_edge;
+        std::uint32_t entry_depth;
+    };
+    std::vector<Frame> calls;
+
+    auto enter = [&](std::uint32_t node) {
+        stack.push_back(node);
+        depth[node] = static_cast<std::uint32_t>(stack.size());
+        calls.push_back({node, relation.offsets[node], depth[node]});
+    };
+
+    for (std::uint32_t root = 0; root < n; root++) {
+        if (depth[root] != 0)
+            continue;
+        enter(root);
+        while (!calls.empty()) {
+            auto &frame = calls.back();
+            const auto x = frame.node;
+            if (frame.next_edge < relation.offsets[x + 1]) {
+                const auto y = relation.targets[frame.next_edge++];
+                if (depth[y] == 0) {
+                    enter(y);
+                    continue;
+                }
+                depth[x] = std::min(depth[x], depth[y]);
+                sets[x].merge(sets[y]);
+                continue;
+            }
+
+            const auto entry_depth = frame.entry_depth;
+            calls.pop_back();
+            if (depth[x] == entry_depth) {
+                while (true) {
+                    const auto top = stack.back();
+                    stack.pop_back();
+                    depth[top] = infinity;
+                    if (top == x)
+                        break;
+                    sets[top] = sets[x];
+                }
+            }
+            if (!calls.empty()) {
+                const auto parent = calls.back().node;
+                depth[parent] = std::min(depth[parent], depth[x]);
+                sets[parent].merge(sets[x]);
+            }
+        }
+    }
+}
+
+/**
+ * All nonterminal transitions (p, A) of the automaton. Transitions leaving the same state are
+ * contiguous and sorted by nonterminal, so (p, A) can be found by binary search.
+ */
+struct NonterminalTransitions {
+    std::vector<LRAutomaton::StateId> from;
+    std::vector<SymbolId> nonterminal;
+    std::vector<LRAutomaton::StateId> to;
+    std::vector<std::uint32_t> state_offsets;
+
+    explicit NonterminalTransitions(const LRAutomaton &automaton)
+    {
+        const auto &symbols = automaton.get_symbol_table();
+        state_offsets.push_back(0);
+        for (LRAutomaton::StateId state = 0; state < automaton.num_states(); state++) {
+            for (const auto &transition : automaton.get_transitions(state)) {
+                if (!symbols.is_nonterminal(transition.symbol))
+                    continue;
+                from.push_back(state);
+                nonterminal.push_back(transition.symbol);
+                to.push_back(transition.target);
+            }
+            state_offsets.push_back(static_cast<std::uint32_t>(from.size()));
+        }
+    }
+
+    std::size_t size() const { return from.size(); }
+
+    std::uint32_t find(LRAutomaton::StateId state, SymbolId symbol) const
+    {
+        auto begin = nonterminal.begin() + state_offsets[state];
+        auto end = nonterminal.begin() + state_offsets[state + 1];
+        return static_cast<std::uint32_t>(std::lower_bound(begin, end, symbol) -
+                                          nonterminal.begin());
+    }
+};
+} // namespace
+
+std::vector<DenseBitset> compute_lalr_lookaheads(const LRAutomaton &automaton,
+                                                 const FirstFollowEngine &sets)
+{
+    const auto &symbols = automaton.get_symbol_table();
+    const NonterminalTransitions transitions(automaton);
+    const auto start_symbol =
+        symbols.num_nonterminals() > 0 ? symbols.nonterminal_at(0) : SymbolTable::invalid_id;
+
+    // DR(p, A) is every terminal that can be shifted right after the transition, reads connects
+    // (p, A) to (r, C) when C is nullable and can follow A
+    std::vector<DenseBitset> follow(transitions.size(), DenseBitset(symbols.num_terminals()));
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> reads;
+    for (std::uint32_t t = 0; t < transitions.size(); t++) {
+        if (transitions.from[t] == 0 && transitions.nonterminal[t] == start_symbol)
+            follow[t].set(symbols.terminal_index(SymbolTable::eoi_id));
+        for (const auto &next : automaton.get_transitions(transitions.to[t])) {
+            if (symbols.is_terminal(next.symbol))
+                follow[t].set(symbols.terminal_index(next.symbol));
+            else if (sets.is_nullable(next.symbol))
+                reads.emplace_back(t, transitions.find(transitions.to[t], next.symbol));
+        }
+    }
+    digraph(follow, Relation::from_pairs(transitions.size(), reads));
+
+    // For every (p', B) and B → ω, walk ω from p'. (p, A) includes (p', B) for every A in ω whose
+    // remainder is nullable, and the state the walk ends in looks back to (p', B)
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> includes;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> lookback;
+    for (std::uint32_t t = 0; t < transitions.size(); t++) {
+        for (auto production : automaton.get_productions_of(transitions.nonterminal[t])) {
+            const auto RHS = automaton.get_production_RHS(production);
+            auto nullable_from = RHS.size();
+            while (nullable_from > 0 && sets.is_nullable(RHS[nullable_from - 1]))
+                nullable_from--;
+
+            auto state = transitions.from[t];
+            for (std::size_t i = 0; i < RHS.size(); i++) {
+                if (symbols.is_nonterminal(RHS[i]) && i + 1 >= nullable_from)
+                    includes.emplace_back(transitions.find(state, RHS[i]), t);
+                state = automaton.get_transition(state, RHS[i]);
+            }
+            const auto reductions = automaton.get_reductions(state);
+            const auto slot = std::find(reductions.begin(), reductions.end(), production) -
+                              reductions.begin();
+            lookback.emplace_back(
+                static_cast<std::uint32_t>(automaton.get_reduction_slot(state) +
+                                           static_cast<std::size_t>(slot)),
+                t);
+        }
+    }
+    digraph(follow, Relation::from_pairs(transitions.size(), includes));
+
+    std::vector<DenseBitset> lookaheads(automaton.num_reduction_slots(),
+                                        DenseBitset(symbols.num_terminals()));
+    for (const auto &[slot, t] : lookback)
+        lookaheads[slot].merge(follow[t]);
+    return lookaheads;
+}
+
+LRTable generate_lalr_table(FirstFollowSetGenerator &sets_generator)
+{
+    const auto &sets = sets_generator.get_engine();
+    const LRAutomaton automaton(sets);
+    const auto &symbols = automaton.get_symbol_table();
+    const auto lookaheads = compute_lalr_lookaheads(automaton, sets);
+
+    LRTable table(symbols, automaton.num_states());
+    // the table leaves out the augmented production, so production p + 1 becomes p
+    for (std::size_t p = 1; p < automaton.num_productions(); p++)
+        table.add_production(automaton.get_production_LHS(p), automaton.get_production_RHS(p));
+
+    for (LRAutomaton::StateId state = 0; state < automaton.num_states(); state++) {
+        for (const auto &transition : automaton.get_transitions(state)) {
+            if (symbols.is_terminal(transition.symbol))
+                table.set_action(state, transition.symbol,
+                                 {LRTable::ActionKind::Shift, transition.target});
+            else
+                table.set_goto(state, transition.symbol, transition.target);
+        }
+    }
+    if (symbols.num_nonterminals() > 0) {
+        const auto accepting = automaton.get_transition(0, symbols.nonterminal_at(0));
+        table.set_action(accepting, SymbolTable::eoi_id, {LRTable::ActionKind::Accept, 0});
+    }
+
+    for (LRAutomaton::StateId state = 0; state < automaton.num_states(); state++) {
+        const auto reductions = automaton.get_reductions(state);
+        for (std::size_t i = 0; i < reductions.size(); i++) {
+            const auto production = reductions[i] - 1;
+            lookaheads[automaton.get_reduction_slot(state) + i].for_each([&](std::size_t column) {
+                const auto terminal = symbols.terminal_at(static_cast<std::uint32_t>(column));
+                const auto existing = table.get_action(state, terminal);
+                switch (existing.kind) {
+                case LRTable::ActionKind::Error:
+                    table.set_action(state, terminal, {LRTable::ActionKind::Reduce, production});
+                    break;
+                case LRTable::ActionKind::Shift:
+                    table.conflicts.shift_reduce++;
+                    break;
+                case LRTable::ActionKind::Reduce:
+                    table.conflicts.reduce_reduce++;
+                    if (production < existing.value)
+                        table.set_action(state, terminal,
+                                         {LRTable::ActionKind::Reduce, production});
+                    break;
+                case LRTable::ActionKind::Accept:
+                    table.conflicts.reduce_reduce++;
+                    break;
+                }
+            });
+        }
+    }
+
+    if (table.conflicts.shift_reduce + table.conflicts.reduce_reduce > 0)
+        spdlog::warn("LALR(1) table has {} shift/reduce and {} reduce/reduce conflicts",
+                     table.conflicts.shift_reduce, table.conflicts.reduce_reduce);
+    return table;
+}
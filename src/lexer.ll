@@ -1,12 +1,15 @@
 %{
 # include <string>
+# include <string_view>
 
-# include <spdlog/spdlog.h>
+# include <jacc/trace.h>
 # include <jacc/driver.h>
 # include "parser.h"
 %}
 
 %{
+  // The token as a view into the mapped grammar file, see Driver::map_input.
+  # define TOKEN_TEXT(begin, end) std::string_view (yytext + (begin), static_cast<std::size_t> (yyleng - (begin) - (end)))
 %}
 
 %option noyywrap nounput noinput batch debug
@@ -16,6 +19,7 @@ SEMICOLON ";"
 COLON ":"
 
 EPSILON "_"(EPSILON|epsilon)"_"
+REGEX "/"([^/\\\r\n]|\\.)+"/"
 NONTERMINAL [A-Z][A-Z0-9_\-']*
 TERMINAL [^ \r\n\t:;#\/\\]+
 
@@ -36,18 +40,27 @@ COMMENT "\/\/"[^\r\n]*
   yy::location& loc = drv.location;
   // Code run each time yylex is called.
   loc.step ();
+  // Skip the whitespace and comments before the token in whole runs instead of matching them
+  // byte by byte. Flex keeps the byte after the last token in yy_hold_char and a zero in its
+  // place, so that byte is put back before scanning and taken out again at the new position.
+  *yy_c_buf_p = yy_hold_char;
+  yy_c_buf_p = drv.input + drv.skip_layout (static_cast<std::size_t> (yy_c_buf_p - drv.input));
+  yy_hold_char = *yy_c_buf_p;
 %}
 
+  /* skip_layout() already took these, the rules only keep flex from echoing them */
 {WHITESPACE}   loc.step ();
 \n+            loc.lines (yyleng); loc.step ();
-{COMMENT}      loc.lines (yyleng); loc.step ();
+{COMMENT}      loc.step ();
 
-{ALT}          { spdlog::debug("lexed ALT");                     return yy::parser::make_ALTERNATIVE (loc);}
-{COLON}        { spdlog::debug("lexed COLON");                   return yy::parser::make_COLON       (loc);}
-{SEMICOLON}    { spdlog::debug("lexed SEMICOLON");               return yy::parser::make_SEMICOLON   (loc);}
-{EPSILON}      { spdlog::debug("lexed epsilon");                 return yy::parser::make_EPSILON(loc);     }
-{NONTERMINAL}  { spdlog::debug("lexed NONTERMINAL: {}", yytext); return yy::parser::make_NONTERMINAL (yytext, loc);}
-{TERMINAL}     { spdlog::debug("lexed TERMINAL: {}", yytext);    return yy::parser::make_TERMINAL    (yytext, loc);}
+{ALT}          { JACC_TRACE("lexed ALT");                     return yy::parser::make_ALTERNATIVE (loc);}
+{COLON}        { JACC_TRACE("lexed COLON");                   return yy::parser::make_COLON       (loc);}
+{SEMICOLON}    { JACC_TRACE("lexed SEMICOLON");               return yy::parser::make_SEMICOLON   (loc);}
+{EPSILON}      { JACC_TRACE("lexed epsilon");                 return yy::parser::make_EPSILON(loc);     }
+{NONTERMINAL}  { JACC_TRACE("lexed NONTERMINAL: {}", yytext); return yy::parser::make_NONTERMINAL (TOKEN_TEXT (0, 0), loc);}
+{TERMINAL}     { JACC_TRACE("lexed TERMINAL: {}", yytext);    return yy::parser::make_TERMINAL    (TOKEN_TEXT (0, 0), loc);}
+{REGEX}        { JACC_TRACE("lexed REGEX: {}", yytext);
+                 return yy::parser::make_REGEX (TOKEN_TEXT (1, 1), loc);}
 
 <<EOF>>    return yy::parser::make_YYEOF (loc);
 
@@ -57,14 +70,12 @@ void
 Driver::scan_begin ()
 {
     yy_flex_debug = trace_scanning;
-    if (!(yyin = fopen (file.c_str (), "r"))){
-        spdlog::error("File opening failed! Does it exist?");
-        exit(EXIT_FAILURE);
-    }
+    scan_buffer = yy_scan_buffer (input, input_size);
 }
 
 void
 Driver::scan_end ()
 {
-    fclose(yyin);
+    yy_delete_buffer (scan_buffer);
+    scan_buffer = nullptr;
 }
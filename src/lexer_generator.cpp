@@ -0,0 +1,569 @@
+#include <jacc/lexer_generator.h>
+#include <jacc/trace.h>
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace
+{
+using ByteSet = std::bitset<256>;
+using TokenIndex = LexerTable::TokenIndex;
+using StateId = LexerTable::StateId;
+constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+/**
+ * A Thompson NFA. Every state has at most two ε edges, or a single edge on a set of bytes.
+ */
+struct Nfa {
+    struct State {
+        std::uint32_t epsilon[2] = {none, none};
+        std::uint32_t byte_set = none;
+        std::uint32_t target = none;
+        TokenIndex accepts = LexerTable::no_token;
+    };
+    std::vector<State> states;
+    std::vector<ByteSet> byte_sets;
+
+    std::uint32_t add_state()
+    {
+        states.emplace_back();
+        return static_cast<std::uint32_t>(states.size() - 1);
+    }
+    void add_epsilon(std::uint32_t from, std::uint32_t to)
+    {
+        auto &edges = states[from].epsilon;
+        edges[edges[0] == none ? 0 : 1] = to;
+    }
+    void add_edge(std::uint32_t from, const ByteSet &bytes, std::uint32_t to)
+    {
+        byte_sets.push_back(bytes);
+        states[from].byte_set = static_cast<std::uint32_t>(byte_sets.size() - 1);
+        states[from].target = to;
+    }
+};
+
+/**
+ * Recursive descent over a pattern that builds the NFA fragments right away. The end state of a
+ * fragment has no outgoing edges yet.
+ */
+class RegexParser
+{
+  public:
+    struct Fragment {
+        std::uint32_t start;
+        std::uint32_t end;
+    };
+
+    RegexParser(const TokenDefinition &definition, Nfa &nfa)
+        : definition(definition), pattern(definition.pattern), nfa(nfa)
+    {
+    }
+
+    Fragment parse()
+    {
+        const auto fragment = alternation();
+        if (position != pattern.size())
+            fail("unbalanced )");
+        return fragment;
+    }
+
+  private:
+    [[noreturn]] void fail(const std::string &reason) const
+    {
+        throw std::invalid_argument(fmt::format("token {}: {} at offset {} of /{}/",
+                                                definition.name, reason, position, pattern));
+    }
+    bool at_end() const { return position == pattern.size(); }
+    char peek() const { return pattern[position]; }
+
+    Fragment empty()
+    {
+        const auto start = nfa.add_state();
+        const auto end = nfa.add_state();
+        nfa.add_epsilon(start, end);
+        return {start, end};
+    }
+
+    Fragment alternation()
+    {
+        auto fragment = concatenation();
+        while (!at_end() && peek() == '|') {
+            position++;
+            const auto other = concatenation();
+            const auto start = nfa.add_state();
+            const auto end = nfa.add_state();
+            nfa.add_epsilon(start, fragment.start);
+            nfa.add_epsilon(start, other.start);
+            nfa.add_epsilon(fragment.end, end);
+            nfa.add_epsilon(other.end, end);
+            fragment = {start, end};
+        }
+        return fragment;
+    }
+
+    Fragment concatenation()
+    {
+        if (at_end() || peek() == '|' || peek() == ')')
+            return empty();
+        auto fragment = repetition();
+        while (!at_end() && peek() != '|' && peek() != ')') {
+            const auto next = repetition();
+            nfa.add_epsilon(fragment.end, next.start);
+            fragment.end = next.end;
+        }
+        return fragment;
+    }
+
+    Fragment repetition()
+    {
+        auto fragment = atom();
+        while (!at_end() && (peek() == '*' || peek() == '+' || peek() == '?')) {
+            const auto op = pattern[position++];
+            const auto start = nfa.add_state();
+            const auto end = nfa.add_state();
+            nfa.add_epsilon(start, fragment.start);
+            if (op != '+')
+                nfa.add_epsilon(start, end);
+            if (op != '?')
+                nfa.add_epsilon(fragment.end, fragment.start);
+            nfa.add_epsilon(fragment.end, end);
+            fragment = {start, end};
+        }
+        return fragment;
+    }
+
+    Fragment atom()
+    {
+        ByteSet bytes;
+        const auto c = pattern[position++];
+        switch (c) {
+        case '(': {
+            const auto fragment = alternation();
+            if (at_end() || peek() != ')')
+                fail("missing )");
+            position++;
+            return fragment;
+        }
+        case ')':
+        case '*':
+        case '+':
+        case '?':
+            position--;
+            fail(fmt::format("unexpected {}", c));
+        case '[':
+            bytes = bracket();
+            break;
+        case '.':
+            bytes.set();
+            bytes.reset('\n');
+            break;
+        case '\\':
+            bytes = escape();
+            break;
+        default:
+            bytes.set(static_cast<unsigned char>(c));
+        }
+        const auto start = nfa.add_state();
+        const auto end = nfa.add_state();
+        nfa.add_edge(start, bytes, end);
+        return {start, end};
+    }
+
+    ByteSet escape()
+    {
+        if (at_end())
+            fail("dangling \\");
+        ByteSet bytes;
+        const auto c = pattern[position++];
+        auto add_range = [&](unsigned char from, unsigned char to) {
+            for (unsigned b = from; b <= to; b++)
+                bytes.set(b);
+        };
+        switch (c) {
+        case 'n':
+            bytes.set('\n');
+            break;
+        case 't':
+            bytes.set('\t');
+            break;
+        case 'r':
+            bytes.set('\r');
+            break;
+        case 'f':
+            bytes.set('\f');
+            break;
+        case 'v':
+            bytes.set('\v');
+            break;
+        case '0':
+            bytes.set(0);
+            break;
+        case 'd':
+        case 'D':
+            add_range('0', '9');
+            break;
+        case 'w':
+        case 'W':
+            add_range('a', 'z');
+            add_range('A', 'Z');
+            add_range('0', '9');
+            bytes.set('_');
+            break;
+        case 's':
+        case 'S':
+            for (char space : {' ', '\t', '\n', '\r', '\f', '\v'})
+                bytes.set(static_cast<unsigned char>(space));
+            break;
+        default:
+            bytes.set(static_cast<unsigned char>(c));
+        }
+        if (c == 'D' || c == 'W' || c == 'S')
+            bytes.flip();
+        return bytes;
+    }
+
+    ByteSet bracket()
+    {
+        ByteSet bytes;
+        const bool negated = !at_end() && peek() == '^';
+        if (negated)
+            position++;
+        bool first = true;
+        while (!at_end() && (peek() != ']' || first)) {
+            first = false;
+            if (peek() == '\\') {
+                position++;
+                bytes |= escape();
+                continue;
+            }
+            const auto from = static_cast<unsigned char>(pattern[position++]);
+            if (position + 1 < pattern.size() && peek() == '-' && pattern[position + 1] != ']') {
+                const auto to = static_cast<unsigned char>(pattern[position + 1]);
+                position += 2;
+                if (to < from)
+                    fail("reversed range");
+                for (unsigned b = from; b <= to; b++)
+                    bytes.set(b);
+            } else {
+                bytes.set(from);
+            }
+        }
+        if (at_end())
+            fail("missing ]");
+        position++;
+        return negated ? ~bytes : bytes;
+    }
+
+    const TokenDefinition &definition;
+    std::string_view pattern;
+    Nfa &nfa;
+    std::size_t position = 0;
+};
+
+/**
+ * Splits the 256 byte values into the coarsest classes that none of the NFA's byte sets cut
+ * through. Returns the number of classes.
+ */
+std::size_t compute_byte_classes(const Nfa &nfa, std::array<std::uint8_t, 256> &class_of)
+{
+    class_of.fill(0);
+    std::size_t num_classes = 1;
+    std::vector<std::uint32_t> renumber;
+    for (const auto &bytes : nfa.byte_sets) {
+        // class c splits into 2c for the bytes outside of the set and 2c + 1 for those inside
+        renumber.assign(2 * num_classes, none);
+        num_classes = 0;
+        for (unsigned b = 0; b < 256; b++) {
+            auto &split = renumber[2 * class_of[b] + (bytes.test(b) ? 1 : 0)];
+            if (split == none)
+                split = static_cast<std::uint32_t>(num_classes++);
+            class_of[b] = static_cast<std::uint8_t>(split);
+        }
+    }
+    return num_classes;
+}
+
+/**
+ * A complete DFA over byte classes, state 0 is the dead state.
+ */
+struct Dfa {
+    std::size_t num_classes = 0;
+    std::vector<StateId> transitions;
+    std::vector<TokenIndex> accepting;
+    StateId start = 0;
+
+    std::size_t num_states() const { return accepting.size(); }
+    StateId next(StateId state, std::size_t byte_class) const
+    {
+        return transitions[state * num_classes + byte_class];
+    }
+};
+
+Dfa subset_construction(const Nfa &nfa, const std::vector<std::uint32_t> &starts,
+                        const std::array<std::uint8_t, 256> &class_of, std::size_t num_classes)
+{
+    std::vector<unsigned char> representative(num_classes);
+    for (unsigned b = 256; b-- > 0;)
+        representative[class_of[b]] = static_cast<unsigned char>(b);
+
+    std::vector<std::uint32_t> stamps(nfa.states.size(), 0);
+    std::uint32_t stamp = 0;
+    std::vector<std::uint32_t> stack;
+    auto closure = [&](std::vector<std::uint32_t> &set) {
+        stamp++;
+        stack = set;
+        set.clear();
+        for (auto s : stack)
+            stamps[s] = stamp;
+        while (!stack.empty()) {
+            const auto s = stack.back();
+            stack.pop_back();
+            set.push_back(s);
+            for (auto t : nfa.states[s].epsilon) {
+                if (t != none && stamps[t] != stamp) {
+                    stamps[t] = stamp;
+                    stack.push_back(t);
+                }
+            }
+        }
+        std::sort(set.begin(), set.end());
+    };
+
+    Dfa dfa;
+    dfa.num_classes = num_classes;
+    std::map<std::vector<std::uint32_t>, StateId> state_of;
+    std::vector<std::vector<std::uint32_t>> sets;
+    auto add_state = [&](std::vector<std::uint32_t> set) {
+        const auto [it, inserted] = state_of.try_emplace(set, static_cast<StateId>(sets.size()));
+        if (inserted) {
+            auto accepts = LexerTable::no_token;
+            for (auto s : set)
+                accepts = std::min(accepts, nfa.states[s].accepts);
+            dfa.accepting.push_back(accepts);
+            sets.push_back(std::move(set));
+        }
+        return it->second;
+    };
+
+    add_state({});
+    auto start = starts;
+    closure(start);
+    dfa.start = add_state(std::move(start));
+
+    std::vector<std::uint32_t> moved;
+    for (std::size_t state = 0; state < sets.size(); state++) {
+        for (std::size_t c = 0; c < num_classes; c++) {
+            moved.clear();
+            for (auto s : sets[state]) {
+                const auto &nfa_state = nfa.states[s];
+                if (nfa_state.byte_set != none &&
+                    nfa.byte_sets[nfa_state.byte_set].test(representative[c]))
+                    moved.push_back(nfa_state.target);
+            }
+            closure(moved);
+            const auto target = add_state(moved);
+            dfa.transitions.push_back(target);
+        }
+    }
+    return dfa;
+}
+
+/**
+ * Hopcroft's partition refinement. Returns the block of every state, blocks are the states of
+ * the minimal DFA.
+ */
+std::vector<std::uint32_t> minimize(const Dfa &dfa)
+{
+    const auto n = dfa.num_states();
+
+    // inverse transitions per class, in compressed row form
+    std::vector<std::uint32_t> inverse_offsets(dfa.num_classes * n + 1, 0);
+    std::vector<StateId> inverse(dfa.num_classes * n);
+    for (StateId s = 0; s < n; s++)
+        for (std::size_t c = 0; c < dfa.num_classes; c++)
+            inverse_offsets[c * n + dfa.next(s, c) + 1]++;
+    for (std::size_t i = 1; i < inverse_offsets.size(); i++)
+        inverse_offsets[i] += inverse_offsets[i - 1];
+    auto fill = inverse_offsets;
+    for (StateId s = 0; s < n; s++)
+        for (std::size_t c = 0; c < dfa.num_classes; c++)
+            inverse[fill[c * n + dfa.next(s, c)]++] = s;
+
+    // the partition: block b holds elements[first[b], end[b]), marked ones come first
+    std::vector<StateId> elements(n);
+    std::vector<std::uint32_t> location(n);
+    std::vector<std::uint32_t> block_of(n);
+    std::vector<std::uint32_t> first, end, marked_end;
+    std::vector<bool> in_worklist;
+    std::vector<std::uint32_t> worklist;
+
+    // initial blocks: one per accepted token, and one for the states that accept nothing
+    std::map<TokenIndex, std::uint32_t> block_of_token;
+    for (StateId s = 0; s < n; s++) {
+        const auto [it, inserted] = block_of_token.try_emplace(
+            dfa.accepting[s], static_cast<std::uint32_t>(block_of_token.size()));
+        block_of[s] = it->second;
+    }
+    std::vector<std::uint32_t> sizes(block_of_token.size(), 0);
+    for (StateId s = 0; s < n; s++)
+        sizes[block_of[s]]++;
+    std::uint32_t offset = 0;
+    for (auto size : sizes) {
+        first.push_back(offset);
+        marked_end.push_back(offset);
+        offset += size;
+        end.push_back(offset);
+    }
+    auto next_free = first;
+    for (StateId s = 0; s < n; s++) {
+        location[s] = next_free[block_of[s]]++;
+        elements[location[s]] = s;
+    }
+    for (std::uint32_t b = 0; b < first.size(); b++) {
+        worklist.push_back(b);
+        in_worklist.push_back(true);
+    }
+
+    std::vector<std::uint32_t> touched;
+    std::vector<StateId> splitter;
+    auto mark = [&](StateId s) {
+        const auto b = block_of[s];
+        const auto i = location[s];
+        if (i < marked_end[b])
+            return;
+        if (marked_end[b] == first[b])
+            touched.push_back(b);
+        const auto other = elements[marked_end[b]];
+        std::swap(elements[i], elements[marked_end[b]]);
+        location[other] = i;
+        location[s] = marked_end[b]++;
+    };
+
+    while (!worklist.empty()) {
+        const auto a = worklist.back();
+        worklist.pop_back();
+        in_worklist[a] = false;
+        splitter.assign(elements.begin() + first[a], elements.begin() + end[a]);
+
+        for (std::size_t c = 0; c < dfa.num_classes; c++) {
+            for (auto t : splitter)
+                for (auto i = inverse_offsets[c * n + t]; i < inverse_offsets[c * n + t + 1]; i++)
+                    mark(inverse[i]);
+
+            for (auto b : touched) {
+                if (marked_end[b] == end[b]) {
+                    marked_end[b] = first[b];
+                    continue;
+                }
+                // the marked part becomes a block of its own
+                const auto split = static_cast<std::uint32_t>(first.size());
+                first.push_back(first[b]);
+                end.push_back(marked_end[b]);
+                marked_end.push_back(first[b]);
+                first[b] = end[split];
+                marked_end[b] = first[b];
+                for (auto i = first[split]; i < end[split]; i++)
+                    block_of[elements[i]] = split;
+
+                const bool split_smaller = end[split] - first[split] <= end[b] - first[b];
+                if (in_worklist[b] || split_smaller) {
+                    worklist.push_back(split);
+                    in_worklist.push_back(true);
+                } else {
+                    worklist.push_back(b);
+                    in_worklist[b] = true;
+                    in_worklist.push_back(false);
+                }
+            }
+            touched.clear();
+        }
+    }
+    return block_of;
+}
+} // namespace
+
+LexerTable generate_lexer(const std::vector<TokenDefinition> &definitions,
+                          const SymbolTable &symbols)
+{
+    Nfa nfa;
+    std::vector<std::uint32_t> starts;
+    std::vector<SymbolId> token_symbols;
+    for (TokenIndex token = 0; token < definitions.size(); token++) {
+        const auto &definition = definitions[token];
+        const auto fragment = RegexParser(definition, nfa).parse();
+        nfa.states[fragment.end].accepts = token;
+        starts.push_back(fragment.start);
+        const auto terminal = ProductionSymbol{definition.name, ProductionSymbol::Kind::Terminal};
+        token_symbols.push_back(definition.is_skipped() ? SymbolTable::epsilon_id
+                                                        : symbols.find(terminal));
+    }
+
+    std::array<std::uint8_t, 256> class_of{};
+    const auto num_classes = compute_byte_classes(nfa, class_of);
+    const auto dfa = subset_construction(nfa, starts, class_of, num_classes);
+    const auto block_of = minimize(dfa);
+    JACC_DEBUG("lexer: {} NFA states, {} byte classes, {} DFA states", nfa.states.size(),
+               num_classes, dfa.num_states());
+
+    // number the blocks dead state first, start state second, the rest in breadth first order
+    const auto num_blocks = *std::max_element(block_of.begin(), block_of.end()) + 1;
+    std::vector<StateId> state_of_block(num_blocks, LexerTable::dead_state);
+    std::vector<StateId> representative;
+    representative.push_back(0);
+    const bool start_is_dead = block_of[dfa.start] == block_of[0];
+    if (!start_is_dead) {
+        state_of_block[block_of[dfa.start]] = LexerTable::start_state;
+        representative.push_back(dfa.start);
+    }
+    for (std::size_t i = 1; i < representative.size(); i++) {
+        for (std::size_t c = 0; c < num_classes; c++) {
+            const auto target = dfa.next(representative[i], c);
+            const auto block = block_of[target];
+            if (block == block_of[0] || state_of_block[block] != LexerTable::dead_state)
+                continue;
+            state_of_block[block] = static_cast<StateId>(representative.size());
+            representative.push_back(target);
+        }
+    }
+    if (start_is_dead) {
+        // nothing can be matched at all, the start state is just another dead end
+        representative.push_back(0);
+    }
+
+    std::vector<StateId> transitions;
+    std::vector<TokenIndex> accepting;
+    for (auto state : representative) {
+        accepting.push_back(dfa.accepting[state]);
+        for (std::size_t c = 0; c < num_classes; c++)
+            transitions.push_back(state_of_block[block_of[dfa.next(state, c)]]);
+    }
+
+    // merge classes that every state treats the same
+    std::map<std::vector<StateId>, std::uint8_t> class_of_column;
+    std::vector<std::uint8_t> merged(num_classes);
+    for (std::size_t c = 0; c < num_classes; c++) {
+        std::vector<StateId> column;
+        for (std::size_t s = 0; s < representative.size(); s++)
+            column.push_back(transitions[s * num_classes + c]);
+        merged[c] = class_of_column
+                        .try_emplace(column, static_cast<std::uint8_t>(class_of_column.size()))
+                        .first->second;
+    }
+    const auto num_merged = class_of_column.size();
+    std::vector<StateId> merged_transitions(representative.size() * num_merged);
+    for (std::size_t s = 0; s < representative.size(); s++)
+        for (std::size_t c = 0; c < num_classes; c++)
+            merged_transitions[s * num_merged + merged[c]] = transitions[s * num_classes + c];
+    for (auto &byte_class : class_of)
+        byte_class = merged[byte_class];
+
+    LexerTable table(class_of, num_merged, std::move(merged_transitions), std::move(accepting));
+    table.token_symbols = std::move(token_symbols);
+    return table;
+}
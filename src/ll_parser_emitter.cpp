@@ -0,0 +1,382 @@
+#include <jacc/ll_parser_emitter.h>
+
+#include <algorithm>
+#include <cctype>
+#include <fmt/format.h>
+#include <utility>
+
+namespace
+{
+std::string to_identifier(const std::string &name)
+{
+    std::string identifier;
+    for (char c : name)
+        identifier += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    if (identifier.empty() || std::isdigit(static_cast<unsigned char>(identifier.front())))
+        identifier.insert(identifier.begin(), '_');
+    return identifier;
+}
+
+std::string to_string_literal(const std::string &text)
+{
+    std::string literal = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            literal += '\\';
+        literal += c;
+    }
+    return literal + "\"";
+}
+
+/**
+ * Writes values as the body of an array initializer, a fixed number per line.
+ * Arrays can't be empty, so an empty list gets a single 0 that is never read.
+ */
+template <class Values> std::string to_initializer(const Values &values, std::size_t per_line)
+{
+    if (values.empty())
+        return "    0,\n";
+    std::string body;
+    for (std::size_t i = 0; i < values.size(); i++) {
+        body += i % per_line == 0 ? "    " : " ";
+        body += fmt::format("{},", values[i]);
+        if (i % per_line == per_line - 1 || i + 1 == values.size())
+            body += '\n';
+    }
+    return body;
+}
+
+constexpr auto header_template = R"(// Generated by jacc. Do not edit.
+#ifndef {guard}
+#define {guard}
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace {name}
+{{
+// terminals are [0, num_terminals), nonterminals come right after them
+using SymbolCode = std::uint32_t;
+using ProductionIndex = {production_type};
+
+inline constexpr std::size_t num_terminals = {num_terminals};
+inline constexpr std::size_t num_nonterminals = {num_nonterminals};
+inline constexpr std::size_t num_productions = {num_productions};
+inline constexpr SymbolCode end_of_input = 0;
+inline constexpr SymbolCode invalid_terminal = 0xffffffff;
+
+/**
+ * Maps the spelling of a terminal to its code, or invalid_terminal if there is no such terminal.
+ */
+SymbolCode terminal_code(std::string_view spelling);
+std::string_view symbol_name(SymbolCode symbol);
+
+namespace detail
+{{
+inline constexpr ProductionIndex no_production = {no_production};
+inline constexpr SymbolCode start_symbol = {start_symbol};
+// a production on the stack whose RHS is matched once it gets to the top
+inline constexpr SymbolCode completion_marker = 0x80000000;
+
+// RHS of production p is rhs_symbols[rhs_offsets[p], rhs_offsets[p + 1])
+extern const std::uint32_t rhs_offsets[];
+extern const SymbolCode rhs_symbols[];
+{table_declarations}
+
+struct NoActions {{
+    void shift(SymbolCode, std::size_t) {{}}
+    void reduce(ProductionIndex) {{}}
+}};
+}} // namespace detail
+
+class Parser
+{{
+  public:
+    /**
+     * Parses a complete token stream. end_of_input is implied after the last token.
+     */
+    bool parse(std::span<const SymbolCode> tokens)
+    {{
+        detail::NoActions actions;
+        return parse(tokens, actions);
+    }}
+    /**
+     * Same as above, calling actions.shift(token, position) for every token and
+     * actions.reduce(production) once the RHS of a production is matched, children before their
+     * parents.
+     */
+    template <class Actions> bool parse(std::span<const SymbolCode> tokens, Actions &actions);
+    /**
+     * Index of the token the last failed parse stopped at.
+     */
+    std::size_t error_position() const {{ return error_index; }}
+
+  private:
+    std::vector<SymbolCode> stack;
+    std::size_t error_index = 0;
+}};
+
+template <class Actions> bool Parser::parse(std::span<const SymbolCode> tokens, Actions &actions)
+{{
+    constexpr bool mark_completions = !std::is_same_v<Actions, detail::NoActions>;
+    stack.clear();
+    stack.push_back(end_of_input);
+    stack.push_back(detail::start_symbol);
+    std::size_t position = 0;
+    while (!stack.empty()) {{
+        const SymbolCode current = position < tokens.size() ? tokens[position] : end_of_input;
+        const SymbolCode top = stack.back();
+        if (mark_completions && (top & detail::completion_marker)) {{
+            stack.pop_back();
+            actions.reduce(static_cast<ProductionIndex>(top & ~detail::completion_marker));
+            continue;
+        }}
+        if (top < num_terminals) {{
+            if (top != current)
+                break;
+            stack.pop_back();
+            if (position < tokens.size())
+                actions.shift(current, position);
+            position++;
+            continue;
+        }}
+        if (current >= num_terminals)
+            break;
+        const auto production = detail::lookup(top - num_terminals, current);
+        if (production == detail::no_production)
+            break;
+        stack.pop_back();
+        if (mark_completions)
+            stack.push_back(detail::completion_marker | production);
+        for (auto i = detail::rhs_offsets[production + 1]; i > detail::rhs_offsets[production]; i--)
+            stack.push_back(detail::rhs_symbols[i - 1]);
+    }}
+    if (stack.empty() && position == tokens.size() + 1)
+        return true;
+    error_index = position;
+    return false;
+}}
+}} // namespace {name}
+
+#endif // {guard}
+)";
+
+constexpr auto source_template = R"(// Generated by jacc. Do not edit.
+#include "{header_name}"
+
+#include <iterator>
+
+namespace {name}
+{{
+namespace detail
+{{
+const std::uint32_t rhs_offsets[] = {{
+{rhs_offsets}}};
+const SymbolCode rhs_symbols[] = {{
+{rhs_symbols}}};
+{table_definitions}}} // namespace detail
+
+namespace
+{{
+constexpr std::string_view symbol_names[] = {{
+{symbol_names}}};
+
+// minimal perfect hash over the terminal spellings, the same as PerfectHash in jacc
+constexpr std::uint32_t hash_seed = {hash_seed};
+constexpr std::size_t num_slots = {num_slots};
+constexpr std::uint32_t hash_displacements[] = {{
+{hash_displacements}}};
+constexpr std::string_view slot_spellings[] = {{
+{slot_spellings}}};
+constexpr SymbolCode slot_codes[] = {{
+{slot_codes}}};
+
+std::uint64_t hash(std::string_view key)
+{{
+    std::uint64_t h = 0xcbf29ce484222325ULL ^ hash_seed;
+    for (unsigned char c : key)
+        h = (h ^ c) * 0x100000001b3ULL;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    return h ^ (h >> 33);
+}}
+
+std::uint32_t mix(std::uint32_t x)
+{{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    return x ^ (x >> 16);
+}}
+
+std::uint32_t reduce(std::uint32_t x, std::size_t n)
+{{
+    return static_cast<std::uint32_t>((std::uint64_t{{x}} * n) >> 32);
+}}
+}} // namespace
+
+SymbolCode terminal_code(std::string_view spelling)
+{{
+    if (num_slots == 0)
+        return invalid_terminal;
+    const auto h = hash(spelling);
+    const auto bucket =
+        reduce(static_cast<std::uint32_t>(h >> 32), std::size(hash_displacements));
+    const auto slot =
+        reduce(mix(static_cast<std::uint32_t>(h) ^ hash_displacements[bucket]), num_slots);
+    return slot_spellings[slot] == spelling ? slot_codes[slot] : invalid_terminal;
+}}
+
+std::string_view symbol_name(SymbolCode symbol)
+{{
+    if (symbol >= num_terminals + num_nonterminals)
+        return {{}};
+    return symbol_names[symbol];
+}}
+}} // namespace {name}
+)";
+constexpr auto dense_declarations = R"(// [nonterminal][terminal]
+extern const ProductionIndex table[];
+
+inline ProductionIndex lookup(std::size_t nonterminal, std::size_t terminal)
+{
+    return table[nonterminal * num_terminals + terminal];
+}
+)";
+
+constexpr auto dense_definitions = R"(const ProductionIndex table[] = {{
+{table}}};
+)";
+
+constexpr auto displaced_declarations = R"(// row displacement: nonterminal n owns entries[displacements[n] + terminal] where checks[] is
+// n, any other cell of n is defaults[n]
+extern const std::uint32_t displacements[];
+extern const ProductionIndex entries[];
+extern const {check_type} checks[];
+extern const ProductionIndex defaults[];
+
+inline ProductionIndex lookup(std::size_t nonterminal, std::size_t terminal)
+{{
+    const auto slot = displacements[nonterminal] + terminal;
+    return checks[slot] == nonterminal ? entries[slot] : defaults[nonterminal];
+}}
+)";
+
+constexpr auto displaced_definitions = R"(const std::uint32_t displacements[] = {{
+{displacements}}};
+const ProductionIndex entries[] = {{
+{entries}}};
+const {check_type} checks[] = {{
+{checks}}};
+const ProductionIndex defaults[] = {{
+{defaults}}};
+)";
+} // namespace
+
+EmittedParser emit_ll_parser(const LLTable &table, const std::string &name)
+{
+    const auto &symbols = table.get_symbol_table();
+    const auto identifier = to_identifier(name);
+    const auto num_terminals = table.num_columns();
+
+    auto code_of = [&](SymbolId symbol) -> std::uint32_t {
+        return symbols.is_terminal(symbol)
+                   ? symbols.terminal_index(symbol)
+                   : static_cast<std::uint32_t>(num_terminals) + symbols.nonterminal_index(symbol);
+    };
+
+    std::vector<std::string> symbol_names;
+    for (auto terminal : symbols.get_terminals())
+        symbol_names.push_back(to_string_literal(fmt::format("{}", symbols.get_symbol(terminal))));
+    for (auto nonterminal : symbols.get_nonterminals()) {
+        const auto spelling = fmt::format("{}", symbols.get_symbol(nonterminal));
+        symbol_names.push_back(to_string_literal(spelling));
+    }
+    std::vector<std::string> slot_spellings;
+    std::vector<std::uint32_t> slot_codes;
+    for (auto terminal : table.get_terminal_of_slot()) {
+        slot_spellings.push_back(to_string_literal(*symbols.get_symbol(terminal).get_raw_symbol()));
+        slot_codes.push_back(code_of(terminal));
+    }
+
+    std::vector<std::uint32_t> rhs_offsets{0};
+    std::vector<std::uint32_t> rhs_symbols;
+    for (LLTable::ProductionIndex p = 0; p < table.num_productions(); p++) {
+        for (auto symbol : table.get_RHS(p))
+            rhs_symbols.push_back(code_of(symbol));
+        rhs_offsets.push_back(static_cast<std::uint32_t>(rhs_symbols.size()));
+    }
+
+    // use the smallest index type that still leaves room for the no_production marker
+    const bool small_indices = table.num_productions() < 0xffff;
+    const auto no_production = small_indices ? 0xffffULL : 0xffffffffULL;
+    auto to_indices = [&](std::span<const LLTable::ProductionIndex> productions) {
+        std::vector<unsigned long long> indices;
+        indices.reserve(productions.size());
+        for (auto production : productions)
+            indices.push_back(production == LLTable::no_production ? no_production : production);
+        return indices;
+    };
+
+    std::string table_declarations;
+    std::string table_definitions;
+    if (table.get_encoding() == LLTable::Encoding::Dense) {
+        table_declarations = dense_declarations;
+        table_definitions =
+            fmt::format(dense_definitions,
+                        fmt::arg("table", to_initializer(to_indices(table.get_cells()),
+                                                         std::max<std::size_t>(num_terminals, 1))));
+    } else {
+        const bool small_rows = table.num_rows() < 0xffff;
+        const auto no_row = small_rows ? 0xffffULL : 0xffffffffULL;
+        std::vector<unsigned long long> checks;
+        for (auto check : table.get_checks())
+            checks.push_back(check == SymbolTable::no_index ? no_row : check);
+        const auto check_type = small_rows ? "std::uint16_t" : "std::uint32_t";
+        table_declarations =
+            fmt::format(displaced_declarations, fmt::arg("check_type", check_type));
+        table_definitions = fmt::format(
+            displaced_definitions, fmt::arg("check_type", check_type),
+            fmt::arg("displacements", to_initializer(table.get_displacements(), 16)),
+            fmt::arg("entries", to_initializer(to_indices(table.get_entries()), 16)),
+            fmt::arg("checks", to_initializer(checks, 16)),
+            fmt::arg("defaults", to_initializer(to_indices(table.get_defaults()), 16)));
+    }
+
+    auto guard = identifier + "_H_";
+    std::transform(guard.begin(), guard.end(), guard.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+
+    EmittedParser emitted;
+    emitted.header_name = identifier + ".h";
+    emitted.source_name = identifier + ".cpp";
+    emitted.header = fmt::format(
+        header_template, fmt::arg("name", identifier), fmt::arg("guard", guard),
+        fmt::arg("num_terminals", num_terminals), fmt::arg("num_nonterminals", table.num_rows()),
+        fmt::arg("num_productions", table.num_productions()),
+        fmt::arg("production_type", small_indices ? "std::uint16_t" : "std::uint32_t"),
+        fmt::arg("no_production", fmt::format("{:#x}", no_production)),
+        fmt::arg("table_declarations", table_declarations),
+        // an empty grammar has no start symbol, and only accepts empty input
+        fmt::arg("start_symbol", table.get_start_symbol() == SymbolTable::invalid_id
+                                     ? 0
+                                     : code_of(table.get_start_symbol())));
+    emitted.source = fmt::format(
+        source_template, fmt::arg("name", identifier), fmt::arg("header_name", emitted.header_name),
+        fmt::arg("symbol_names", to_initializer(symbol_names, 8)),
+        fmt::arg("hash_seed", table.get_terminal_hash().get_seed()),
+        fmt::arg("num_slots", table.get_terminal_hash().size()),
+        fmt::arg("hash_displacements",
+                 to_initializer(table.get_terminal_hash().get_displacements(), 8)),
+        fmt::arg("slot_spellings", to_initializer(slot_spellings, 8)),
+        fmt::arg("slot_codes", to_initializer(slot_codes, 16)),
+        fmt::arg("rhs_offsets", to_initializer(rhs_offsets, 16)),
+        fmt::arg("rhs_symbols", to_initializer(rhs_symbols, 16)),
+        fmt::arg("table_definitions", table_definitions));
+    return emitted;
+}
@@ -0,0 +1,291 @@
+#include <jacc/ll_table.h>
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+/**
+ * The filled cells of one row, by column.
+ */
+struct SparseRow {
+    std::vector<std::uint32_t> columns;
+    std::vector<LLTable::ProductionIndex> productions;
+};
+
+/**
+ * The rows of a dense table. With default_rows the most frequent production of every row, the
+ * lowest one on a tie, is taken out and stored in defaults.
+ */
+std::vector<SparseRow> sparse_rows(std::span<const LLTable::ProductionIndex> cells,
+                                   std::size_t num_rows, std::size_t num_columns,
+                                   bool default_rows,
+                                   std::vector<LLTable::ProductionIndex> &defaults)
+{
+    std::vector<SparseRow> rows(num_rows);
+    defaults.assign(num_rows, LLTable::no_production);
+    std::vector<std::pair<LLTable::ProductionIndex, std::uint32_t>> counts;
+    for (std::size_t row = 0; row < num_rows; row++) {
+        const auto *cell = cells.data() + row * num_columns;
+        if (default_rows) {
+            counts.clear();
+            for (std::size_t column = 0; column < num_columns; column++) {
+                if (cell[column] == LLTable::no_production)
+                    continue;
+                auto it = std::find_if(counts.begin(), counts.end(), [&](const auto &count) {
+                    return count.first == cell[column];
+                });
+                if (it == counts.end())
+                    counts.emplace_back(cell[column], 1);
+                else
+                    it->second++;
+            }
+            auto most = std::max_element(counts.begin(), counts.end(), [](auto a, auto b) {
+                return a.second < b.second || (a.second == b.second && a.first > b.first);
+            });
+            if (most != counts.end())
+                defaults[row] = most->first;
+        }
+        for (std::uint32_t column = 0; column < num_columns; column++) {
+            if (cell[column] == LLTable::no_production || cell[column] == defaults[row])
+                continue;
+            rows[row].columns.push_back(column);
+            rows[row].productions.push_back(cell[column]);
+        }
+    }
+    return rows;
+}
+
+/**
+ * First-fit row displacement: rows with the most cells are placed first, each at the lowest
+ * displacement where all of its cells land on free entries. Returns the displacement of every
+ * row, size is set to the length of the comb vector, padded by num_columns so that every row
+ * can be indexed with any column.
+ */
+std::vector<std::uint32_t> displace_rows(const std::vector<SparseRow> &rows,
+                                         std::size_t num_columns, std::size_t &size)
+{
+    std::vector<std::size_t> order(rows.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return rows[a].columns.size() > rows[b].columns.size();
+    });
+
+    std::vector<std::uint32_t> displacements(rows.size(), 0);
+    std::vector<bool> occupied;
+    std::size_t first_free = 0;
+    std::size_t max_displacement = 0;
+    for (auto row : order) {
+        const auto &columns = rows[row].columns;
+        if (columns.empty())
+            break;
+        // no displacement can put the first cell of the row before the first free entry
+        std::size_t displacement = first_free > columns.front() ? first_free - columns.front() : 0;
+        auto fits = [&](std::size_t d) {
+            return std::none_of(columns.begin(), columns.end(), [&](std::uint32_t column) {
+                return d + column < occupied.size() && occupied[d + column];
+            });
+        };
+        while (!fits(displacement))
+            displacement++;
+        if (occupied.size() < displacement + columns.back() + 1)
+            occupied.resize(displacement + columns.back() + 1);
+        for (auto column : columns)
+            occupied[displacement + column] = true;
+        while (first_free < occupied.size() && occupied[first_free])
+            first_free++;
+        displacements[row] = static_cast<std::uint32_t>(displacement);
+        max_displacement = std::max(max_displacement, displacement);
+    }
+    size = max_displacement + num_columns;
+    return displacements;
+}
+
+std::size_t displaced_bytes(const std::vector<SparseRow> &rows, std::size_t num_columns)
+{
+    std::size_t size = 0;
+    displace_rows(rows, num_columns, size);
+    return size * (sizeof(LLTable::ProductionIndex) + sizeof(std::uint32_t)) +
+           rows.size() * (sizeof(std::uint32_t) + sizeof(LLTable::ProductionIndex));
+}
+
+const char *to_string(LLTable::ConflictKind kind)
+{
+    switch (kind) {
+    case LLTable::ConflictKind::FirstFirst:
+        return "FIRST/FIRST";
+    case LLTable::ConflictKind::FirstFollow:
+        return "FIRST/FOLLOW";
+    case LLTable::ConflictKind::FollowFollow:
+        return "FOLLOW/FOLLOW";
+    }
+    return "unknown";
+}
+} // namespace
+
+LLTable::LLTable(SymbolTable symbols, SymbolId start_symbol)
+    : symbols(std::move(symbols)), start_symbol(start_symbol)
+{
+    index_symbols();
+    cells.edit().assign(num_rows() * num_columns(), no_production);
+    build_terminal_hash();
+}
+
+void LLTable::index_symbols()
+{
+    auto &rows = row_of.edit();
+    auto &columns = column_of.edit();
+    rows.resize(symbols.size());
+    columns.resize(symbols.size());
+    for (SymbolId id = 0; id < symbols.size(); id++) {
+        rows[id] = symbols.nonterminal_index(id);
+        columns[id] = symbols.terminal_index(id);
+    }
+}
+
+void LLTable::build_terminal_hash()
+{
+    std::vector<std::string_view> spellings;
+    for (auto terminal : symbols.get_terminals()) {
+        if (terminal != SymbolTable::eoi_id)
+            spellings.push_back(symbols.name(terminal));
+    }
+    terminal_hash = PerfectHash(spellings);
+    auto &terminals = terminal_of_slot.edit();
+    terminals.resize(spellings.size());
+    for (auto terminal : symbols.get_terminals()) {
+        if (terminal != SymbolTable::eoi_id)
+            terminals[terminal_hash.slot(symbols.name(terminal))] = terminal;
+    }
+}
+
+LLTable::ProductionIndex LLTable::add_production(SymbolId LHS, std::span<const SymbolId> RHS)
+{
+    for (auto symbol : RHS) {
+        if (!symbols.is_epsilon(symbol))
+            RHS_symbols.edit().push_back(symbol);
+    }
+    production_LHS.edit().push_back(LHS);
+    RHS_offsets.edit().push_back(static_cast<std::uint32_t>(RHS_symbols.size()));
+    return static_cast<ProductionIndex>(production_LHS.size() - 1);
+}
+
+void LLTable::set(SymbolId nonterminal, SymbolId terminal, ProductionIndex production)
+{
+    cells.edit()[static_cast<std::size_t>(row_of[nonterminal]) * num_columns() +
+                 column_of[terminal]] = production;
+}
+
+void LLTable::clear_row(SymbolId nonterminal)
+{
+    std::fill_n(cells.edit().data() +
+                    static_cast<std::size_t>(row_of[nonterminal]) * num_columns(),
+                num_columns(), no_production);
+}
+
+void LLTable::extend_symbols(SymbolTable extended)
+{
+    const auto old_columns = num_columns();
+    symbols = std::move(extended);
+    index_symbols();
+    if (num_columns() == old_columns) {
+        cells.edit().resize(num_rows() * num_columns(), no_production);
+        return;
+    }
+    // the rows get wider, terminals keep their columns
+    std::vector<ProductionIndex> widened(num_rows() * num_columns(), no_production);
+    for (std::size_t row = 0; row < cells.size() / old_columns; row++)
+        std::copy_n(cells.data() + row * old_columns, old_columns,
+                    widened.data() + row * num_columns());
+    cells = std::move(widened);
+    build_terminal_hash();
+}
+
+void LLTable::compress(Encoding target)
+{
+    if (encoding != Encoding::Dense || target == Encoding::Dense)
+        return;
+    const auto rows = sparse_rows(cells, num_rows(), num_columns(),
+                                  target == Encoding::DefaultRows, defaults.edit());
+    std::size_t size = 0;
+    displacements = displace_rows(rows, num_columns(), size);
+    std::vector<ProductionIndex> comb(size, no_production);
+    std::vector<std::uint32_t> comb_checks(size, SymbolTable::no_index);
+    for (std::uint32_t row = 0; row < rows.size(); row++) {
+        for (std::size_t i = 0; i < rows[row].columns.size(); i++) {
+            const auto slot = displacements[row] + rows[row].columns[i];
+            comb[slot] = rows[row].productions[i];
+            comb_checks[slot] = row;
+        }
+    }
+    entries = std::move(comb);
+    checks = std::move(comb_checks);
+    cells = {};
+    encoding = target;
+}
+
+LLTable::ProductionIndex LLTable::find_production(SymbolId LHS,
+                                                  std::span<const SymbolId> RHS) const
+{
+    std::vector<SymbolId> wanted;
+    for (auto symbol : RHS) {
+        if (!symbols.is_epsilon(symbol))
+            wanted.push_back(symbol);
+    }
+    for (ProductionIndex production = 0; production < num_productions(); production++) {
+        if (production_LHS[production] != LHS)
+            continue;
+        const auto candidate = get_RHS(production);
+        if (std::equal(candidate.begin(), candidate.end(), wanted.begin(), wanted.end()))
+            return production;
+    }
+    return no_production;
+}
+
+Production LLTable::to_production(ProductionIndex production) const
+{
+    std::vector<ProductionSymbol> RHS;
+    for (auto symbol : get_RHS(production))
+        RHS.push_back(symbols.get_symbol(symbol));
+    if (RHS.empty())
+        RHS.push_back(ProductionSymbol::create_epsilon());
+    auto result = Production(RHS);
+    result.synthesized_LHS = symbols.get_symbol(get_LHS(production));
+    return result;
+}
+
+LLTableStats LLTable::compute_stats() const
+{
+    LLTableStats stats;
+    stats.rows = num_rows();
+    stats.columns = num_columns();
+    stats.productions = num_productions();
+    stats.conflicts = conflicts.size();
+    if (encoding != Encoding::Dense)
+        return stats;
+
+    stats.filled_cells = static_cast<std::size_t>(std::count_if(
+        cells.begin(), cells.end(), [](auto cell) { return cell != no_production; }));
+    if (!cells.empty())
+        stats.fill_ratio =
+            static_cast<double>(stats.filled_cells) / static_cast<double>(cells.size());
+    stats.dense_bytes = cells.size() * sizeof(ProductionIndex);
+    std::vector<ProductionIndex> unused;
+    stats.compressed_bytes =
+        displaced_bytes(sparse_rows(cells, num_rows(), num_columns(), false, unused),
+                        num_columns());
+    stats.default_rows_bytes =
+        displaced_bytes(sparse_rows(cells, num_rows(), num_columns(), true, unused),
+                        num_columns());
+    return stats;
+}
+
+std::string LLTable::describe(const Conflict &conflict) const
+{
+    auto production = [this](ProductionIndex index) {
+        return fmt::format("{} -> {}", symbols.get_symbol(get_LHS(index)), to_production(index));
+    };
+    return fmt::format("{} conflict in {} on {}: {} kept over {}", to_string(conflict.kind),
+                       symbols.get_symbol(conflict.nonterminal),
+                       symbols.get_symbol(conflict.terminal), production(conflict.kept),
+                       production(conflict.dropped));
+}
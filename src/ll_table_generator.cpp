@@ -1,68 +1,227 @@
 #include <jacc/ll_table_generator.h>
 #include <jacc/first_follow_set_generator.h>
 #include <jacc/grammar.h>
-#include <spdlog/spdlog.h>
+#include <jacc/trace.h>
+
+#include <stdexcept>
 
 std::map<ProductionSymbol, std::map<ProductionSymbol, Production>>
 generate_ll_table(Grammar &grammar, FirstFollowSetGenerator &sets_generator)
 {
     std::map<ProductionSymbol, std::map<ProductionSymbol, Production>> parsing_table;
+    auto follow_sets = sets_generator.generate_follow_sets();
+    std::size_t first_first_conflicts = 0;
+    std::size_t first_follow_conflicts = 0;
     for (auto &rule : grammar.get_rules()) {
         auto LHS = rule.get_LHS();
-        spdlog::debug("LHS: {}", LHS);
+        JACC_DEBUG("LHS: {}", LHS);
         bool contains_epsilon = false;
         for (auto &production : rule.get_productions()) {
             auto current_first_set = sets_generator.first(production);
-            spdlog::debug("production: {}", production);
-            spdlog::debug("first set: {}", current_first_set);
-            spdlog::debug("entering loop");
+            JACC_DEBUG("production: {}", production);
+            JACC_DEBUG("first set: {}", current_first_set);
+            JACC_DEBUG("entering loop");
             for (auto &production_symbol : current_first_set) {
-                spdlog::debug("production symbol: {}", production_symbol);
+                JACC_DEBUG("production symbol: {}", production_symbol);
                 if (production_symbol.is_epsilon()) {
                     contains_epsilon = true;
-                    spdlog::debug("found epsilon!");
-                } else {
-                    // For each terminal `production_symbol` in `current_first_set`,
-                    // add `production` to parsing_table[LHS,production_symbol]
-                    parsing_table[LHS][production_symbol] = production;
-                    spdlog::debug("(no epsilon) wrote parsing_table[{}][{}] = {}", LHS,
-                                  production_symbol, production);
+                    JACC_DEBUG("found epsilon!");
+                    continue;
+                }
+                // For each terminal `production_symbol` in `current_first_set`,
+                // add `production` to parsing_table[LHS,production_symbol]
+                // unless an earlier production already claimed it
+                auto [cell, inserted] = parsing_table[LHS].emplace(production_symbol, production);
+                if (!inserted && !(cell->second == production)) {
+                    first_first_conflicts++;
+                    JACC_DEBUG("FIRST/FIRST conflict in {} on {}: {} kept over {}", LHS,
+                               production_symbol, cell->second, production);
+                    continue;
                 }
+                JACC_DEBUG("(no epsilon) wrote parsing_table[{}][{}] = {}", LHS,
+                              production_symbol, production);
             }
-            spdlog::debug("exiting loop");
+            JACC_DEBUG("exiting loop");
         }
         if (contains_epsilon) {
-            auto follow_set = sets_generator.generate_follow_sets();
             auto epsilon_production = Production(ProductionSymbol::create_epsilon());
             epsilon_production.synthesized_LHS = LHS;
-            auto current_follow_set = follow_set[LHS];
-            spdlog::debug("follow set: {}", current_follow_set);
+            auto current_follow_set = follow_sets[LHS];
+            JACC_DEBUG("follow set: {}", current_follow_set);
             for (auto &production_symbol : current_follow_set) {
-                parsing_table[LHS][production_symbol] = epsilon_production;
-                spdlog::debug("(epsilon) wrote parsing_table[{}][{}] = {}", LHS, production_symbol,
+                // the FIRST entries win, like a shift over a reduction
+                auto [cell, inserted] =
+                    parsing_table[LHS].emplace(production_symbol, epsilon_production);
+                if (!inserted && !(cell->second == epsilon_production)) {
+                    first_follow_conflicts++;
+                    JACC_DEBUG("FIRST/FOLLOW conflict in {} on {}: {} kept over {}", LHS,
+                               production_symbol, cell->second, epsilon_production);
+                    continue;
+                }
+                JACC_DEBUG("(epsilon) wrote parsing_table[{}][{}] = {}", LHS, production_symbol,
                               epsilon_production);
             }
         }
     }
+    if (first_first_conflicts + first_follow_conflicts > 0)
+        spdlog::warn("LL(1) table has {} FIRST/FIRST and {} FIRST/FOLLOW conflicts",
+                     first_first_conflicts, first_follow_conflicts);
     return parsing_table;
 }
 
-bool is_nullable(const ProductionSymbol &p, const Grammar &g)
+namespace
+{
+/**
+ * Gives the cell of LHS and the terminal at column to production, unless another production
+ * holds it already, which is recorded as a conflict. claimed_by_follow[cell] tells whether the
+ * cell was claimed through a FOLLOW set.
+ */
+void claim(LLTable &table, std::vector<bool> &claimed_by_follow, std::size_t cell, SymbolId LHS,
+           std::size_t column, LLTable::ProductionIndex production, bool by_follow)
+{
+    const auto terminal = table.get_symbol_table().terminal_at(static_cast<std::uint32_t>(column));
+    const auto existing = table.lookup(LHS, terminal);
+    if (existing == LLTable::no_production) {
+        table.set(LHS, terminal, production);
+        claimed_by_follow[cell] = by_follow;
+        return;
+    }
+    if (existing == production)
+        return;
+    const auto kind = !by_follow               ? LLTable::ConflictKind::FirstFirst
+                      : claimed_by_follow[cell] ? LLTable::ConflictKind::FollowFollow
+                                                : LLTable::ConflictKind::FirstFollow;
+    table.conflicts.push_back({kind, LHS, terminal, existing, production});
+}
+} // namespace
+
+LLTable generate_dense_ll_table(FirstFollowSetGenerator &sets_generator, LLTable::Encoding encoding)
 {
-    if (p.is_epsilon())
-        return true;
-    else if (p.is_terminal())
-        return false;
-    auto productions = g.get_production(p).value();
-    if (productions.rule_contains_epsilon_production())
-        return true;
-    return std::any_of(productions.get_productions().cbegin(), productions.get_productions().cend(),
-                       [g](const Production& p) { return is_nullable(p, g); });
+    const auto &sets = sets_generator.get_engine();
+    const auto &symbols = sets.get_symbol_table();
+    const auto start_symbol =
+        symbols.num_nonterminals() > 0 ? symbols.nonterminal_at(0) : SymbolTable::invalid_id;
+    LLTable table(symbols, start_symbol);
+
+    // All FIRST claims go in before any FOLLOW claim, so a nullable production only gets the
+    // terminals no other production starts with, and among claims of the same kind the earlier
+    // production wins. Every claim that loses is recorded as a conflict.
+    std::vector<bool> claimed_by_follow(table.num_rows() * table.num_columns());
+    auto claim_cell = [&](SymbolId LHS, std::size_t column, LLTable::ProductionIndex production,
+                          bool by_follow) {
+        const auto cell = symbols.nonterminal_index(LHS) * table.num_columns() + column;
+        claim(table, claimed_by_follow, cell, LHS, column, production, by_follow);
+    };
+
+    std::vector<LLTable::ProductionIndex> nullable_productions;
+    for (std::size_t p = 0; p < sets.num_productions(); p++) {
+        const auto LHS = sets.get_production_LHS(p);
+        const auto RHS = sets.get_production_RHS(p);
+        // removed productions stay in the pool, so production indices match the engine's
+        const auto production = table.add_production(LHS, RHS);
+        if (sets.is_removed(p))
+            continue;
+        bool nullable = false;
+        sets.first(RHS, nullable).for_each([&](std::size_t column) {
+            claim_cell(LHS, column, production, false);
+        });
+        if (nullable)
+            nullable_productions.push_back(production);
+    }
+    for (auto production : nullable_productions) {
+        const auto LHS = table.get_LHS(production);
+        sets.follow(LHS).for_each(
+            [&](std::size_t column) { claim_cell(LHS, column, production, true); });
+    }
+
+    if (!table.conflicts.empty())
+        spdlog::warn("LL(1) table has {} conflicts", table.conflicts.size());
+    table.compress(encoding);
+    return table;
 }
 
+void patch_ll_table(LLTable &table, FirstFollowSetGenerator &sets_generator,
+                    const FirstFollowEngine::Changes &changes)
+{
+    if (table.get_encoding() != LLTable::Encoding::Dense)
+        throw std::invalid_argument("only Dense tables can be patched");
+    const auto &sets = sets_generator.get_engine();
+    const auto &symbols = sets.get_symbol_table();
+    if (table.get_symbol_table().size() != symbols.size())
+        table.extend_symbols(symbols);
+    for (auto p = table.num_productions(); p < sets.num_productions(); p++)
+        table.add_production(sets.get_production_LHS(p), sets.get_production_RHS(p));
+
+    std::vector<bool> patched(table.num_rows());
+    for (auto LHS : changes.rows)
+        patched[symbols.nonterminal_index(LHS)] = true;
+    std::erase_if(table.conflicts, [&](const LLTable::Conflict &conflict) {
+        return patched[symbols.nonterminal_index(conflict.nonterminal)];
+    });
+
+    // the rows are filled like generate_dense_ll_table() does, one at a time
+    std::vector<bool> claimed_by_follow(table.num_columns());
+    std::vector<LLTable::ProductionIndex> nullable_productions;
+    for (auto LHS : changes.rows) {
+        table.clear_row(LHS);
+        nullable_productions.clear();
+        for (auto production : sets.get_productions(LHS)) {
+            bool nullable = false;
+            sets.first(sets.get_production_RHS(production), nullable)
+                .for_each([&](std::size_t column) {
+                    claim(table, claimed_by_follow, column, LHS, column, production, false);
+                });
+            if (nullable)
+                nullable_productions.push_back(production);
+        }
+        for (auto production : nullable_productions) {
+            sets.follow(LHS).for_each([&](std::size_t column) {
+                claim(table, claimed_by_follow, column, LHS, column, production, true);
+            });
+        }
+    }
+}
+
+LLTable
+to_dense_ll_table(const std::map<ProductionSymbol, std::map<ProductionSymbol, Production>> &table,
+                  const ProductionSymbol &start_symbol)
+{
+    SymbolTable symbols;
+    const auto start = symbols.intern(start_symbol);
+    for (const auto &[LHS, row] : table) {
+        symbols.intern(LHS);
+        for (const auto &[lookahead, production] : row) {
+            symbols.intern(lookahead);
+            for (const auto &symbol : production.get_production_symbols())
+                symbols.intern(symbol);
+        }
+    }
+
+    LLTable dense(symbols, start);
+    // the same production usually fills several cells, so store it only once
+    std::map<std::vector<SymbolId>, LLTable::ProductionIndex> production_indices;
+    for (const auto &[LHS, row] : table) {
+        const auto LHS_id = symbols.find(LHS);
+        for (const auto &[lookahead, production] : row) {
+            std::vector<SymbolId> key{LHS_id};
+            for (const auto &symbol : production.get_production_symbols())
+                key.push_back(symbols.find(symbol));
+            auto it = production_indices.find(key);
+            if (it == production_indices.end()) {
+                const auto index = dense.add_production(LHS_id, std::span{key}.subspan(1));
+                it = production_indices.emplace(std::move(key), index).first;
+            }
+            dense.set(LHS_id, symbols.find(lookahead), it->second);
+        }
+    }
+    return dense;
+}
+
+bool is_nullable(const ProductionSymbol &p, const Grammar &g) { return g.is_nullable(p); }
+
 bool is_nullable(const Production &p, const Grammar &g)
 {
-    auto symbols = p.get_production_symbols();
-    return p.is_epsilon() || std::all_of(symbols.begin(), symbols.end(),
-                                         [g](ProductionSymbol p) { return is_nullable(p, g); });
+    const auto &symbols = p.get_production_symbols();
+    return std::all_of(symbols.begin(), symbols.end(),
+                       [&g](const ProductionSymbol &symbol) { return g.is_nullable(symbol); });
 }
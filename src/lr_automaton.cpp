@@ -0,0 +1,172 @@
+#include <jacc/lr_automaton.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+struct KernelHash {
+    std::size_t operator()(const std::vector<LRAutomaton::Item> &kernel) const
+    {
+        std::size_t hash = 14695981039346656037ULL;
+        for (auto item : kernel)
+            hash = (hash ^ item) * 1099511628211ULL;
+        return hash;
+    }
+};
+} // namespace
+
+LRAutomaton::LRAutomaton(const FirstFollowEngine &sets) : symbols(sets.get_symbol_table())
+{
+    // production 0 is S' → S, where S is the first rule of the grammar
+    production_LHS.push_back(SymbolTable::invalid_id);
+    RHS_offsets.push_back(0);
+    if (symbols.num_nonterminals() > 0)
+        RHS_symbols.push_back(symbols.nonterminal_at(0));
+    RHS_offsets.push_back(static_cast<std::uint32_t>(RHS_symbols.size()));
+    for (std::size_t p = 0; p < sets.num_productions(); p++) {
+        production_LHS.push_back(sets.get_production_LHS(p));
+        const auto RHS = sets.get_production_RHS(p);
+        RHS_symbols.insert(RHS_symbols.end(), RHS.begin(), RHS.end());
+        RHS_offsets.push_back(static_cast<std::uint32_t>(RHS_symbols.size()));
+    }
+
+    // group productions by their LHS, a counting sort over the nonterminal indices. Removed
+    // productions keep their number but are never expanded.
+    productions_of_offsets.assign(symbols.num_nonterminals() + 1, 0);
+    for (std::size_t p = 1; p < num_productions(); p++) {
+        if (!sets.is_removed(p - 1))
+            productions_of_offsets[symbols.nonterminal_index(production_LHS[p]) + 1]++;
+    }
+    for (std::size_t i = 1; i < productions_of_offsets.size(); i++)
+        productions_of_offsets[i] += productions_of_offsets[i - 1];
+    productions_of.resize(productions_of_offsets.back());
+    auto fill = productions_of_offsets;
+    for (std::size_t p = 1; p < num_productions(); p++) {
+        if (!sets.is_removed(p - 1))
+            productions_of[fill[symbols.nonterminal_index(production_LHS[p])]++] =
+                static_cast<std::uint32_t>(p);
+    }
+
+    for (std::size_t p = 0; p < num_productions(); p++) {
+        item_base.push_back(static_cast<Item>(item_production.size()));
+        item_production.insert(item_production.end(), get_production_RHS(p).size() + 1,
+                               static_cast<std::uint32_t>(p));
+    }
+
+    closure_stamps.assign(symbols.num_nonterminals(), 0);
+    std::unordered_map<std::vector<Item>, StateId, KernelHash> state_of;
+    kernel_offsets = {0};
+    transition_offsets = {0};
+    reduction_offsets = {0};
+
+    std::vector<Item> start_kernel{get_item(0, 0)};
+    state_of.emplace(start_kernel, 0);
+    kernel_items = start_kernel;
+    kernel_offsets.push_back(1);
+
+    // successor kernels are collected per symbol, only the touched buckets are visited
+    std::vector<std::vector<Item>> buckets(symbols.size());
+    std::vector<SymbolId> touched;
+    std::vector<Item> kernel;
+    std::vector<Item> items;
+
+    // states are processed in the order they are discovered, so their transitions and
+    // reductions can simply be appended
+    for (StateId state = 0; state < num_states(); state++) {
+        const auto current = get_kernel(state);
+        kernel.assign(current.begin(), current.end());
+        closure(kernel, items);
+
+        for (auto item : items) {
+            const auto production = get_item_production(item);
+            const auto dot = get_item_dot(item);
+            const auto RHS = get_production_RHS(production);
+            if (dot == RHS.size()) {
+                if (production != 0)
+                    reductions.push_back(static_cast<std::uint32_t>(production));
+                continue;
+            }
+            auto &bucket = buckets[RHS[dot]];
+            if (bucket.empty())
+                touched.push_back(RHS[dot]);
+            bucket.push_back(item + 1);
+        }
+
+        std::sort(touched.begin(), touched.end());
+        for (auto symbol : touched) {
+            auto &successor = buckets[symbol];
+            std::sort(successor.begin(), successor.end());
+            auto [it, inserted] =
+                state_of.try_emplace(successor, static_cast<StateId>(num_states()));
+            if (inserted) {
+                kernel_items.insert(kernel_items.end(), successor.begin(), successor.end());
+                kernel_offsets.push_back(static_cast<std::uint32_t>(kernel_items.size()));
+            }
+            transitions.push_back({symbol, it->second});
+            successor.clear();
+        }
+        touched.clear();
+        transition_offsets.push_back(static_cast<std::uint32_t>(transitions.size()));
+        reduction_offsets.push_back(static_cast<std::uint32_t>(reductions.size()));
+    }
+}
+
+void LRAutomaton::closure(std::span<const Item> kernel, std::vector<Item> &items)
+{
+    items.assign(kernel.begin(), kernel.end());
+    closure_stamp++;
+    for (std::size_t i = 0; i < items.size(); i++) {
+        const auto production = get_item_production(items[i]);
+        const auto dot = get_item_dot(items[i]);
+        const auto RHS = get_production_RHS(production);
+        if (dot == RHS.size() || !symbols.is_nonterminal(RHS[dot]))
+            continue;
+        const auto index = symbols.nonterminal_index(RHS[dot]);
+        if (closure_stamps[index] == closure_stamp)
+            continue;
+        closure_stamps[index] = closure_stamp;
+        for (auto predicted : get_productions_of(RHS[dot]))
+            items.push_back(get_item(predicted, 0));
+    }
+}
+
+std::span<const SymbolId> LRAutomaton::get_production_RHS(std::size_t production) const
+{
+    return std::span{RHS_symbols}.subspan(RHS_offsets[production],
+                                          RHS_offsets[production + 1] - RHS_offsets[production]);
+}
+
+std::span<const std::uint32_t> LRAutomaton::get_productions_of(SymbolId nonterminal) const
+{
+    const auto index = symbols.nonterminal_index(nonterminal);
+    return std::span{productions_of}.subspan(productions_of_offsets[index],
+                                             productions_of_offsets[index + 1] -
+                                                 productions_of_offsets[index]);
+}
+
+std::span<const LRAutomaton::Item> LRAutomaton::get_kernel(StateId state) const
+{
+    return std::span{kernel_items}.subspan(kernel_offsets[state],
+                                           kernel_offsets[state + 1] - kernel_offsets[state]);
+}
+
+std::span<const LRAutomaton::Transition> LRAutomaton::get_transitions(StateId state) const
+{
+    const auto begin = transition_offsets[state];
+    return std::span{transitions}.subspan(begin, transition_offsets[state + 1] - begin);
+}
+
+std::span<const std::uint32_t> LRAutomaton::get_reductions(StateId state) const
+{
+    return std::span{reductions}.subspan(reduction_offsets[state],
+                                         reduction_offsets[state + 1] - reduction_offsets[state]);
+}
+
+LRAutomaton::StateId LRAutomaton::get_transition(StateId state, SymbolId symbol) const
+{
+    const auto outgoing = get_transitions(state);
+    auto it = std::lower_bound(outgoing.begin(), outgoing.end(), symbol,
+                               [](const Transition &t, SymbolId s) { return t.symbol < s; });
+    return it != outgoing.end() && it->symbol == symbol ? it->target : no_state;
+}
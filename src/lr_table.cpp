@@ -0,0 +1,34 @@
+#include <jacc/lr_table.h>
+
+LRTable::LRTable(SymbolTable symbols, std::size_t num_states)
+    : symbols(std::move(symbols)), states(num_states)
+{
+    const auto &table_symbols = this->symbols;
+    row_of.resize(table_symbols.size());
+    column_of.resize(table_symbols.size());
+    for (SymbolId id = 0; id < table_symbols.size(); id++) {
+        row_of[id] = table_symbols.nonterminal_index(id);
+        column_of[id] = table_symbols.terminal_index(id);
+    }
+    actions.assign(states * num_terminals(), 0);
+    gotos.assign(states * num_nonterminals(), no_state);
+}
+
+void LRTable::set_action(StateId state, SymbolId terminal, Action action)
+{
+    actions[static_cast<std::size_t>(state) * num_terminals() + column_of[terminal]] =
+        (static_cast<std::uint32_t>(action.kind) << value_bits) | (action.value & value_mask);
+}
+
+void LRTable::set_goto(StateId state, SymbolId nonterminal, StateId target)
+{
+    gotos[static_cast<std::size_t>(state) * num_nonterminals() + row_of[nonterminal]] = target;
+}
+
+LRTable::ProductionIndex LRTable::add_production(SymbolId LHS, std::span<const SymbolId> RHS)
+{
+    RHS_symbols.insert(RHS_symbols.end(), RHS.begin(), RHS.end());
+    production_LHS.push_back(LHS);
+    RHS_offsets.push_back(static_cast<std::uint32_t>(RHS_symbols.size()));
+    return static_cast<ProductionIndex>(production_LHS.size() - 1);
+}
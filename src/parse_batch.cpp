@@ -0,0 +1,129 @@
+#include <jacc/parse_batch.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+/**
+ * The inputs [begin, end) a worker still has to parse. Both ends are packed into one word, so
+ * the owner taking from the front and thieves cutting off the back only need a compare-exchange
+ * to agree. An index is only ever in one range, so a range can't come back to a value another
+ * thread saw before.
+ */
+class alignas(64) WorkRange
+{
+  public:
+    void assign(std::uint32_t begin, std::uint32_t end) { range.store(pack(begin, end)); }
+
+    bool take(std::uint32_t &index)
+    {
+        auto current = range.load();
+        for (;;) {
+            const auto [begin, end] = unpack(current);
+            if (begin >= end)
+                return false;
+            if (range.compare_exchange_weak(current, pack(begin + 1, end))) {
+                index = begin;
+                return true;
+            }
+        }
+    }
+
+    bool steal(std::uint32_t &stolen_begin, std::uint32_t &stolen_end)
+    {
+        auto current = range.load();
+        for (;;) {
+            const auto [begin, end] = unpack(current);
+            if (begin >= end)
+                return false;
+            const auto middle = begin + (end - begin) / 2;
+            if (range.compare_exchange_weak(current, pack(begin, middle))) {
+                stolen_begin = middle;
+                stolen_end = end;
+                return true;
+            }
+        }
+    }
+
+    std::uint32_t size() const
+    {
+        const auto [begin, end] = unpack(range.load(std::memory_order_relaxed));
+        return begin < end ? end - begin : 0;
+    }
+
+  private:
+    static std::uint64_t pack(std::uint32_t begin, std::uint32_t end)
+    {
+        return std::uint64_t{begin} << 32 | end;
+    }
+    static std::pair<std::uint32_t, std::uint32_t> unpack(std::uint64_t range)
+    {
+        return {static_cast<std::uint32_t>(range >> 32), static_cast<std::uint32_t>(range)};
+    }
+
+    std::atomic<std::uint64_t> range{0};
+};
+} // namespace
+
+std::vector<BatchResult> parse_batch(const LLParser &parser,
+                                     std::span<const std::vector<SymbolId>> inputs,
+                                     unsigned threads)
+{
+    if (inputs.size() > std::numeric_limits<std::uint32_t>::max())
+        throw std::invalid_argument("too many inputs for one batch");
+    const auto num_inputs = static_cast<std::uint32_t>(inputs.size());
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    const auto num_workers = std::max(1u, std::min(threads, num_inputs));
+
+    std::vector<BatchResult> results(inputs.size());
+    std::vector<WorkRange> ranges(num_workers);
+    for (std::uint32_t worker = 0; worker < num_workers; worker++)
+        ranges[worker].assign(static_cast<std::uint32_t>(std::uint64_t{num_inputs} * worker /
+                                                         num_workers),
+                              static_cast<std::uint32_t>(std::uint64_t{num_inputs} *
+                                                         (worker + 1) / num_workers));
+
+    auto work = [&](std::uint32_t worker) {
+        LLParser own = parser;
+        own.set_trace_sink(nullptr);
+        own.set_syntax_tree(nullptr);
+        for (;;) {
+            for (std::uint32_t index; ranges[worker].take(index);) {
+                own.reset();
+                auto &result = results[index];
+                result.accepted = own.parse(inputs[index].begin(), inputs[index].end());
+                if (!result.accepted)
+                    result.errors = own.get_errors();
+            }
+            // sizes are only a hint, a range may shrink before the steal gets to it
+            auto victim = ranges.end();
+            std::uint32_t largest = 0;
+            for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+                if (it->size() > largest) {
+                    largest = it->size();
+                    victim = it;
+                }
+            }
+            if (victim == ranges.end())
+                return;
+            std::uint32_t begin, end;
+            if (victim->steal(begin, end))
+                ranges[worker].assign(begin, end);
+        }
+    };
+
+    std::vector<std::jthread> pool;
+    pool.reserve(num_workers - 1);
+    for (std::uint32_t worker = 1; worker < num_workers; worker++)
+        pool.emplace_back(work, worker);
+    work(0);
+    // join before results is handed out
+    pool.clear();
+    return results;
+}
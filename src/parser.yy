@@ -10,8 +10,9 @@
 
 %code requires {
     #include <string>
-    #include <spdlog/spdlog.h>
+    #include <string_view>
     #include <jacc/grammar.h>
+    #include <jacc/trace.h>
     class Driver;
 }
 
@@ -36,90 +37,113 @@
   EPSILON
 ;
 
-%token <std::string> TERMINAL
-%token <std::string> NONTERMINAL
+// views into the grammar file, see Driver::parse
+%token <std::string_view> TERMINAL
+%token <std::string_view> NONTERMINAL
+%token <std::string_view> REGEX
 
 %%
-%nterm <Grammar> Grammar;
+// Values are moved from one action to the next, copying rule lists would make loading quadratic
 Grammar : GrammarRuleList
             {
-                $$ = Grammar($1);
-                drv.grammar = $$;
-                spdlog::debug("parsed grammar!");
+                drv.grammar = Grammar(std::move($1), std::move(drv.symbols));
+                drv.grammar.set_token_definitions(std::move(drv.token_definitions));
+                JACC_DEBUG("parsed grammar!");
             }
         ;
 
 %nterm <std::vector<GrammarRule>> GrammarRuleList;
 GrammarRuleList : GrammarRule SEMICOLON
                     {
-                        $$ = {$1};
-                        spdlog::debug("parsed singleton GrammarRuleList!");
+                        $$.emplace_back(std::move($1));
+                        JACC_DEBUG("parsed singleton GrammarRuleList!");
                     }
                 | GrammarRuleList GrammarRule SEMICOLON
                     {
-                        $$ = $1; $$.emplace_back($2);
-                        spdlog::debug("parsed GrammarRuleList!");
+                        $$ = std::move($1); $$.emplace_back(std::move($2));
+                        JACC_DEBUG("parsed GrammarRuleList!");
+                    }
+                | TokenDefinition SEMICOLON
+                    { $$ = {}; }
+                | GrammarRuleList TokenDefinition SEMICOLON
+                    { $$ = std::move($1); }
+                ;
+
+// Terminals are only looked up once the whole grammar is known, see generate_lexer
+TokenDefinition : TERMINAL COLON REGEX
+                    {
+                        drv.token_definitions.emplace_back(std::string{$1}, std::string{$3});
+                        JACC_DEBUG("parsed TokenDefinition!");
                     }
                 ;
 
 %nterm <GrammarRule> GrammarRule;
 GrammarRule : LHS COLON RHS
                 {
-                    $$ = GrammarRule($1,$3);
-                    spdlog::debug("parsed GrammarRule!");
+                    $$ = GrammarRule(std::move($1), std::move($3));
+                    JACC_DEBUG("parsed GrammarRule!");
                 }
             ;
 
 %nterm <ProductionSymbol> LHS;
 LHS : NONTERMINAL
         {
-            $$ = ProductionSymbol($1, ProductionSymbol::Kind::NonTerminal);
-            spdlog::debug("parsed LHS!");
+            auto id = drv.symbols.intern($1, ProductionSymbol::Kind::NonTerminal);
+            $$ = drv.symbols.get_symbol(id);
+            JACC_DEBUG("parsed LHS!");
         }
     ;
 
 %nterm <std::vector<Production>> RHS;
 RHS : ProductionList
-        { $$ = $1; spdlog::debug("parsed RHS!"); }
+        { $$ = std::move($1); JACC_DEBUG("parsed RHS!"); }
     ;
 
 %nterm <std::vector<Production>> ProductionList;
 ProductionList : Production
-                   { $$ = {$1}; spdlog::debug("Parsed Singleton Productionlist!"); }
+                   {
+                       $$.emplace_back(std::move($1));
+                       JACC_DEBUG("Parsed Singleton Productionlist!");
+                   }
                | ProductionList ALTERNATIVE Production
                    {
-                       $$ = $1; $$.emplace_back($3);
-                       spdlog::debug("Parsed Alternative Productionlist!");
+                       $$ = std::move($1); $$.emplace_back(std::move($3));
+                       JACC_DEBUG("Parsed Alternative Productionlist!");
                    }
                ;
 
 %nterm <Production> Production;
 Production : SymbolList
-               { $$ = Production($1); spdlog::debug("parsed Production!"); }
+               { $$ = Production(std::move($1)); JACC_DEBUG("parsed Production!"); }
            ;
 
 %nterm <std::vector<ProductionSymbol>> SymbolList;
 SymbolList : Symbol
-               {$$ = {$1}; spdlog::debug("parsed singleton SymbolList!"); }
+               {$$.emplace_back(std::move($1)); JACC_DEBUG("parsed singleton SymbolList!"); }
            | SymbolList Symbol
-               {$$ = $1; $$.emplace_back($2); spdlog::debug("parsed SymbolList!"); }
+               {
+                   $$ = std::move($1); $$.emplace_back(std::move($2));
+                   JACC_DEBUG("parsed SymbolList!");
+               }
            ;
 
 %nterm <ProductionSymbol> Symbol;
 Symbol : NONTERMINAL
            {
-               $$ = ProductionSymbol($1, ProductionSymbol::Kind::NonTerminal);
-               spdlog::debug("parsed Nonterminal Symbol!");
+               auto id = drv.symbols.intern($1, ProductionSymbol::Kind::NonTerminal);
+               $$ = drv.symbols.get_symbol(id);
+               JACC_DEBUG("parsed Nonterminal Symbol!");
            }
        | TERMINAL
            {
-               $$ = ProductionSymbol($1, ProductionSymbol::Kind::Terminal);
-               spdlog::debug("parsed Terminal Symbol!");
+               auto id = drv.symbols.intern($1, ProductionSymbol::Kind::Terminal);
+               $$ = drv.symbols.get_symbol(id);
+               JACC_DEBUG("parsed Terminal Symbol!");
            }
        | EPSILON
            {
                $$ = ProductionSymbol::create_epsilon();
-               spdlog::debug("parsed epsilon!");
+               JACC_DEBUG("parsed epsilon!");
            }
        ;
 %%
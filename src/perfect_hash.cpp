@@ -0,0 +1,77 @@
+#include <jacc/perfect_hash.h>
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+// keys per bucket on average, more makes the table smaller and the search longer
+constexpr std::size_t bucket_size = 4;
+// every seed fails only if keys repeat, or with negligible probability
+constexpr std::uint32_t max_seeds = 64;
+
+/**
+ * Tries to place every bucket with the given seed. Fails if some bucket finds no displacement,
+ * for example because two of its keys hash to the same value.
+ */
+bool place_buckets(std::span<const std::string_view> keys, std::uint32_t seed,
+                   std::vector<std::uint32_t> &displacements)
+{
+    const auto num_slots = keys.size();
+    std::vector<std::vector<std::uint32_t>> buckets(displacements.size());
+    for (auto key : keys) {
+        const auto h = PerfectHash::hash(key, seed);
+        const auto bucket =
+            PerfectHash::reduce(static_cast<std::uint32_t>(h >> 32), buckets.size());
+        buckets[bucket].push_back(static_cast<std::uint32_t>(h));
+    }
+    std::vector<std::size_t> order(buckets.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    // the last buckets have few free slots left, about num_slots tries find one
+    const auto max_displacement = static_cast<std::uint32_t>(64 * num_slots + 1024);
+    std::vector<bool> taken(num_slots);
+    std::vector<std::uint32_t> slots;
+    for (auto bucket : order) {
+        const auto &hashes = buckets[bucket];
+        if (hashes.empty())
+            break;
+        bool placed = false;
+        for (std::uint32_t displacement = 0; !placed && displacement < max_displacement;
+             displacement++) {
+            slots.clear();
+            placed = true;
+            for (auto h : hashes) {
+                const auto slot = PerfectHash::reduce(PerfectHash::mix(h ^ displacement),
+                                                      num_slots);
+                if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                    placed = false;
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (placed)
+                displacements[bucket] = displacement;
+        }
+        if (!placed)
+            return false;
+        for (auto slot : slots)
+            taken[slot] = true;
+    }
+    return true;
+}
+} // namespace
+
+PerfectHash::PerfectHash(std::span<const std::string_view> keys)
+    : num_slots(keys.size()),
+      displacements(std::vector<std::uint32_t>((keys.size() + bucket_size - 1) / bucket_size, 0))
+{
+    while (!place_buckets(keys, seed, displacements.edit())) {
+        if (++seed == max_seeds)
+            throw std::invalid_argument("the keys of a perfect hash have to be distinct");
+    }
+}
@@ -0,0 +1,97 @@
+#include <jacc/grammar.h>
+#include <jacc/symbol_table.h>
+
+SymbolTable::SymbolTable()
+{
+    symbols = {ProductionSymbol::create_epsilon(), ProductionSymbol::create_EOI()};
+    kinds = std::vector{static_cast<std::uint8_t>(ProductionSymbol::Kind::Terminal),
+                        static_cast<std::uint8_t>(ProductionSymbol::Kind::EndOfInput)};
+    dense_indices = std::vector<std::uint32_t>{no_index, 0};
+    terminal_ids = std::vector<SymbolId>{eoi_id};
+}
+
+SymbolId SymbolTable::intern(const ProductionSymbol &symbol)
+{
+    if (symbol.is_epsilon())
+        return epsilon_id;
+    if (symbol.is_EOI())
+        return eoi_id;
+    if (!symbol.is_initialized())
+        return invalid_id;
+    return intern(symbol.get_raw_symbol().value(), symbol.is_nonTerminal()
+                                                       ? ProductionSymbol::Kind::NonTerminal
+                                                       : ProductionSymbol::Kind::Terminal);
+}
+
+SymbolId SymbolTable::intern(std::string_view name, ProductionSymbol::Kind kind)
+{
+    const bool nonterminal = kind == ProductionSymbol::Kind::NonTerminal;
+    if (const auto id = find(name, kind); id != invalid_id)
+        return id;
+    if (mapped) {
+        const auto &interned = intern_mapped();
+        symbols = interned.symbols;
+        terminal_lookup = interned.terminal_lookup;
+        nonterminal_lookup = interned.nonterminal_lookup;
+        mapped.reset();
+    }
+
+    const auto id = static_cast<SymbolId>(symbols.size());
+    auto &dense_ids = nonterminal ? nonterminal_ids.edit() : terminal_ids.edit();
+    symbols.emplace_back(std::string{name}, kind);
+    kinds.edit().push_back(static_cast<std::uint8_t>(kind));
+    dense_indices.edit().push_back(static_cast<std::uint32_t>(dense_ids.size()));
+    dense_ids.push_back(id);
+    (nonterminal ? nonterminal_lookup : terminal_lookup).emplace(*symbols.back().get_raw_symbol(),
+                                                                 id);
+    return id;
+}
+
+SymbolId SymbolTable::find(const ProductionSymbol &symbol) const
+{
+    if (symbol.is_epsilon())
+        return epsilon_id;
+    if (symbol.is_EOI())
+        return eoi_id;
+    if (!symbol.is_initialized())
+        return invalid_id;
+    return find(symbol.get_raw_symbol().value(), symbol.is_nonTerminal()
+                                                     ? ProductionSymbol::Kind::NonTerminal
+                                                     : ProductionSymbol::Kind::Terminal);
+}
+
+SymbolId SymbolTable::find(std::string_view name, ProductionSymbol::Kind kind) const
+{
+    const bool nonterminal = kind == ProductionSymbol::Kind::NonTerminal;
+    const auto &lookup = !mapped      ? (nonterminal ? nonterminal_lookup : terminal_lookup)
+                         : nonterminal ? intern_mapped().nonterminal_lookup
+                                       : intern_mapped().terminal_lookup;
+    auto it = lookup.find(name);
+    return it == lookup.end() ? invalid_id : it->second;
+}
+
+std::string_view SymbolTable::name(SymbolId id) const
+{
+    if (!mapped)
+        return symbols[id].get_raw_symbol() ? std::string_view{*symbols[id].get_raw_symbol()}
+                                            : std::string_view{};
+    const auto offsets = mapped->name_offsets;
+    return {mapped->names.data() + offsets[id], offsets[id + 1] - offsets[id]};
+}
+
+const SymbolTable::Mapped &SymbolTable::intern_mapped() const
+{
+    std::call_once(mapped->interned, [this] {
+        auto &interned = *mapped;
+        interned.symbols = {ProductionSymbol::create_epsilon(), ProductionSymbol::create_EOI()};
+        for (SymbolId id = eoi_id + 1; id < size(); id++) {
+            const auto kind = static_cast<ProductionSymbol::Kind>(kinds[id]);
+            interned.symbols.emplace_back(std::string{name(id)}, kind);
+            auto &lookup = kind == ProductionSymbol::Kind::NonTerminal
+                               ? interned.nonterminal_lookup
+                               : interned.terminal_lookup;
+            lookup.emplace(name(id), id);
+        }
+    });
+    return *mapped;
+}
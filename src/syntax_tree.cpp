@@ -0,0 +1,386 @@
+#include <jacc/syntax_tree.h>
+#include <algorithm>
+#include <stdexcept>
+
+void SyntaxTree::clear()
+{
+    num_nodes = 0;
+    free_runs.clear();
+    free_lengths.clear();
+    num_free = 0;
+    lists.clear();
+}
+
+void SyntaxTree::release()
+{
+    clear();
+    chunks.clear();
+    chunks.shrink_to_fit();
+}
+
+SyntaxTree::NodeId SyntaxTree::allocate(std::size_t count)
+{
+    // the shortest free run that is long enough, what is left of it stays free
+    if (const auto fit = free_lengths.lower_bound({count, 0}); fit != free_lengths.end()) {
+        const auto [length, first] = *fit;
+        free_lengths.erase(fit);
+        free_runs.erase(first);
+        if (length > count) {
+            const auto rest = first + static_cast<NodeId>(count);
+            free_runs.emplace(rest, length - count);
+            free_lengths.emplace(length - count, rest);
+        }
+        num_free -= count;
+        return first;
+    }
+    if (count >= no_node - num_nodes)
+        throw std::length_error("syntax tree has too many nodes");
+    while (num_nodes + count > chunks.size() * chunk_size)
+        chunks.push_back(std::make_unique_for_overwrite<Node[]>(chunk_size));
+    const auto first = static_cast<NodeId>(num_nodes);
+    num_nodes += count;
+    return first;
+}
+
+void SyntaxTree::free_run(NodeId first, std::size_t count)
+{
+    if (!lists.empty()) {
+        for (auto id = first; id < first + count; id++)
+            lists.erase(id);
+    }
+    num_free += count;
+    if (const auto next = free_runs.find(first + static_cast<NodeId>(count));
+        next != free_runs.end()) {
+        count += next->second;
+        free_lengths.erase({next->second, next->first});
+        free_runs.erase(next);
+    }
+    if (auto previous = free_runs.lower_bound(first); previous != free_runs.begin()) {
+        --previous;
+        if (previous->first + previous->second == first) {
+            first = previous->first;
+            count += previous->second;
+            free_lengths.erase({previous->second, previous->first});
+            free_runs.erase(previous);
+        }
+    }
+    // a run at the end goes back to the arena
+    if (first + count == num_nodes) {
+        num_nodes = first;
+        num_free -= count;
+        return;
+    }
+    free_runs.emplace(first, count);
+    free_lengths.emplace(count, first);
+}
+
+SyntaxTree::NodeId SyntaxTree::add_root(SymbolId symbol)
+{
+    clear();
+    const auto id = allocate(1);
+    (*this)[id] = Node{symbol};
+    return id;
+}
+
+SyntaxTree::NodeId SyntaxTree::add_node(SymbolId symbol)
+{
+    const auto id = allocate(1);
+    (*this)[id] = Node{symbol};
+    return id;
+}
+
+SyntaxTree::NodeId SyntaxTree::add_children(NodeId parent, std::span<const SymbolId> symbols)
+{
+    if (symbols.empty())
+        return no_node;
+    const auto first = allocate(symbols.size());
+    for (std::size_t i = 0; i < symbols.size(); i++) {
+        const auto id = first + static_cast<NodeId>(i);
+        const auto next = i + 1 < symbols.size() ? id + 1 : no_node;
+        (*this)[id] = Node{symbols[i], parent, no_node, next};
+    }
+    (*this)[parent].first_child = first;
+    return first;
+}
+
+SyntaxTree::NodeId SyntaxTree::add_link(NodeId list, NodeId previous)
+{
+    const auto id = allocate(1);
+    (*this)[id] = Node{(*this)[list].symbol, list};
+    if (previous == no_node)
+        (*this)[list].first_child = id;
+    else
+        (*this)[previous].next_sibling = id;
+    return id;
+}
+
+void SyntaxTree::free_siblings(NodeId first, NodeId last, std::span<const NodeId> kept)
+{
+    // the chains left to free and where each one ends, runs of consecutive siblings are freed
+    // together so they can be allocated together again
+    std::vector<std::pair<NodeId, NodeId>> chains{{first, last}};
+    while (!chains.empty()) {
+        auto [id, end] = chains.back();
+        chains.pop_back();
+        auto run = no_node;
+        std::size_t run_length = 0;
+        for (; id != end; id = (*this)[id].next_sibling) {
+            const bool keep = std::binary_search(kept.begin(), kept.end(), id);
+            if (!keep && (*this)[id].first_child != no_node)
+                chains.emplace_back((*this)[id].first_child, no_node);
+            if (!keep && run != no_node && run + run_length == id) {
+                run_length++;
+                continue;
+            }
+            if (run != no_node)
+                free_run(run, run_length);
+            run = keep ? no_node : id;
+            run_length = keep ? 0 : 1;
+        }
+        if (run != no_node)
+            free_run(run, run_length);
+    }
+}
+
+void SyntaxTree::splice(NodeId placeholder, NodeId node)
+{
+    const auto parent = (*this)[placeholder].parent;
+    (*this)[node].parent = parent;
+    (*this)[node].next_sibling = (*this)[placeholder].next_sibling;
+    if ((*this)[parent].first_child == placeholder) {
+        (*this)[parent].first_child = node;
+    } else {
+        auto previous = (*this)[parent].first_child;
+        while ((*this)[previous].next_sibling != placeholder)
+            previous = (*this)[previous].next_sibling;
+        (*this)[previous].next_sibling = node;
+    }
+    free_run(placeholder, 1);
+}
+
+void SyntaxTree::replace(NodeId id, NodeId with)
+{
+    auto &node = (*this)[id];
+    const auto &other = (*this)[with];
+    node.value = other.value;
+    node.first_child = other.first_child;
+    node.length = other.length;
+    for_each_child(id, [&](auto child) { (*this)[child].parent = id; });
+    lists.erase(id);
+    free_run(with, 1);
+}
+
+SyntaxTree::Link SyntaxTree::find_link(NodeId list, std::size_t offset)
+{
+    auto found = lists.find(list);
+    if (found == lists.end())
+        found = lists.emplace(list, ListIndex(*this, list)).first;
+    return found->second.find(offset);
+}
+
+void SyntaxTree::resize_link(NodeId list, std::size_t index, std::uint32_t length)
+{
+    if (auto found = lists.find(list); found != lists.end())
+        found->second.resize(index, length);
+}
+
+void SyntaxTree::replace_links(NodeId list, std::size_t first, std::size_t last, NodeId links)
+{
+    auto &index = lists.at(list);
+    last = std::min(last, index.size());
+    const auto previous = first > 0 ? index.at(first - 1) : no_node;
+    const auto next = last < index.size() ? index.at(last) : no_node;
+    index.replace(first, last, *this, links);
+
+    auto link = links;
+    for (;; link = (*this)[link].next_sibling) {
+        (*this)[link].parent = list;
+        if ((*this)[link].next_sibling == no_node)
+            break;
+    }
+    (*this)[link].next_sibling = next;
+    if (previous != no_node) {
+        (*this)[previous].next_sibling = links;
+    } else {
+        // a list was expanded with the production of its first link
+        (*this)[list].first_child = links;
+        (*this)[list].value = (*this)[links].value;
+    }
+}
+
+std::size_t SyntaxTree::start(NodeId id) const
+{
+    std::size_t start = 0;
+    for (auto parent = (*this)[id].parent; parent != no_node; parent = (*this)[id].parent) {
+        for (auto sibling = (*this)[parent].first_child; sibling != id;
+             sibling = (*this)[sibling].next_sibling)
+            start += (*this)[sibling].length;
+        id = parent;
+    }
+    return start;
+}
+
+SyntaxTree::ListIndex::ListIndex(const SyntaxTree &tree, NodeId list)
+{
+    root = build(tree, tree[list].first_child);
+}
+
+SyntaxTree::Link SyntaxTree::ListIndex::find(std::size_t offset) const
+{
+    Link link{0, no_node, 0};
+    for (auto entry = root; entry != no_entry;) {
+        const auto &e = entries[entry];
+        if (offset < sum(e.left)) {
+            entry = e.left;
+            continue;
+        }
+        offset -= sum(e.left);
+        link.start += sum(e.left);
+        link.index += count(e.left);
+        if (offset < e.length) {
+            link.id = e.link;
+            return link;
+        }
+        offset -= e.length;
+        link.start += e.length;
+        link.index++;
+        entry = e.right;
+    }
+    return link;
+}
+
+SyntaxTree::NodeId SyntaxTree::ListIndex::at(std::size_t index) const
+{
+    for (auto entry = root; entry != no_entry;) {
+        const auto &e = entries[entry];
+        if (index < count(e.left)) {
+            entry = e.left;
+            continue;
+        }
+        index -= count(e.left);
+        if (index == 0)
+            return e.link;
+        index--;
+        entry = e.right;
+    }
+    return no_node;
+}
+
+void SyntaxTree::ListIndex::resize(std::size_t index, std::uint32_t length)
+{
+    resize(root, index, length);
+}
+
+void SyntaxTree::ListIndex::resize(std::uint32_t entry, std::size_t index, std::uint32_t length)
+{
+    if (entry == no_entry)
+        return;
+    const auto before = count(entries[entry].left);
+    if (index < before)
+        resize(entries[entry].left, index, length);
+    else if (index > before)
+        resize(entries[entry].right, index - before - 1, length);
+    else
+        entries[entry].length = length;
+    update(entry);
+}
+
+void SyntaxTree::ListIndex::replace(std::size_t first, std::size_t last, const SyntaxTree &tree,
+                                    NodeId links)
+{
+    std::uint32_t front, middle, back;
+    split(root, first, front, back);
+    split(back, last - first, middle, back);
+    for (std::vector<std::uint32_t> pending{middle}; !pending.empty();) {
+        const auto entry = pending.back();
+        pending.pop_back();
+        if (entry == no_entry)
+            continue;
+        unused.push_back(entry);
+        pending.push_back(entries[entry].left);
+        pending.push_back(entries[entry].right);
+    }
+    root = merge(merge(front, build(tree, links)), back);
+}
+
+void SyntaxTree::ListIndex::update(std::uint32_t entry)
+{
+    auto &e = entries[entry];
+    e.count = 1 + count(e.left) + count(e.right);
+    e.sum = e.length + sum(e.left) + sum(e.right);
+}
+
+std::uint32_t SyntaxTree::ListIndex::build(const SyntaxTree &tree, NodeId links)
+{
+    // a Cartesian tree over the links in order, whatever leaves the right spine is complete
+    std::vector<std::uint32_t> spine;
+    for (auto link = links; link != no_node; link = tree[link].next_sibling) {
+        // xorshift, the priorities only have to look random
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        const Entry added{link, tree[link].length, seed, 1, 0, no_entry, no_entry};
+        std::uint32_t entry;
+        if (!unused.empty()) {
+            entry = unused.back();
+            unused.pop_back();
+            entries[entry] = added;
+        } else {
+            entry = static_cast<std::uint32_t>(entries.size());
+            entries.push_back(added);
+        }
+        auto below = no_entry;
+        while (!spine.empty() && entries[spine.back()].priority < added.priority) {
+            below = spine.back();
+            spine.pop_back();
+            update(below);
+        }
+        entries[entry].left = below;
+        if (!spine.empty())
+            entries[spine.back()].right = entry;
+        spine.push_back(entry);
+    }
+    for (auto entry = spine.rbegin(); entry != spine.rend(); ++entry)
+        update(*entry);
+    return spine.empty() ? no_entry : spine.front();
+}
+
+std::uint32_t SyntaxTree::ListIndex::merge(std::uint32_t left, std::uint32_t right)
+{
+    if (left == no_entry)
+        return right;
+    if (right == no_entry)
+        return left;
+    if (entries[left].priority > entries[right].priority) {
+        const auto merged = merge(entries[left].right, right);
+        entries[left].right = merged;
+        update(left);
+        return left;
+    }
+    const auto merged = merge(left, entries[right].left);
+    entries[right].left = merged;
+    update(right);
+    return right;
+}
+
+void SyntaxTree::ListIndex::split(std::uint32_t entry, std::size_t index, std::uint32_t &left,
+                                  std::uint32_t &right)
+{
+    if (entry == no_entry) {
+        left = right = no_entry;
+        return;
+    }
+    const auto before = count(entries[entry].left);
+    if (index <= before) {
+        std::uint32_t below;
+        split(entries[entry].left, index, left, below);
+        entries[entry].left = below;
+        right = entry;
+    } else {
+        std::uint32_t below;
+        split(entries[entry].right, index - before - 1, below, right);
+        entries[entry].right = below;
+        left = entry;
+    }
+    update(entry);
+}
@@ -1,82 +1,576 @@
 #include <jacc/table_driven_ll_parser.h>
+#include <jacc/first_follow_set_generator.h>
 #include <jacc/grammar.h>
+#include <jacc/ll_table_generator.h>
+#include <jacc/trace.h>
+#include <algorithm>
+#include <cstdint>
+#include <optional>
 #include <span>
-#include <spdlog/spdlog.h>
-#include <stack>
+#include <stdexcept>
 
-bool LLParser::parse(std::vector<ProductionSymbol> &input)
+namespace
 {
-    input.push_back(eoi_symbol);
-    context.parse_stack.push(eoi_symbol);
-    context.parse_stack.push(context.start_symbol);
+[[maybe_unused]] std::vector<ProductionSymbol> to_symbols(std::span<const SymbolId> ids,
+                                                          const SymbolTable &symbols)
+{
+    std::vector<ProductionSymbol> result;
+    result.reserve(ids.size());
+    for (auto id : ids)
+        result.push_back(symbols.get_symbol(id));
+    return result;
+}
+
+/**
+ * Walks the old subtree that is parsed again in token order and hands out the subtrees in it that
+ * can be reused: the ones whose tokens and lookahead token weren't edited, as those are parsed
+ * the same way again. Positions are only asked for in increasing order, so every old node is
+ * visited at most once.
+ */
+class ReuseCursor
+{
+  public:
+    ReuseCursor(const SyntaxTree &tree, SyntaxTree::NodeId root, std::size_t start,
+                const LLParser::TokenEdit &edit)
+        : tree(tree),
+          edit(edit)
+    {
+        path.push_back({root, start});
+    }
+
+    // an old node of symbol at position of the new input that can be reused, or no_node
+    SyntaxTree::NodeId find(SymbolId symbol, std::size_t position)
+    {
+        // inserted tokens weren't there before
+        if (position >= edit.position && position < edit.position + edit.inserted)
+            return SyntaxTree::no_node;
+        const auto old_position =
+            position < edit.position ? position : position - edit.inserted + edit.removed;
+        while (!path.empty() && path.back().start <= old_position) {
+            const auto [id, start] = path.back();
+            const auto &node = tree[id];
+            const auto end = start + node.length;
+            // a link only spans its own production, not the rest of the list like X would
+            if (start == old_position && node.symbol == symbol && unchanged(start, end) &&
+                !tree.is_link(id)) {
+                next();
+                return id;
+            }
+            if ((start == old_position || end > old_position) &&
+                node.first_child != SyntaxTree::no_node)
+                path.push_back({node.first_child, start});
+            else
+                next();
+        }
+        return SyntaxTree::no_node;
+    }
+
+  private:
+    struct Entry {
+        SyntaxTree::NodeId id;
+        std::size_t start;
+    };
+
+    bool unchanged(std::size_t start, std::size_t end) const
+    {
+        return end < edit.position || start >= edit.position + edit.removed;
+    }
+    // moves past the current node, the root has no siblings
+    void next()
+    {
+        while (!path.empty()) {
+            const auto [id, start] = path.back();
+            path.pop_back();
+            const auto sibling = tree[id].next_sibling;
+            if (!path.empty() && sibling != SyntaxTree::no_node) {
+                path.push_back({sibling, start + tree[id].length});
+                return;
+            }
+        }
+    }
+
+    const SyntaxTree &tree;
+    const LLParser::TokenEdit &edit;
+    // the current node is last, the ancestors up to the root before it
+    std::vector<Entry> path;
+};
+} // namespace
+
+LLParser::TokenEdit LLParser::TokenEdit::between(std::span<const SymbolId> before,
+                                                 std::span<const SymbolId> after)
+{
+    const auto shorter = std::min(before.size(), after.size());
+    std::size_t prefix = 0;
+    while (prefix < shorter && before[prefix] == after[prefix])
+        prefix++;
+    std::size_t suffix = 0;
+    while (suffix < shorter - prefix &&
+           before[before.size() - 1 - suffix] == after[after.size() - 1 - suffix])
+        suffix++;
+    return {prefix, before.size() - prefix - suffix, after.size() - prefix - suffix};
+}
+
+LLParser::LLParser(LLTable table) : LLParser(std::make_shared<const LLTable>(std::move(table)))
+{
+}
+
+LLParser::LLParser(std::shared_ptr<const LLTable> table)
+    : parse_table(std::move(table)),
+      context(parse_table->get_start_symbol())
+{
+}
+
+LLParser::LLParser(const ParseTable &table, ProductionSymbol start_symbol)
+    : LLParser(to_dense_ll_table(table, start_symbol))
+{
+}
+
+bool LLParser::parse(const std::vector<ProductionSymbol> &input)
+{
+    JACC_DEBUG("parse_table: {}x{} cells, {} productions", parse_table->num_rows(),
+               parse_table->num_columns(), parse_table->num_productions());
+    return parse(input.begin(), input.end());
+}
 
-    spdlog::debug("parse_table:{}", parse_table);
-    while (!context.done && context.error == ParseContext::ErrorType::NOERROR) {
-        spdlog::debug("remaining inputs: ");
-        auto span = std::span{input};
-        spdlog::debug(span.subspan(context.inputIndex));
-        spdlog::debug("parsestack: {}", context.parse_stack);
-        auto top_of_stack = context.parse_stack.top();
-        auto current_input = input[context.inputIndex];
-        spdlog::debug("current: {}", current_input);
-        handle_current_symbol(current_input, top_of_stack);
+bool LLParser::start_token(SymbolId token)
+{
+    if (context.error != ParseContext::ErrorType::NOERROR)
+        return false;
+    if (context.done) {
+        report_error(ParseContext::ErrorType::TRAILINGINPUT, token, SymbolTable::eoi_id);
+        if (recovery != Recovery::None) {
+            // the parse stack is gone, all that is left is to skip the rest of the input
+            context.error = ParseContext::ErrorType::NOERROR;
+            context.recovering = true;
+            context.tokens_consumed++;
+        }
+        return false;
     }
 
-    if (context.parse_stack.empty()) {
-        spdlog::debug("stack empty");
-        spdlog::debug("context says its complete: {}", context.done);
-    } else {
-        spdlog::debug("not empty");
-        spdlog::debug("context says its complete: {}", context.done);
-        if (context.inputIndex < input.size()) {
-            auto span = std::span{input};
-            spdlog::debug(span.subspan(context.inputIndex));
+    // tokens that never appear in the table get invalid_id and can never match
+    if (token < symbols().size())
+        JACC_TRACE("current: {}", symbols().get_symbol(token));
+    else
+        JACC_TRACE("current: unknown token");
+    return true;
+}
+
+bool LLParser::finished()
+{
+    JACC_DEBUG("context has error: {}", context.parse_error_to_string(context.error));
+    return context.done && context.error == ParseContext::ErrorType::NOERROR &&
+           context.errors.empty();
+}
+
+bool LLParser::reparse(std::span<const SymbolId> input, const TokenEdit &edit)
+{
+    auto *tree = context.tree;
+    if (!tree || !finished()) {
+        reset();
+        return parse(input.begin(), input.end());
+    }
+    const auto root = tree->root();
+    const std::size_t old_size = (*tree)[root].length;
+    if (edit.position + edit.removed > old_size ||
+        input.size() != old_size - edit.removed + edit.inserted)
+        throw std::invalid_argument("the edit doesn't fit the last input");
+    if (edit.removed == 0 && edit.inserted == 0)
+        return true;
+
+    // nonterminals around the edit from the root down. Nothing in front of one was edited, so
+    // parsing gets to it with the same parse stack as last time and can start over there
+    std::vector<Enclosing> enclosing{{root, 0, no_link}};
+    while (edit.position > 0) {
+        const auto [node, start, link] = enclosing.back();
+        if (tree->is_list(node)) {
+            // the link with the token in front of the edit, parsing from a link can go on past
+            // it and pick up the old links after the edit
+            const auto found = tree->find_link(node, edit.position - 1 - start);
+            enclosing.push_back({found.id, start + found.start, found.index});
+            continue;
+        }
+        bool deeper = false;
+        auto child_start = start;
+        for (auto child = (*tree)[node].first_child; child != SyntaxTree::no_node;
+             child = (*tree)[child].next_sibling) {
+            const auto child_end = child_start + (*tree)[child].length;
+            if (symbols().is_nonterminal((*tree)[child].symbol) && child_start < edit.position &&
+                edit.position + edit.removed <= child_end) {
+                enclosing.push_back({child, child_start, no_link});
+                deeper = true;
+                break;
+            }
+            child_start = child_end;
+        }
+        if (!deeper)
+            break;
+    }
+
+    const auto delta = static_cast<std::int64_t>(edit.inserted) -
+                       static_cast<std::int64_t>(edit.removed);
+    for (auto e = enclosing.size(); e-- > 0;) {
+        const auto [old_node, start, link] = enclosing[e];
+        Attempt attempt{old_node, start};
+        attempt.new_node = tree->add_node((*tree)[old_node].symbol);
+        // the rest of a list can't end anywhere else when parsed from its list, so that is
+        // skipped once parsing from one of its links didn't end like before
+        auto old_end = start + (*tree)[old_node].length;
+        if (link != no_link) {
+            attempt.list = enclosing[e - 1].node;
+            attempt.list_start = enclosing[e - 1].start;
+            attempt.link = link;
+            old_end = attempt.list_start + (*tree)[attempt.list].length;
+            (*tree)[attempt.new_node].parent = attempt.list;
+            (*tree)[attempt.new_node].value = SyntaxTree::no_node;
+        }
+        // an error here is one a whole parse runs into as well
+        if (!reparse_subtree(input, edit, attempt))
+            break;
+        // ending at the same token as before, the parse goes on like last time
+        const auto end = context.tokens_consumed;
+        const bool resynced =
+            attempt.resync.id != SyntaxTree::no_node ||
+            (end >= edit.position + edit.inserted && end - edit.inserted + edit.removed == old_end);
+        // a first link that ends the chain makes the list a plain node, which only parsing
+        // from the list gets right
+        const bool still_list = link != 0 || is_tail_recursive((*tree)[attempt.new_node].value);
+        if (!resynced || !still_list) {
+            tree->free_siblings(attempt.new_node, SyntaxTree::no_node);
+            if (link != no_link && !resynced)
+                e--;
+            continue;
         }
+
+        // the old nodes that were reused move into the new subtree, the rest of the old one
+        // is freed
+        std::vector<SyntaxTree::NodeId> kept;
+        for (const auto &[placeholder, old] : attempt.reused)
+            kept.push_back(old);
+        std::sort(kept.begin(), kept.end());
+        if (link != no_link) {
+            tree->free_siblings(old_node, attempt.resync.id, kept);
+            for (const auto &[placeholder, old] : attempt.reused)
+                tree->splice(placeholder, old);
+            tree->replace_links(attempt.list, link,
+                                attempt.resync.id != SyntaxTree::no_node ? attempt.resync.index
+                                                                         : no_link,
+                                attempt.new_node);
+        } else {
+            tree->free_siblings((*tree)[old_node].first_child, SyntaxTree::no_node, kept);
+            for (const auto &[placeholder, old] : attempt.reused)
+                tree->splice(placeholder, old);
+            tree->replace(old_node, attempt.new_node);
+        }
+        for (auto i = e; i-- > 0;) {
+            auto &node = (*tree)[enclosing[i].node];
+            node.length = static_cast<std::uint32_t>(node.length + delta);
+            if (enclosing[i].link != no_link)
+                tree->resize_link(enclosing[i - 1].node, enclosing[i].link, node.length);
+        }
+
+        context.parse_stack.clear();
+        context.node_stack.clear();
+        context.tokens_consumed = input.size() + 1;
+        context.done = true;
+        return true;
     }
-    spdlog::info("context has error: {}", context.parse_error_to_string(context.error));
-    return context.error == ParseContext::ErrorType::NOERROR;
+    reset();
+    return parse(input.begin(), input.end());
 }
 
-void LLParser::handle_current_symbol(const ProductionSymbol &current, const ProductionSymbol &top)
+bool LLParser::reparse_subtree(std::span<const SymbolId> input, const TokenEdit &edit,
+                               Attempt &attempt)
 {
+    auto &tree = *context.tree;
+    // the end of input at the bottom stays, the subtree is parsed once only it is left
+    context.parse_stack.assign({SymbolTable::eoi_id, tree[attempt.new_node].symbol});
+    context.node_stack.assign({SyntaxTree::no_node, attempt.new_node});
+    context.tokens_consumed = attempt.start;
+    context.done = false;
+    context.error = ErrorType::NOERROR;
+    context.errors.clear();
+    context.recovering = false;
+    context.inserted = false;
+    context.mark_completions = true;
+
+    ReuseCursor cursor(tree, attempt.old_node, attempt.start, edit);
+    while (context.parse_stack.size() > 1) {
+        const auto top = context.parse_stack.back();
+        if (!(top & completion_marker) && symbols().is_nonterminal(top)) {
+            const auto node = context.node_stack.back();
+            const auto position = context.tokens_consumed;
+            if (tree.is_link(node)) {
+                // past the edit, the list goes on like last time from an old link that starts
+                // at the same token
+                const auto old_offset = position - edit.inserted + edit.removed;
+                if (tree[node].parent == attempt.list && node != attempt.new_node &&
+                    position >= edit.position + edit.inserted &&
+                    old_offset < attempt.list_start + tree[attempt.list].length) {
+                    const auto found = tree.find_link(attempt.list,
+                                                      old_offset - attempt.list_start);
+                    if (found.start == old_offset - attempt.list_start) {
+                        // the length of the link before is only known here
+                        const auto previous = tree[node].value;
+                        tree[previous].length =
+                            static_cast<std::uint32_t>(position - tree[previous].length);
+                        tree[previous].next_sibling = SyntaxTree::no_node;
+                        tree.free_siblings(node, SyntaxTree::no_node);
+                        attempt.resync = found;
+                        return true;
+                    }
+                }
+            } else if (const auto reused = cursor.find(top, position);
+                       reused != SyntaxTree::no_node) {
+                // stands in for the old node, which is moved here once the subtree is kept
+                attempt.reused.emplace_back(node, reused);
+                context.tokens_consumed += tree[reused].length;
+                pop_symbol();
+                continue;
+            }
+        }
+        const auto token = context.tokens_consumed < input.size() ? input[context.tokens_consumed]
+                                                                  : SymbolTable::eoi_id;
+        if (handle_current_symbol(token, top).kind == Step::Kind::Failed)
+            return false;
+    }
+    return true;
+}
+
+void LLParser::set_recovery(Recovery mode, std::vector<DenseBitset> follow_sets)
+{
+    recovery = mode;
+    follow_sets.resize(symbols().num_nonterminals(), DenseBitset(symbols().num_terminals()));
+    sync_sets = std::make_shared<const std::vector<DenseBitset>>(std::move(follow_sets));
+    context.reset();
+}
+
+void LLParser::set_recovery(Recovery mode, FirstFollowSetGenerator &sets_generator)
+{
+    std::vector<DenseBitset> follow_sets;
+    const auto &sets = sets_generator.get_engine();
+    const auto &sets_symbols = sets.get_symbol_table();
+    // the table may have been built with its own symbol table, so translate by symbol
+    for (auto nonterminal : symbols().get_nonterminals()) {
+        auto &sync_set = follow_sets.emplace_back(symbols().num_terminals());
+        const auto id = sets_symbols.find(symbols().get_symbol(nonterminal));
+        if (id == SymbolTable::invalid_id || !sets_symbols.is_nonterminal(id))
+            continue;
+        sets.follow(id).for_each([&](std::size_t column) {
+            const auto follower = sets_symbols.terminal_at(static_cast<std::uint32_t>(column));
+            const auto terminal = symbols().find(sets_symbols.get_symbol(follower));
+            if (terminal != SymbolTable::invalid_id && symbols().is_terminal(terminal))
+                sync_set.set(symbols().terminal_index(terminal));
+        });
+    }
+    set_recovery(mode, std::move(follow_sets));
+}
+
+std::string LLParser::describe(const ParseError &error) const
+{
+    auto name = [this](SymbolId id) {
+        return id < symbols().size() ? fmt::format("'{}'", symbols().get_symbol(id))
+                                     : std::string("unknown token");
+    };
+    if (error.type == ErrorType::TRAILINGINPUT)
+        return fmt::format("{}: unexpected {}, expected end of input", error.position,
+                           name(error.token));
+    return fmt::format("{}: unexpected {}, expected {}", error.position, name(error.token),
+                       name(error.expected));
+}
+
+void LLParser::report_error(ErrorType type, SymbolId current, SymbolId top)
+{
+    context.error = type;
+    if (!context.recovering)
+        context.errors.push_back({type, context.tokens_consumed, current, top});
+}
+
+void LLParser::recover(SymbolId current)
+{
+    context.error = ParseContext::ErrorType::NOERROR;
+    context.recovering = true;
+    // deletes the token, feed() moves on to the next one
+    auto skip = [this] {
+        context.tokens_consumed++;
+        context.inserted = false;
+    };
+    const auto top = context.parse_stack.back();
+    if (current == SymbolTable::eoi_id) {
+        // the end of input can't be skipped, give up on everything that is still expected
+        pop_symbol();
+        return;
+    }
+    if (top == SymbolTable::eoi_id) {
+        skip();
+        return;
+    }
+    if (symbols().is_nonterminal(top)) {
+        const auto column = current < symbols().size() ? symbols().terminal_index(current)
+                                                       : SymbolTable::no_index;
+        const auto &sync_set = (*sync_sets)[symbols().nonterminal_index(top)];
+        if (column != SymbolTable::no_index && sync_set.test(column))
+            pop_symbol();
+        else
+            skip();
+        return;
+    }
+    // at most one terminal is inserted before a token, default rows could otherwise expand the
+    // same productions forever
+    if (context.inserted) {
+        skip();
+        return;
+    }
+    const auto node = context.tree ? context.node_stack.back() : SyntaxTree::no_node;
+    pop_symbol();
+    context.inserted = true;
+    if (recovery == Recovery::PhraseLevel && !accepts(context.parse_stack.back(), current)) {
+        // inserting top wouldn't help, so delete the token instead
+        context.parse_stack.push_back(top);
+        if (context.tree)
+            context.node_stack.push_back(node);
+        skip();
+    }
+}
+
+bool LLParser::accepts(SymbolId top, SymbolId current) const
+{
+    // a completed production says nothing about the token, give it the benefit of the doubt
+    if ((top & completion_marker) || top == current)
+        return true;
+    return symbols().is_nonterminal(top) &&
+           parse_table->lookup(top, current) != LLTable::no_production;
+}
+
+void LLParser::pop_symbol()
+{
+    context.parse_stack.pop_back();
+    if (context.tree)
+        context.node_stack.pop_back();
+}
+
+LLParser::Step LLParser::handle_current_symbol(SymbolId current, SymbolId top)
+{
+    if (top & completion_marker) {
+        const auto production = top & ~completion_marker;
+        JACC_TRACE("completed production {}", production);
+        JACC_TRACE_EVENT(trace_sink, TraceEvent::Kind::Reduce, current, production,
+                         context.tokens_consumed);
+        context.parse_stack.pop_back();
+        if (context.tree) {
+            const auto node = context.node_stack.back();
+            context.node_stack.pop_back();
+            // length held the start of the node until now
+            if (node != SyntaxTree::no_node)
+                (*context.tree)[node].length = static_cast<std::uint32_t>(
+                    context.tokens_consumed - (*context.tree)[node].length);
+        }
+        return {Step::Kind::Completed, production};
+    }
     if (top == current) {
-        spdlog::debug("top of stack ('{}') matched input ('{}'). Popping '{}'", top, current,
-                      context.parse_stack.top());
-        context.parse_stack.pop();
-        context.inputIndex++;
-        if (top == eoi_symbol && context.parse_stack.empty()) {
-            context.done = true;
+        JACC_TRACE("top of stack ('{}') matched input ('{}'). Popping", symbols().get_symbol(top),
+                   symbols().get_symbol(current));
+        JACC_TRACE_EVENT(trace_sink, TraceEvent::Kind::Match, current, top,
+                         context.tokens_consumed);
+        context.parse_stack.pop_back();
+        if (context.tree) {
+            const auto node = context.node_stack.back();
+            context.node_stack.pop_back();
+            if (node != SyntaxTree::no_node) {
+                (*context.tree)[node].value = static_cast<std::uint32_t>(context.tokens_consumed);
+                (*context.tree)[node].length = 1;
+            }
         }
-        else{
-            spdlog::debug("wot {}", current.get_raw_symbol().value_or("epsilon"));
+        context.tokens_consumed++;
+        context.recovering = false;
+        context.inserted = false;
+        if (top == SymbolTable::eoi_id && context.parse_stack.empty()) {
+            context.done = true;
         }
-    } else if (top.is_nonTerminal()) {
-        // spdlog::debug("parse_table[{}]:{}", top, parse_table[top]);
-        spdlog::debug("parse_table[{}][{}]:{}", top, current, parse_table[top][current]);
-        if (parse_table[top][current].get_num_symbols() == 0) {
-            spdlog::debug("no matching production");
-            context.error = ParseContext::ErrorType::NOMATCHINGPRODUCTION;
-            return;
+        return {Step::Kind::Matched};
+    }
+    if (symbols().is_nonterminal(top)) {
+        const auto production = parse_table->lookup(top, current);
+        if (production == LLTable::no_production) {
+            JACC_TRACE("no matching production");
+            JACC_TRACE_EVENT(trace_sink, TraceEvent::Kind::Error, current, top,
+                             context.tokens_consumed);
+            report_error(ParseContext::ErrorType::NOMATCHINGPRODUCTION, current, top);
+            return {Step::Kind::Failed};
         }
-        context.parse_stack.pop();
-        auto production = parse_table[top][current];
+        JACC_TRACE_EVENT(trace_sink, TraceEvent::Kind::Expand, current, production,
+                         context.tokens_consumed);
+        context.parse_stack.pop_back();
         push_production_to_stack(production);
-    } else {
-        spdlog::debug("terminal mismatch");
-        context.error = ParseContext::ErrorType::TERMINALMISMATCH;
+        return {Step::Kind::Expanded, production};
     }
+    JACC_TRACE("terminal mismatch");
+    JACC_TRACE_EVENT(trace_sink, TraceEvent::Kind::Error, current, top, context.tokens_consumed);
+    report_error(top == SymbolTable::eoi_id ? ParseContext::ErrorType::TRAILINGINPUT
+                                            : ParseContext::ErrorType::TERMINALMISMATCH,
+                 current, top);
+    return {Step::Kind::Failed};
 }
 
-void LLParser::push_production_to_stack(const Production &production)
+void LLParser::push_production_to_stack(LLTable::ProductionIndex production)
 {
-    spdlog::debug("what {}->{}", production.synthesized_LHS.value().get_raw_symbol().value_or("epsilon"), production);
-    if (production.is_epsilon()) {
-        spdlog::debug("pushing epsilon production to stack");
-        return;
+    const auto RHS = parse_table->get_RHS(production);
+    std::optional<SyntaxTree::NodeId> first_child;
+    // the node the completion marker finishes, and the link the tail of a list goes into
+    auto node = SyntaxTree::no_node;
+    auto tail = SyntaxTree::no_node;
+    if (context.tree) {
+        auto &tree = *context.tree;
+        node = context.node_stack.back();
+        context.node_stack.pop_back();
+        const bool list = is_tail_recursive(production);
+        // the node that gets the children
+        auto expanded = node;
+        if (tree.is_link(node)) {
+            // a link only ends where the next one starts, while the completion markers of the
+            // whole chain come at the end of the list
+            if (const auto previous = tree[node].value; previous != SyntaxTree::no_node)
+                tree[previous].length =
+                    static_cast<std::uint32_t>(context.tokens_consumed - tree[previous].length);
+            if (list)
+                node = SyntaxTree::no_node;
+        } else if (list) {
+            tree[node].value = production;
+            tree[node].length = static_cast<std::uint32_t>(context.tokens_consumed);
+            expanded = tree.add_link(node, SyntaxTree::no_node);
+        }
+        tree[expanded].value = production;
+        tree[expanded].length = static_cast<std::uint32_t>(context.tokens_consumed);
+        first_child = tree.add_children(expanded, list ? RHS.first(RHS.size() - 1) : RHS);
+        if (list) {
+            // the link before the tail is kept in its value until the tail is expanded
+            tail = tree.add_link(tree[expanded].parent, expanded);
+            tree[tail].value = expanded;
+        }
     }
-    spdlog::debug("pushing {}->{} to stack in reversed order", production.synthesized_LHS.value(), production);
-    for (auto it = production.get_production_symbols().rbegin();
-         it != production.get_production_symbols().rend(); ++it) {
-        context.parse_stack.push(*it);
+    if (context.mark_completions) {
+        context.parse_stack.push_back(completion_marker | production);
+        if (context.tree)
+            context.node_stack.push_back(node);
     }
+    if (tail != SyntaxTree::no_node)
+        context.node_stack.push_back(tail);
+    if (first_child) {
+        // children are allocated together, so the child for RHS[i] is first + i
+        const auto children = tail != SyntaxTree::no_node ? RHS.size() - 1 : RHS.size();
+        for (auto i = children; i > 0; i--)
+            context.node_stack.push_back(*first_child + static_cast<SyntaxTree::NodeId>(i - 1));
+    }
+    if (RHS.empty()) {
+        JACC_TRACE("pushing epsilon production to stack");
+        return;
+    }
+    JACC_TRACE("pushing {}->{} to stack in reversed order",
+               symbols().get_symbol(parse_table->get_LHS(production)), to_symbols(RHS, symbols()));
+    context.parse_stack.insert(context.parse_stack.end(), RHS.rbegin(), RHS.rend());
+}
+
+bool LLParser::is_tail_recursive(LLTable::ProductionIndex production) const
+{
+    const auto RHS = parse_table->get_RHS(production);
+    return RHS.size() > 1 && RHS.back() == parse_table->get_LHS(production);
 }
@@ -0,0 +1,85 @@
+#include <jacc/table_driven_lr_parser.h>
+#include <jacc/grammar.h>
+#include <jacc/trace.h>
+
+namespace
+{
+[[maybe_unused]] TraceEvent::Kind trace_kind(LRTable::ActionKind kind)
+{
+    switch (kind) {
+    case LRTable::ActionKind::Shift:
+        return TraceEvent::Kind::Shift;
+    case LRTable::ActionKind::Reduce:
+        return TraceEvent::Kind::Reduce;
+    case LRTable::ActionKind::Accept:
+        return TraceEvent::Kind::Accept;
+    case LRTable::ActionKind::Error:
+        break;
+    }
+    return TraceEvent::Kind::Error;
+}
+} // namespace
+
+bool LRParser::parse(const std::vector<ProductionSymbol> &input)
+{
+    JACC_DEBUG("parse_table: {} states, {} productions", parse_table.num_states(),
+               parse_table.num_productions());
+    return parse(input.begin(), input.end());
+}
+
+bool LRParser::feed(SymbolId token)
+{
+    if (context.error != ParseContext::ErrorType::NOERROR)
+        return false;
+    if (context.done) {
+        context.error = ParseContext::ErrorType::TRAILINGINPUT;
+        return false;
+    }
+
+    // tokens that never appear in the grammar get invalid_id and have no action, reductions
+    // don't consume the token so keep going until it's shifted or accepted
+    const auto consumed = context.tokens_consumed;
+    while (context.tokens_consumed == consumed && !context.done &&
+           context.error == ParseContext::ErrorType::NOERROR) {
+        JACC_TRACE("state: {}, current: {}", context.state_stack.back(), token);
+        handle_current_symbol(token);
+    }
+    return context.error == ParseContext::ErrorType::NOERROR;
+}
+
+bool LRParser::finish()
+{
+    if (!context.done)
+        feed(SymbolTable::eoi_id);
+    JACC_DEBUG("context has error: {}", context.parse_error_to_string(context.error));
+    return context.done && context.error == ParseContext::ErrorType::NOERROR;
+}
+
+void LRParser::handle_current_symbol(SymbolId current)
+{
+    const auto action = parse_table.get_action(context.state_stack.back(), current);
+    JACC_TRACE_EVENT(trace_sink, trace_kind(action.kind), current, action.value,
+                     context.tokens_consumed);
+    switch (action.kind) {
+    case LRTable::ActionKind::Shift:
+        JACC_TRACE("shifting, going to state {}", action.value);
+        context.state_stack.push_back(action.value);
+        context.tokens_consumed++;
+        break;
+    case LRTable::ActionKind::Reduce: {
+        const auto LHS = parse_table.get_LHS(action.value);
+        JACC_TRACE("reducing by {} -> {}", symbols().get_symbol(LHS), action.value);
+        context.state_stack.resize(context.state_stack.size() -
+                                   parse_table.get_RHS(action.value).size());
+        context.state_stack.push_back(parse_table.get_goto(context.state_stack.back(), LHS));
+        break;
+    }
+    case LRTable::ActionKind::Accept:
+        context.done = true;
+        break;
+    case LRTable::ActionKind::Error:
+        JACC_TRACE("no action");
+        context.error = ParseContext::ErrorType::NOACTION;
+        break;
+    }
+}
@@ -221,3 +221,84 @@ TEST(FollowSetGeneration, CanHandleEOIBaseCase)
 
     EXPECT_EQ(follow_set_actual, follow_set_correct);
 }
+
+TEST(FirstFollowEngines, BitsetEngineAgreesWithRecursiveEngineOnExampleGrammars)
+{
+    for (const auto *file : {"exp.bnf", "first.bnf", "test.bnf", "easy.bnf"}) {
+        Driver driver;
+        driver.parse(std::string{EXAMPLE_GRAMMAR_DIR}.append(file));
+
+        auto recursive =
+            FirstFollowSetGenerator(driver.grammar, FirstFollowSetGenerator::Engine::Recursive);
+        auto bitset =
+            FirstFollowSetGenerator(driver.grammar, FirstFollowSetGenerator::Engine::Bitset);
+
+        EXPECT_EQ(bitset.generate_first_sets(), recursive.generate_first_sets()) << file;
+        EXPECT_EQ(bitset.generate_follow_sets(), recursive.generate_follow_sets()) << file;
+        for (const auto &rule : driver.grammar.get_rules())
+            for (const auto &production : rule.get_productions())
+                EXPECT_EQ(bitset.first(production), recursive.first(production))
+                    << fmt::format("{}: {}", file, production);
+    }
+}
+
+TEST(FirstFollowEngines, BitsetEngineHandlesLeftRecursion)
+{
+    // E : E + id | id;
+    auto e = ProductionSymbol{"E", ProductionSymbol::Kind::NonTerminal};
+    auto plus = ProductionSymbol{"+", ProductionSymbol::Kind::Terminal};
+    auto id = ProductionSymbol{"id", ProductionSymbol::Kind::Terminal};
+    auto grammar = Grammar{GrammarRule{e, {Production{{e, plus, id}}, Production{id}}}};
+
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    EXPECT_EQ(set_generator.generate_first_sets()[e], std::set<ProductionSymbol>{id});
+    EXPECT_EQ(set_generator.generate_follow_sets()[e],
+              (std::set<ProductionSymbol>{plus, ProductionSymbol::create_EOI()}));
+}
+
+TEST(FirstFollowEngines, BitsetEngineTracksIndirectlyNullableSymbols)
+{
+    // S : A B x; A : B; B : _epsilon_ | b;
+    auto s = ProductionSymbol{"S", ProductionSymbol::Kind::NonTerminal};
+    auto a = ProductionSymbol{"A", ProductionSymbol::Kind::NonTerminal};
+    auto b = ProductionSymbol{"B", ProductionSymbol::Kind::NonTerminal};
+    auto x = ProductionSymbol{"x", ProductionSymbol::Kind::Terminal};
+    auto b_terminal = ProductionSymbol{"b", ProductionSymbol::Kind::Terminal};
+    auto epsilon = ProductionSymbol::create_epsilon();
+    auto grammar = Grammar{{GrammarRule{s, Production{{a, b, x}}}, GrammarRule{a, Production{b}},
+                            GrammarRule{b, {Production{epsilon}, Production{b_terminal}}}}};
+
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    const auto &engine = set_generator.get_engine();
+    const auto &symbols = engine.get_symbol_table();
+    EXPECT_TRUE(engine.is_nullable(symbols.find(a)));
+    EXPECT_FALSE(engine.is_nullable(symbols.find(s)));
+    EXPECT_TRUE(engine.first(symbols.find(s)).test(symbols.terminal_index(symbols.find(x))));
+    EXPECT_TRUE(engine.follow(symbols.find(a)).test(symbols.terminal_index(symbols.find(x))));
+}
+
+TEST(FirstFollowEngines, ReplacingARuleRederivesSetsOnACycle)
+{
+    // S : A y; A : x | B; B : A; then A : B leaves nothing to start A and B with
+    auto s = ProductionSymbol{"S", ProductionSymbol::Kind::NonTerminal};
+    auto a = ProductionSymbol{"A", ProductionSymbol::Kind::NonTerminal};
+    auto b = ProductionSymbol{"B", ProductionSymbol::Kind::NonTerminal};
+    auto x = ProductionSymbol{"x", ProductionSymbol::Kind::Terminal};
+    auto y = ProductionSymbol{"y", ProductionSymbol::Kind::Terminal};
+    auto grammar = Grammar{{GrammarRule{s, Production{{a, y}}},
+                            GrammarRule{a, {Production{x}, Production{b}}},
+                            GrammarRule{b, Production{a}}}};
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    ASSERT_EQ(set_generator.first(b), std::set<ProductionSymbol>{x});
+
+    const auto changes = set_generator.replace_rule(GrammarRule{a, Production{b}});
+    EXPECT_TRUE(set_generator.first(a).empty());
+    EXPECT_TRUE(set_generator.first(b).empty());
+    EXPECT_TRUE(set_generator.first(s).empty());
+    // FOLLOW didn't change and S, whose only production starts with A, has to be patched
+    const auto &symbols = set_generator.get_engine().get_symbol_table();
+    EXPECT_TRUE(changes.follow.empty());
+    EXPECT_EQ(changes.first.size(), 3);
+    EXPECT_EQ(changes.rows,
+              (std::vector<SymbolId>{symbols.find(s), symbols.find(a), symbols.find(b)}));
+}
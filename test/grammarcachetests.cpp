@@ -0,0 +1,185 @@
+#include <jacc/driver.h>
+#include <jacc/first_follow_set_generator.h>
+#include <jacc/grammar_cache.h>
+#include <jacc/lexer_generator.h>
+#include <jacc/ll_table_generator.h>
+#include <jacc/table_driven_ll_parser.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <memory>
+
+namespace
+{
+struct CompiledFile {
+    std::filesystem::path path;
+    std::uint64_t hash;
+    Grammar grammar;
+    LLTable table;
+
+    explicit CompiledFile(const std::string &name)
+        : path(std::filesystem::temp_directory_path() / (name + ".jaccc"))
+    {
+        const auto grammar_file = std::string{EXAMPLE_GRAMMAR_DIR}.append(name);
+        hash = hash_grammar_file(grammar_file).value();
+        Driver driver;
+        driver.parse(grammar_file);
+        grammar = driver.grammar;
+        FirstFollowSetGenerator sets_generator(grammar);
+        table = generate_dense_ll_table(sets_generator);
+        std::ofstream(path, std::ios::binary)
+            << serialize_compiled_grammar(hash, grammar, sets_generator.get_engine(), table);
+    }
+    ~CompiledFile() { std::filesystem::remove(path); }
+};
+} // namespace
+
+TEST(GrammarCache, RoundTripsTheAnalysis)
+{
+    CompiledFile file("calc.bnf");
+    auto compiled = CompiledGrammar::open(file.path.string(), file.hash);
+    ASSERT_TRUE(compiled.has_value());
+
+    const auto &symbols = file.table.get_symbol_table();
+    ASSERT_EQ(compiled->num_symbols(), symbols.size());
+    for (SymbolId id = SymbolTable::eoi_id; id < symbols.size(); id++)
+        EXPECT_EQ(compiled->symbol_name(id), *symbols.get_symbol(id).get_raw_symbol());
+
+    FirstFollowEngine engine(file.grammar);
+    const auto follow_sets = compiled->to_follow_sets();
+    ASSERT_EQ(follow_sets.size(), symbols.num_nonterminals());
+    for (auto nonterminal : symbols.get_nonterminals()) {
+        EXPECT_EQ(compiled->is_nullable(nonterminal), engine.is_nullable(nonterminal));
+        const auto &first = engine.first(nonterminal).get_words();
+        const auto &follow = engine.follow(nonterminal).get_words();
+        EXPECT_TRUE(std::ranges::equal(compiled->first(nonterminal), first));
+        EXPECT_TRUE(std::ranges::equal(compiled->follow(nonterminal), follow));
+        EXPECT_EQ(follow_sets[symbols.nonterminal_index(nonterminal)].get_words(), follow);
+    }
+
+    const auto table = compiled->ll_table();
+    EXPECT_TRUE(std::ranges::equal(table->get_cells(), file.table.get_cells()));
+    EXPECT_EQ(table->get_start_symbol(), file.table.get_start_symbol());
+    ASSERT_EQ(table->num_productions(), file.table.num_productions());
+    for (LLTable::ProductionIndex p = 0; p < table->num_productions(); p++)
+        EXPECT_EQ(table->to_production(p), file.table.to_production(p));
+    const auto &mapped_symbols = table->get_symbol_table();
+    for (SymbolId id = 0; id < symbols.size(); id++) {
+        EXPECT_EQ(mapped_symbols.terminal_index(id), symbols.terminal_index(id));
+        EXPECT_EQ(mapped_symbols.nonterminal_index(id), symbols.nonterminal_index(id));
+        EXPECT_EQ(mapped_symbols.name(id), symbols.name(id));
+        EXPECT_EQ(table->lookup(id, SymbolTable::eoi_id),
+                  file.table.lookup(id, SymbolTable::eoi_id));
+    }
+    for (auto terminal : symbols.get_terminals()) {
+        const auto name = symbols.name(terminal);
+        EXPECT_EQ(table->find_terminal(name), file.table.find_terminal(name));
+    }
+    EXPECT_EQ(compiled->to_token_definitions(), file.grammar.get_token_definitions());
+
+    LLParser parser{table};
+    auto id = [&](const char *name) {
+        return parser.get_table().get_symbol_table().find(name, ProductionSymbol::Kind::Terminal);
+    };
+    for (auto token : {id("num"), id("*"), id("("), id("id"), id("+"), id("num"), id(")")})
+        parser.feed(token);
+    EXPECT_TRUE(parser.finish());
+}
+
+TEST(GrammarCache, TablesAreViewsIntoTheMapping)
+{
+    CompiledFile file("calc.bnf");
+    std::shared_ptr<const LLTable> table;
+    std::shared_ptr<const LexerTable> lexer;
+    {
+        auto compiled = CompiledGrammar::open(file.path.string(), file.hash);
+        ASSERT_TRUE(compiled.has_value());
+        table = compiled->ll_table();
+        lexer = compiled->lexer_table();
+        EXPECT_EQ(table->get_cells().data(), compiled->get_cells().data());
+        EXPECT_EQ(table->get_RHS(0).data(), compiled->get_RHS(0).data());
+    }
+    // the tables keep the mapping alive once the CompiledGrammar is gone
+    const auto expected = generate_lexer(file.grammar.get_token_definitions(),
+                                         file.table.get_symbol_table());
+    EXPECT_TRUE(std::ranges::equal(lexer->get_transitions(), expected.get_transitions()));
+    EXPECT_TRUE(std::ranges::equal(lexer->token_symbols, expected.token_symbols));
+
+    const std::string input = "(id + 4.2) * x1 # comment\n";
+    Scanner scanner(*lexer, input), expected_scanner(expected, input);
+    LLParser parser{table};
+    Token token, expected_token;
+    while (scanner.next(token)) {
+        ASSERT_TRUE(expected_scanner.next(expected_token));
+        EXPECT_EQ(token.symbol, expected_token.symbol);
+        EXPECT_EQ(token.offset, expected_token.offset);
+        parser.feed(token.symbol);
+    }
+    EXPECT_FALSE(expected_scanner.next(expected_token));
+    EXPECT_FALSE(scanner.failed());
+    EXPECT_TRUE(parser.finish());
+
+    // changing a copy copies what changes, not the mapping
+    auto copy = *table;
+    copy.compress(LLTable::Encoding::RowDisplacement);
+    EXPECT_TRUE(table->get_encoding() == LLTable::Encoding::Dense);
+    EXPECT_EQ(copy.lookup(file.table.get_start_symbol(), SymbolTable::eoi_id),
+              table->lookup(file.table.get_start_symbol(), SymbolTable::eoi_id));
+}
+
+TEST(GrammarCache, IgnoresStaleAndDamagedFiles)
+{
+    CompiledFile file("exp.bnf");
+    EXPECT_FALSE(CompiledGrammar::open(file.path.string(), file.hash + 1).has_value());
+    EXPECT_FALSE(CompiledGrammar::open(file.path.string() + ".missing", file.hash).has_value());
+
+    std::filesystem::resize_file(file.path, std::filesystem::file_size(file.path) / 2);
+    EXPECT_FALSE(CompiledGrammar::open(file.path.string(), file.hash).has_value());
+    EXPECT_NE(hash_grammar("E : T;"), hash_grammar("E : F;"));
+}
+
+TEST(GrammarCache, IgnoresFilesWithIdsOutOfRange)
+{
+    CompiledFile file("calc.bnf");
+    std::string image;
+    {
+        std::ifstream in(file.path, std::ios::binary);
+        image.assign(std::istreambuf_iterator<char>(in), {});
+    }
+    // finds the cells and right hand sides by their contents, not by the layout
+    auto damage = [&](const auto &elements, std::size_t index, std::uint32_t value) {
+        const std::string_view bytes{reinterpret_cast<const char *>(elements.data()),
+                                     elements.size() * sizeof(elements[0])};
+        const auto offset = image.find(bytes);
+        ASSERT_NE(offset, std::string::npos);
+        auto damaged = image;
+        std::memcpy(damaged.data() + offset + index * sizeof(value), &value, sizeof(value));
+        std::ofstream(file.path, std::ios::binary) << damaged;
+        EXPECT_FALSE(CompiledGrammar::open(file.path.string(), file.hash).has_value());
+    };
+
+    const auto &cells = file.table.get_cells();
+    const auto filled = std::find_if(cells.begin(), cells.end(), [](auto production) {
+        return production != LLTable::no_production;
+    });
+    damage(cells, static_cast<std::size_t>(filled - cells.begin()),
+           static_cast<std::uint32_t>(file.table.num_productions()));
+
+    std::vector<SymbolId> RHS_symbols;
+    for (LLTable::ProductionIndex p = 0; p < file.table.num_productions(); p++) {
+        const auto RHS = file.table.get_RHS(p);
+        RHS_symbols.insert(RHS_symbols.end(), RHS.begin(), RHS.end());
+    }
+    damage(RHS_symbols, 0, static_cast<std::uint32_t>(file.table.get_symbol_table().size()));
+
+    const auto lexer =
+        generate_lexer(file.grammar.get_token_definitions(), file.table.get_symbol_table());
+    damage(lexer.get_transitions(), 0, static_cast<std::uint32_t>(lexer.num_states()));
+    damage(lexer.get_accepting(), 1,
+           static_cast<std::uint32_t>(file.grammar.get_token_definitions().size()));
+
+    std::ofstream(file.path, std::ios::binary) << image;
+    EXPECT_TRUE(CompiledGrammar::open(file.path.string(), file.hash).has_value());
+}
@@ -1,6 +1,8 @@
 #include <jacc/grammar.h>
 #include <fmt/core.h>
 #include <gtest/gtest.h>
+#include <thread>
+#include <vector>
 
 TEST(Grammars, ProductionSymbolsBasicPropertiesAreAllright)
 {
@@ -79,3 +81,142 @@ TEST(Grammars, RulesCanFindEpsilonDerivations)
     EXPECT_FALSE(terminal_rule_without_epsilon.rule_contains_epsilon_production());
     EXPECT_TRUE(terminal_rule_with_epsilon.rule_contains_epsilon_production());
 }
+
+TEST(Grammars, SymbolTableInternsEachSymbolOnce)
+{
+    auto symbols = SymbolTable{};
+    auto f = symbols.intern(ProductionSymbol{"f", ProductionSymbol::Kind::Terminal});
+    auto F = symbols.intern(ProductionSymbol{"F", ProductionSymbol::Kind::NonTerminal});
+
+    EXPECT_EQ(f, symbols.intern("f", ProductionSymbol::Kind::Terminal));
+    EXPECT_EQ(F, symbols.find(ProductionSymbol{"F", ProductionSymbol::Kind::NonTerminal}));
+    EXPECT_NE(f, F);
+    EXPECT_EQ(symbols.find(ProductionSymbol{"g", ProductionSymbol::Kind::Terminal}),
+              SymbolTable::invalid_id);
+    EXPECT_EQ(symbols.intern(ProductionSymbol::create_epsilon()), SymbolTable::epsilon_id);
+    EXPECT_EQ(symbols.intern(ProductionSymbol::create_EOI()), SymbolTable::eoi_id);
+    EXPECT_EQ(symbols.get_symbol(f), (ProductionSymbol{"f", ProductionSymbol::Kind::Terminal}));
+}
+
+TEST(Grammars, SymbolTableKeepsItsOwnCopyOfViewedNames)
+{
+    auto symbols = SymbolTable{};
+    std::string text = "F f";
+    auto F = symbols.intern(std::string_view{text}.substr(0, 1),
+                            ProductionSymbol::Kind::NonTerminal);
+    auto f = symbols.intern(std::string_view{text}.substr(2, 1), ProductionSymbol::Kind::Terminal);
+    text = "x x";
+
+    EXPECT_EQ(symbols.find("F", ProductionSymbol::Kind::NonTerminal), F);
+    EXPECT_EQ(symbols.find("f", ProductionSymbol::Kind::Terminal), f);
+    EXPECT_EQ(symbols.find("f", ProductionSymbol::Kind::NonTerminal), SymbolTable::invalid_id);
+    EXPECT_EQ(symbols.get_symbol(F).get_raw_symbol(), "F");
+}
+
+TEST(Grammars, SymbolTableHandsOutDenseIndicesPerKind)
+{
+    auto s = ProductionSymbol{"S", ProductionSymbol::Kind::NonTerminal};
+    auto a = ProductionSymbol{"A", ProductionSymbol::Kind::NonTerminal};
+    auto x = ProductionSymbol{"x", ProductionSymbol::Kind::Terminal};
+    auto grammar = Grammar{{GrammarRule{s, Production{{a, x}}}, GrammarRule{a, Production{x}}}};
+    const auto &symbols = grammar.get_symbol_table();
+
+    // $ is always terminal 0, and the start symbol is always nonterminal 0
+    EXPECT_EQ(symbols.num_terminals(), 2);
+    EXPECT_EQ(symbols.num_nonterminals(), 2);
+    EXPECT_EQ(symbols.terminal_index(SymbolTable::eoi_id), 0);
+    EXPECT_EQ(symbols.nonterminal_at(0), symbols.find(s));
+    EXPECT_EQ(symbols.terminal_index(symbols.find(x)), 1);
+    EXPECT_EQ(symbols.nonterminal_index(symbols.find(x)), SymbolTable::no_index);
+    EXPECT_FALSE(symbols.is_terminal(SymbolTable::epsilon_id));
+}
+
+TEST(Grammars, IndexesRulesAndOccurrences)
+{
+    auto s = ProductionSymbol{"S", ProductionSymbol::Kind::NonTerminal};
+    auto a = ProductionSymbol{"A", ProductionSymbol::Kind::NonTerminal};
+    auto x = ProductionSymbol{"x", ProductionSymbol::Kind::Terminal};
+    auto y = ProductionSymbol{"y", ProductionSymbol::Kind::Terminal};
+    auto grammar = Grammar{{GrammarRule{s, {Production{{a, x, a}}, Production{y}}},
+                            GrammarRule{a, Production{{x, y}}}}};
+
+    ASSERT_NE(grammar.find_rule(a), nullptr);
+    EXPECT_EQ(grammar.find_rule(a), &grammar.get_rules()[1]);
+    EXPECT_EQ(grammar.find_rule(x), nullptr);
+    EXPECT_EQ(grammar.find_rule(ProductionSymbol{"B", ProductionSymbol::Kind::NonTerminal}),
+              nullptr);
+
+    const auto occurrences = grammar.get_occurrences(a);
+    ASSERT_EQ(occurrences.size(), 2);
+    EXPECT_EQ(occurrences[0].rule, 0);
+    EXPECT_EQ(occurrences[0].position, 0);
+    EXPECT_EQ(occurrences[1].position, 2);
+    EXPECT_EQ(grammar.get_occurrences(y).size(), 2);
+    EXPECT_TRUE(grammar.get_occurrences(s).empty());
+    // the production with A twice is only returned once
+    EXPECT_EQ(grammar.get_rules_containing_symbol(a)->size(), 1);
+
+    // copies share the index, which points into their own rules
+    auto copy = grammar;
+    EXPECT_EQ(copy.find_rule(a), &copy.get_rules()[1]);
+}
+
+TEST(Grammars, BuildsTheIndexOnceForConcurrentReaders)
+{
+    auto s = ProductionSymbol{"S", ProductionSymbol::Kind::NonTerminal};
+    auto a = ProductionSymbol{"A", ProductionSymbol::Kind::NonTerminal};
+    auto x = ProductionSymbol{"x", ProductionSymbol::Kind::Terminal};
+    const auto grammar = Grammar{{GrammarRule{s, {Production{{a, x}}, Production{x}}},
+                                  GrammarRule{a, Production{ProductionSymbol::create_epsilon()}}}};
+
+    // every thread asks for the index before anyone has built it
+    std::vector<const GrammarRule *> rules(8);
+    std::vector<std::size_t> occurrences(rules.size());
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < rules.size(); t++) {
+        threads.emplace_back([&, t] {
+            rules[t] = grammar.find_rule(a);
+            occurrences[t] = grammar.get_occurrences(x).size();
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    for (std::size_t t = 0; t < rules.size(); t++) {
+        EXPECT_EQ(rules[t], &grammar.get_rules()[1]);
+        EXPECT_EQ(occurrences[t], 2);
+    }
+    EXPECT_TRUE(grammar.is_nullable(a));
+
+    // a changed copy gets an index of its own
+    auto changed = grammar;
+    changed.remove_rule(a);
+    EXPECT_EQ(changed.find_rule(a), nullptr);
+    EXPECT_EQ(grammar.find_rule(a), &grammar.get_rules()[1]);
+}
+
+TEST(Grammars, ComputesNullableOnceForLeftRecursiveRules)
+{
+    // S : S s | A B; A : A a | _epsilon_; B : A | b; C : C c;
+    auto nonterminal = [](const char *name) {
+        return ProductionSymbol{name, ProductionSymbol::Kind::NonTerminal};
+    };
+    auto terminal = [](const char *name) {
+        return ProductionSymbol{name, ProductionSymbol::Kind::Terminal};
+    };
+    auto s = nonterminal("S"), a = nonterminal("A"), b = nonterminal("B"), c = nonterminal("C");
+    auto grammar = Grammar{{
+        GrammarRule{s, {Production{{s, terminal("s")}}, Production{{a, b}}}},
+        GrammarRule{a, {Production{{a, terminal("a")}},
+                        Production{ProductionSymbol::create_epsilon()}}},
+        GrammarRule{b, {Production{a}, Production{terminal("b")}}},
+        GrammarRule{c, Production{{c, terminal("c")}}},
+    }};
+
+    EXPECT_TRUE(grammar.is_nullable(s));
+    EXPECT_TRUE(grammar.is_nullable(a));
+    EXPECT_TRUE(grammar.is_nullable(b));
+    EXPECT_FALSE(grammar.is_nullable(c));
+    EXPECT_FALSE(grammar.is_nullable(terminal("a")));
+    EXPECT_TRUE(grammar.is_nullable(ProductionSymbol::create_epsilon()));
+    EXPECT_EQ(grammar.get_nullable().count(), 3);
+}
@@ -0,0 +1,146 @@
+#include <jacc/driver.h>
+#include <jacc/first_follow_set_generator.h>
+#include <jacc/grammar_transform.h>
+#include <jacc/ll_table_generator.h>
+#include <jacc/table_driven_ll_parser.h>
+#include <fmt/core.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+ProductionSymbol terminal(const std::string &name)
+{
+    return ProductionSymbol{name, ProductionSymbol::Kind::Terminal};
+}
+
+ProductionSymbol nonterminal(const std::string &name)
+{
+    return ProductionSymbol{name, ProductionSymbol::Kind::NonTerminal};
+}
+
+std::vector<ProductionSymbol> terminals(std::initializer_list<const char *> names)
+{
+    std::vector<ProductionSymbol> result;
+    for (const auto *name : names)
+        result.push_back(terminal(name));
+    return result;
+}
+
+bool parses(const Grammar &grammar, const std::vector<ProductionSymbol> &input)
+{
+    FirstFollowSetGenerator sets_generator(grammar);
+    LLParser parser{generate_dense_ll_table(sets_generator)};
+    return parser.parse(input);
+}
+} // namespace
+
+TEST(GrammarTransforms, EliminatesDirectLeftRecursion)
+{
+    // E : E + T | T; T : T * id | id;
+    auto e = nonterminal("E"), t = nonterminal("T");
+    auto grammar = Grammar{{
+        GrammarRule{e, {Production{{e, terminal("+"), t}}, Production{t}}},
+        GrammarRule{t, {Production{{t, terminal("*"), terminal("id")}},
+                        Production{terminal("id")}}},
+    }};
+
+    auto rewritten = eliminate_left_recursion(grammar);
+    EXPECT_EQ(fmt::format("{}", rewritten),
+              "E -> T E'; T -> id T'; T' -> * id T' | epsilon; E' -> + T E' | epsilon;");
+    EXPECT_TRUE(parses(rewritten, terminals({"id", "+", "id", "*", "id", "+", "id"})));
+    EXPECT_FALSE(parses(rewritten, terminals({"id", "+", "*", "id"})));
+}
+
+TEST(GrammarTransforms, EliminatesIndirectLeftRecursion)
+{
+    // A : B a | c; B : A b | d;
+    auto a = nonterminal("A"), b = nonterminal("B");
+    auto grammar = Grammar{{
+        GrammarRule{a, {Production{{b, terminal("a")}}, Production{terminal("c")}}},
+        GrammarRule{b, {Production{{a, terminal("b")}}, Production{terminal("d")}}},
+    }};
+
+    auto rewritten = eliminate_left_recursion(grammar);
+    EXPECT_EQ(fmt::format("{}", rewritten),
+              "A -> d a A' | c A'; A' -> b a A' | epsilon;");
+    EXPECT_TRUE(parses(rewritten, terminals({"d", "a", "b", "a"})));
+    EXPECT_TRUE(parses(rewritten, terminals({"c", "b", "a", "b", "a"})));
+    EXPECT_FALSE(parses(rewritten, terminals({"c", "b"})));
+}
+
+TEST(GrammarTransforms, EliminatesLeftRecursionBehindANullablePrefix)
+{
+    // A : B A x | y; B : ε | z;
+    auto a = nonterminal("A"), b = nonterminal("B");
+    auto grammar = Grammar{{
+        GrammarRule{a, {Production{{b, a, terminal("x")}}, Production{terminal("y")}}},
+        GrammarRule{b, {Production{ProductionSymbol::create_epsilon()},
+                        Production{terminal("z")}}},
+    }};
+
+    for (const auto &rewritten : {eliminate_left_recursion(grammar), rewrite_for_ll(grammar)}) {
+        EXPECT_EQ(fmt::format("{}", rewritten), "A -> z A x A' | y A'; A' -> x A' | epsilon;");
+        FirstFollowSetGenerator sets_generator(rewritten);
+        const auto table = generate_dense_ll_table(sets_generator);
+        // z^k y x^n with k <= n isn't LL(1), A' taking every x is the only conflict left
+        for (const auto &conflict : table.conflicts)
+            EXPECT_EQ(conflict.kind, LLTable::ConflictKind::FirstFollow)
+                << table.describe(conflict);
+        EXPECT_TRUE(parses(rewritten, terminals({"y", "x", "x"})));
+        EXPECT_FALSE(parses(rewritten, terminals({"z", "x", "y"})));
+    }
+}
+
+TEST(GrammarTransforms, KeepsAmbiguousBinaryOperatorsLL1)
+{
+    // E : E + E | id;
+    auto e = nonterminal("E");
+    auto grammar = Grammar{
+        GrammarRule{e, {Production{{e, terminal("+"), e}}, Production{terminal("id")}}}};
+
+    auto rewritten = eliminate_left_recursion(grammar);
+    EXPECT_EQ(fmt::format("{}", rewritten), "E -> id E'; E' -> + E | epsilon;");
+    EXPECT_TRUE(parses(rewritten, terminals({"id", "+", "id", "+", "id"})));
+}
+
+TEST(GrammarTransforms, LeftFactorsCommonPrefixes)
+{
+    // S : a b c | a b d | a e | f;
+    auto s = nonterminal("S");
+    auto grammar = Grammar{GrammarRule{s, {
+        Production{terminals({"a", "b", "c"})},
+        Production{terminals({"a", "b", "d"})},
+        Production{terminals({"a", "e"})},
+        Production{terminal("f")},
+    }}};
+    grammar.set_token_definitions({{"a", "a"}});
+
+    auto rewritten = left_factor(grammar);
+    EXPECT_EQ(fmt::format("{}", rewritten), "S -> a S' | f; S' -> b S'' | e; S'' -> c | d;");
+    EXPECT_EQ(rewritten.get_token_definitions().size(), 1);
+    EXPECT_TRUE(parses(rewritten, terminals({"a", "b", "d"})));
+    EXPECT_TRUE(parses(rewritten, terminals({"a", "e"})));
+}
+
+TEST(GrammarTransforms, RewritesEnergyGrammarWithoutLeftRecursionOrCommonPrefixes)
+{
+    Driver driver;
+    driver.parse(std::string{EXAMPLE_GRAMMAR_DIR}.append("energy.bnf"));
+    auto rewritten = rewrite_for_ll(driver.grammar);
+
+    for (const auto &rule : rewritten.get_rules()) {
+        std::set<ProductionSymbol> first_symbols;
+        for (const auto &production : rule.get_productions()) {
+            const auto &first = production.get_production_symbols().front();
+            EXPECT_NE(first, rule.get_LHS()) << fmt::format("{}", rule);
+            EXPECT_TRUE(first.is_epsilon() || first_symbols.insert(first).second)
+                << fmt::format("{}", rule);
+        }
+    }
+    // function declarations and definitions both start with ID PARAMETERLIST
+    EXPECT_TRUE(parses(rewritten, terminals({"id", "'('", "typename", "id", "')'", "returnarrow",
+                                             "typename", "eof"})));
+    EXPECT_TRUE(parses(rewritten, terminals({"id", "'('", "id", "id", "')'", "assignment", "'{'",
+                                             "id", "plus", "int", "minus", "id", "semicolon",
+                                             "'}'", "eof"})));
+}
@@ -0,0 +1,194 @@
+#include <jacc/driver.h>
+#include <jacc/first_follow_set_generator.h>
+#include <jacc/lexer_generator.h>
+#include <jacc/ll_table_generator.h>
+#include <jacc/table_driven_ll_parser.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+SymbolTable terminals(const std::vector<std::string> &names)
+{
+    SymbolTable symbols;
+    for (const auto &name : names)
+        symbols.intern(name, ProductionSymbol::Kind::Terminal);
+    return symbols;
+}
+
+std::vector<std::pair<std::string, std::string>> lex(const LexerTable &table,
+                                                     const SymbolTable &symbols,
+                                                     std::string_view input)
+{
+    std::vector<std::pair<std::string, std::string>> tokens;
+    Scanner scanner(table, input);
+    for (Token token; scanner.next(token);)
+        tokens.emplace_back(*symbols.get_symbol(token.symbol).get_raw_symbol(),
+                            std::string{input.substr(token.offset, token.length)});
+    EXPECT_FALSE(scanner.failed());
+    return tokens;
+}
+} // namespace
+
+TEST(Lexer, PrefersLongestMatchThenFirstDefinition)
+{
+    auto symbols = terminals({"if", "id", "num"});
+    auto table = generate_lexer({{"if", "if"},
+                                 {"id", "[a-z][a-z0-9]*"},
+                                 {"num", "[0-9]+"},
+                                 {TokenDefinition::skip_name, "[ \\t\\n]+"}},
+                                symbols);
+
+    using Tokens = std::vector<std::pair<std::string, std::string>>;
+    EXPECT_EQ(lex(table, symbols, "if iffy 42 i"),
+              (Tokens{{"if", "if"}, {"id", "iffy"}, {"num", "42"}, {"id", "i"}}));
+}
+
+TEST(Lexer, ReportsUnmatchedInput)
+{
+    auto symbols = terminals({"a"});
+    auto table = generate_lexer({{"a", "a+"}}, symbols);
+
+    Scanner scanner(table, "aa!a");
+    Token token;
+    EXPECT_TRUE(scanner.next(token));
+    EXPECT_EQ(token.length, 2);
+    EXPECT_FALSE(scanner.next(token));
+    EXPECT_TRUE(scanner.failed());
+    EXPECT_EQ(scanner.position(), 2);
+}
+
+TEST(Lexer, SkipsLongRunsInBulk)
+{
+    auto symbols = terminals({"id", "comment"});
+    auto table = generate_lexer({{"id", "[a-z_]+"},
+                                 {"comment", "#[^\\n]*"},
+                                 {TokenDefinition::skip_name, "[ \\n]+"}},
+                                symbols);
+
+    const auto name = std::string(100, 'x');
+    const auto comment = "#" + std::string(70, '-') + "\xc3\xa9" + std::string(40, ' ');
+    const auto spaces = std::string(45, ' ');
+    using Tokens = std::vector<std::pair<std::string, std::string>>;
+    EXPECT_EQ(lex(table, symbols, name + spaces + comment + "\n" + name),
+              (Tokens{{"id", name}, {"comment", comment}, {"id", name}}));
+    // the run stops at the end of input, in the middle of a vector
+    EXPECT_EQ(lex(table, symbols, spaces + "ab" + comment),
+              (Tokens{{"id", "ab"}, {"comment", comment}}));
+}
+
+TEST(Lexer, EveryByteScanFindsTheSameBytes)
+{
+    std::mt19937 random(7);
+    std::vector<ByteScan> scans{ByteScan::Scalar};
+    if (best_byte_scan() >= ByteScan::SSSE3)
+        scans.push_back(ByteScan::SSSE3);
+    if (best_byte_scan() >= ByteScan::AVX2)
+        scans.push_back(ByteScan::AVX2);
+    for (int round = 0; round < 200; round++) {
+        ByteSet set;
+        std::string input(random() % 100, '\0');
+        // mostly bytes of the set, so that runs cross vector boundaries
+        std::vector<unsigned char> members;
+        for (int i = 0; i < 1 + round % 20; i++) {
+            members.push_back(static_cast<unsigned char>(random()));
+            set.insert(members.back());
+        }
+        for (auto &byte : input) {
+            const auto member = members[random() % members.size()];
+            byte = static_cast<char>(random() % 16 == 0 ? random() : member);
+        }
+
+        for (std::size_t from = 0; from <= input.size(); from++) {
+            auto expected = from;
+            while (expected < input.size() &&
+                   set.contains(static_cast<unsigned char>(input[expected])))
+                expected++;
+            for (auto scan : scans)
+                ASSERT_EQ(find_first_not_in(set, input, from, scan), expected);
+        }
+    }
+}
+
+TEST(Lexer, MinimizesTheDfa)
+{
+    auto symbols = terminals({"abb"});
+    // the textbook example: 4 states, plus the dead state
+    auto table = generate_lexer({{"abb", "(a|b)*abb"}}, symbols);
+    EXPECT_EQ(table.num_states(), 5);
+    // a, b and everything else
+    EXPECT_EQ(table.num_classes(), 3);
+    EXPECT_NE(table.byte_class('a'), table.byte_class('b'));
+    EXPECT_EQ(table.byte_class('c'), table.byte_class('\0'));
+}
+
+TEST(Lexer, MergesByteClasses)
+{
+    auto symbols = terminals({"word", "number"});
+    auto table = generate_lexer({{"word", "[a-z]+"}, {"number", "[0-9]+"}}, symbols);
+    EXPECT_EQ(table.num_classes(), 3);
+    EXPECT_EQ(table.byte_class('a'), table.byte_class('z'));
+    EXPECT_EQ(table.byte_class('0'), table.byte_class('9'));
+}
+
+TEST(Lexer, RejectsInvalidPatterns)
+{
+    auto symbols = terminals({"t"});
+    for (const auto *pattern : {"(a", "a)", "*a", "[a-z", "a\\", "[z-a]"})
+        EXPECT_THROW(generate_lexer({{"t", pattern}}, symbols), std::invalid_argument) << pattern;
+}
+
+TEST(Lexer, GrammarLoadingSkipsLayoutInWholeRuns)
+{
+    std::string text = "  // a comment\n\t\r\n   E : x // another\n//\n;";
+    const auto file_size = text.size();
+    text.append(2, '\0');
+    Driver driver;
+    driver.input = text.data();
+    driver.input_size = text.size();
+    driver.location.initialize(&driver.file);
+
+    auto offset = driver.skip_layout(0);
+    EXPECT_EQ(text[offset], 'E');
+    EXPECT_EQ(driver.location.begin.line, 3);
+    EXPECT_EQ(driver.location.begin.column, 4);
+    // nothing to skip in front of a token
+    EXPECT_EQ(driver.skip_layout(offset), offset);
+
+    // the scanner moves location over the tokens themselves
+    driver.location.columns(1);
+    offset = driver.skip_layout(offset + 1);
+    EXPECT_EQ(text[offset], ':');
+    EXPECT_EQ(driver.location.begin.column, 6);
+    offset = driver.skip_layout(text.find('x') + 1);
+    EXPECT_EQ(text[offset], ';');
+    EXPECT_EQ(driver.location.begin.line, 5);
+    EXPECT_EQ(driver.location.begin.column, 1);
+    EXPECT_EQ(driver.skip_layout(offset + 1), file_size);
+    driver.input = nullptr;
+}
+
+TEST(Lexer, FeedsTheGrammarTokensToAParser)
+{
+    Driver driver;
+    driver.parse(std::string{EXAMPLE_GRAMMAR_DIR}.append("calc.bnf"));
+    const auto &grammar = driver.grammar;
+    EXPECT_EQ(grammar.get_token_definitions().size(), 7);
+
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser parser{generate_dense_ll_table(set_generator)};
+    auto lexer = generate_lexer(grammar.get_token_definitions(), grammar.get_symbol_table());
+
+    auto parse = [&](std::string_view input) {
+        parser.reset();
+        Scanner scanner(lexer, input);
+        for (Token token; scanner.next(token);)
+            parser.feed(token.symbol);
+        return !scanner.failed() && parser.finish();
+    };
+    EXPECT_TRUE(parse("(x1 + 2.5) * y # a comment\n+ 3"));
+    EXPECT_EQ(parser.tokens_consumed(), 10);
+    EXPECT_FALSE(parse("(x1 + 2.5 * y"));
+    EXPECT_FALSE(parse("x1 - 2"));
+}
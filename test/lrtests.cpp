@@ -0,0 +1,154 @@
+#include <jacc/driver.h>
+#include <jacc/first_follow_set_generator.h>
+#include <jacc/grammar.h>
+#include <jacc/lalr_table_generator.h>
+#include <jacc/lr_automaton.h>
+#include <jacc/table_driven_lr_parser.h>
+#include <fmt/core.h>
+#include <gtest/gtest.h>
+
+namespace
+{
+ProductionSymbol terminal(const std::string &name)
+{
+    return ProductionSymbol{name, ProductionSymbol::Kind::Terminal};
+}
+
+ProductionSymbol nonterminal(const std::string &name)
+{
+    return ProductionSymbol{name, ProductionSymbol::Kind::NonTerminal};
+}
+
+std::vector<ProductionSymbol> tokens(std::initializer_list<const char *> names)
+{
+    std::vector<ProductionSymbol> result;
+    for (const auto *name : names)
+        result.push_back(terminal(name));
+    return result;
+}
+
+// E : E + T | T; T : T * F | F; F : ( E ) | id;
+Grammar left_recursive_expression_grammar()
+{
+    auto e = nonterminal("E");
+    auto t = nonterminal("T");
+    auto f = nonterminal("F");
+    return Grammar{{GrammarRule{e, {Production{{e, terminal("+"), t}}, Production{t}}},
+                    GrammarRule{t, {Production{{t, terminal("*"), f}}, Production{f}}},
+                    GrammarRule{f, {Production{{terminal("("), e, terminal(")")}},
+                                    Production{terminal("id")}}}}};
+}
+} // namespace
+
+TEST(LRAutomaton, BuildsCanonicalLR0CollectionForExpressionGrammar)
+{
+    auto grammar = left_recursive_expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    const LRAutomaton automaton(set_generator.get_engine());
+
+    // the textbook collection I0 .. I11
+    EXPECT_EQ(automaton.num_states(), 12);
+    EXPECT_EQ(automaton.get_kernel(0).size(), 1);
+    EXPECT_EQ(automaton.get_item_production(automaton.get_kernel(0).front()), 0);
+}
+
+TEST(LALRTableGeneration, ExpressionGrammarHasNoConflicts)
+{
+    auto grammar = left_recursive_expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    auto table = generate_lalr_table(set_generator);
+
+    EXPECT_EQ(table.conflicts.shift_reduce, 0);
+    EXPECT_EQ(table.conflicts.reduce_reduce, 0);
+}
+
+TEST(LALRTableGeneration, LookaheadsAreSharperThanFollowSets)
+{
+    // S : L = R | R; L : * R | id; R : L;
+    // SLR(1) has a shift/reduce conflict on '=' here, LALR(1) doesn't
+    auto s = nonterminal("S");
+    auto l = nonterminal("L");
+    auto r = nonterminal("R");
+    auto grammar =
+        Grammar{{GrammarRule{s, {Production{{l, terminal("="), r}}, Production{r}}},
+                 GrammarRule{l, {Production{{terminal("*"), r}}, Production{terminal("id")}}},
+                 GrammarRule{r, Production{l}}}};
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    auto table = generate_lalr_table(set_generator);
+
+    EXPECT_EQ(table.conflicts.shift_reduce, 0);
+    EXPECT_EQ(table.conflicts.reduce_reduce, 0);
+
+    LRParser parser{table};
+    EXPECT_TRUE(parser.parse(tokens({"*", "id", "=", "id"})));
+    parser.reset();
+    EXPECT_FALSE(parser.parse(tokens({"id", "=", "=", "id"})));
+}
+
+TEST(LRParsing, ParsesLeftRecursiveExpressions)
+{
+    auto grammar = left_recursive_expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LRParser parser{generate_lalr_table(set_generator)};
+
+    EXPECT_TRUE(parser.parse(tokens({"id", "+", "id", "*", "(", "id", "+", "id", ")"})));
+    EXPECT_TRUE(parser.done());
+    parser.reset();
+    EXPECT_FALSE(parser.parse(tokens({"id", "+", "*", "id"})));
+    parser.reset();
+    EXPECT_FALSE(parser.parse(tokens({"id", "-", "id"})));
+    parser.reset();
+    EXPECT_FALSE(parser.parse({}));
+}
+
+TEST(LRParsing, StreamsTokens)
+{
+    auto grammar = left_recursive_expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LRParser parser{generate_lalr_table(set_generator)};
+
+    for (const auto &token : tokens({"id", "*", "(", "id"}))
+        EXPECT_TRUE(parser.feed(token));
+    EXPECT_FALSE(parser.finish());
+    EXPECT_EQ(parser.tokens_consumed(), 4);
+
+    parser.reset();
+    for (const auto &token : tokens({"id", "*", "(", "id", ")"}))
+        EXPECT_TRUE(parser.feed(token));
+    EXPECT_TRUE(parser.finish());
+}
+
+TEST(LRParsing, HandlesEpsilonProductions)
+{
+    // S : A b; A : a | _epsilon_;
+    auto s = nonterminal("S");
+    auto a = nonterminal("A");
+    auto epsilon = ProductionSymbol::create_epsilon();
+    auto grammar =
+        Grammar{{GrammarRule{s, Production{{a, terminal("b")}}},
+                 GrammarRule{a, {Production{terminal("a")}, Production{epsilon}}}}};
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LRParser parser{generate_lalr_table(set_generator)};
+
+    EXPECT_TRUE(parser.parse(tokens({"b"})));
+    parser.reset();
+    EXPECT_TRUE(parser.parse(tokens({"a", "b"})));
+    parser.reset();
+    EXPECT_FALSE(parser.parse(tokens({"a"})));
+}
+
+TEST(LRParsing, CanParseWithEnergyGrammar)
+{
+    Driver driver;
+    driver.parse(std::string{EXAMPLE_GRAMMAR_DIR}.append("energy.bnf"));
+    auto set_generator = FirstFollowSetGenerator(driver.grammar);
+    auto table = generate_lalr_table(set_generator);
+    // EXPRESSION : EXPRESSION BINOP EXPRESSION is ambiguous, those conflicts shift
+    EXPECT_GT(table.conflicts.shift_reduce, 0);
+
+    LRParser parser{table};
+    // main (typename x) = { return x plus 1; } eof
+    EXPECT_TRUE(parser.parse(tokens({"id", "'('", "typename", "id", "')'", "assignment", "'{'",
+                                     "returnkeyword", "id", "plus", "int", "semicolon", "'}'",
+                                     "eof"})));
+}
@@ -0,0 +1,556 @@
+#include <jacc/first_follow_set_generator.h>
+#include <jacc/grammar.h>
+#include <jacc/ll_table_generator.h>
+#include <jacc/parse_batch.h>
+#include <jacc/semantic_actions.h>
+#include <jacc/syntax_tree.h>
+#include <jacc/table_driven_ll_parser.h>
+#include <jacc/trace.h>
+#include <fmt/core.h>
+#include <gtest/gtest.h>
+#include <array>
+#include <ranges>
+#include <stdexcept>
+
+namespace
+{
+ProductionSymbol terminal(const std::string &name)
+{
+    return ProductionSymbol{name, ProductionSymbol::Kind::Terminal};
+}
+
+Grammar expression_grammar()
+{
+    auto e = ProductionSymbol{"E", ProductionSymbol::Kind::NonTerminal};
+    auto ep = ProductionSymbol{"E'", ProductionSymbol::Kind::NonTerminal};
+    auto t = ProductionSymbol{"T", ProductionSymbol::Kind::NonTerminal};
+    auto tp = ProductionSymbol{"T'", ProductionSymbol::Kind::NonTerminal};
+    auto f = ProductionSymbol{"F", ProductionSymbol::Kind::NonTerminal};
+    auto epsilon = ProductionSymbol::create_epsilon();
+
+    auto e_rule = GrammarRule{e, Production{{t, ep}}};
+    auto ep_rule = GrammarRule{ep, {Production{{terminal("+"), t, ep}}, Production{epsilon}}};
+    auto t_rule = GrammarRule{t, Production{{f, tp}}};
+    auto tp_rule = GrammarRule{tp, {Production{{terminal("*"), f, tp}}, Production{epsilon}}};
+    auto f_rule =
+        GrammarRule{f, {Production{{terminal("("), e, terminal(")")}}, Production{terminal("id")}}};
+    return Grammar{{e_rule, ep_rule, t_rule, tp_rule, f_rule}};
+}
+
+// symbol, start, length and production of every node in preorder, terminals have no production
+std::vector<std::array<std::size_t, 4>> flatten(const SyntaxTree &tree, const SymbolTable &symbols)
+{
+    std::vector<std::array<std::size_t, 4>> nodes;
+    std::vector<SyntaxTree::NodeId> stack{tree.root()};
+    while (!stack.empty()) {
+        const auto node = stack.back();
+        stack.pop_back();
+        const auto production =
+            symbols.is_terminal(tree[node].symbol) ? LLTable::no_production : tree[node].value;
+        nodes.push_back({tree[node].symbol, tree.start(node), tree[node].length, production});
+        std::vector<SyntaxTree::NodeId> children;
+        tree.for_each_child(node, [&](SyntaxTree::NodeId child) {
+            EXPECT_EQ(tree[child].parent, node);
+            children.push_back(child);
+        });
+        stack.insert(stack.end(), children.rbegin(), children.rend());
+    }
+    return nodes;
+}
+} // namespace
+
+TEST(LLParsing, AcceptsValidExpression)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    auto table = generate_ll_table(grammar, set_generator);
+    LLParser parser{table, grammar.get_rules().front().get_LHS()};
+
+    auto input = std::vector<ProductionSymbol>{terminal("("), terminal("id"), terminal("+"),
+                                               terminal("id"), terminal(")"), terminal("*"),
+                                               terminal("id")};
+    EXPECT_TRUE(parser.parse(input));
+    EXPECT_TRUE(parser.done());
+}
+
+TEST(LLParsing, RejectsInvalidExpression)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    auto table = generate_ll_table(grammar, set_generator);
+    LLParser parser{table, grammar.get_rules().front().get_LHS()};
+
+    auto dangling_operator = std::vector<ProductionSymbol>{terminal("id"), terminal("+")};
+    EXPECT_FALSE(parser.parse(dangling_operator));
+
+    parser.reset();
+    auto unknown_token =
+        std::vector<ProductionSymbol>{terminal("id"), terminal("-"), terminal("id")};
+    EXPECT_FALSE(parser.parse(unknown_token));
+}
+
+TEST(LLParsing, DenseTableParserAgreesWithMapTableParser)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser map_parser{generate_ll_table(grammar, set_generator),
+                        grammar.get_rules().front().get_LHS()};
+    LLParser dense_parser{generate_dense_ll_table(set_generator)};
+
+    auto inputs = std::vector<std::vector<ProductionSymbol>>{
+        {terminal("id")},
+        {terminal("id"), terminal("*"), terminal("("), terminal("id"), terminal(")")},
+        {terminal("("), terminal("id")},
+        {terminal("id"), terminal("id")},
+        {},
+    };
+    for (auto input : inputs) {
+        auto copy = input;
+        map_parser.reset();
+        dense_parser.reset();
+        EXPECT_EQ(map_parser.parse(input), dense_parser.parse(copy));
+    }
+}
+
+TEST(LLParsing, CompressedTablesAcceptTheSameInputs)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser dense_parser{generate_dense_ll_table(set_generator)};
+
+    auto inputs = std::vector<std::vector<ProductionSymbol>>{
+        {terminal("id")},
+        {terminal("id"), terminal("*"), terminal("("), terminal("id"), terminal(")")},
+        {terminal("("), terminal("id")},
+        {terminal("id"), terminal("id")},
+        {terminal("id"), terminal("+"), terminal(")")},
+        {terminal("id"), terminal("-"), terminal("id")},
+        {},
+    };
+    for (auto encoding : {LLTable::Encoding::RowDisplacement, LLTable::Encoding::DefaultRows}) {
+        LLParser compressed_parser{generate_dense_ll_table(set_generator, encoding)};
+        for (const auto &input : inputs) {
+            dense_parser.reset();
+            compressed_parser.reset();
+            EXPECT_EQ(dense_parser.parse(input), compressed_parser.parse(input))
+                << fmt::format("{}", input);
+        }
+    }
+}
+
+TEST(LLParsing, StreamsTokensAcrossChunks)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser parser{generate_dense_ll_table(set_generator)};
+
+    auto first_chunk = std::vector<ProductionSymbol>{terminal("("), terminal("id"), terminal("+")};
+    auto second_chunk = std::vector<ProductionSymbol>{terminal("id"), terminal(")")};
+    for (const auto &token : first_chunk)
+        EXPECT_TRUE(parser.feed(token));
+    EXPECT_FALSE(parser.done());
+    for (const auto &token : second_chunk)
+        EXPECT_TRUE(parser.feed(token));
+    EXPECT_TRUE(parser.finish());
+    EXPECT_TRUE(parser.done());
+    EXPECT_EQ(parser.tokens_consumed(), 6);
+}
+
+TEST(LLParsing, StopsAtFirstBadToken)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser parser{generate_dense_ll_table(set_generator)};
+
+    EXPECT_TRUE(parser.feed(terminal("id")));
+    EXPECT_TRUE(parser.feed(terminal("+")));
+    EXPECT_FALSE(parser.feed(terminal(")")));
+    EXPECT_EQ(parser.tokens_consumed(), 2);
+    ASSERT_EQ(parser.get_errors().size(), 1);
+    EXPECT_EQ(parser.get_errors()[0].position, 2);
+    EXPECT_FALSE(parser.feed(terminal("id")));
+    EXPECT_FALSE(parser.finish());
+
+    // nothing may follow the end of input
+    parser.reset();
+    EXPECT_TRUE(parser.feed(terminal("id")));
+    EXPECT_TRUE(parser.feed(SymbolTable::eoi_id));
+    EXPECT_FALSE(parser.feed(terminal("id")));
+    EXPECT_FALSE(parser.finish());
+}
+
+TEST(LLParsing, RecoversAndReportsEveryError)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser parser{generate_dense_ll_table(set_generator)};
+    parser.set_recovery(LLParser::Recovery::PanicMode, set_generator);
+
+    // both operators lack their right operand, ) and + are in FOLLOW(T)
+    auto input = std::vector<ProductionSymbol>{terminal("("), terminal("id"), terminal("+"),
+                                               terminal(")"), terminal("*"), terminal("id"),
+                                               terminal("+"), terminal("+"), terminal("id")};
+    EXPECT_FALSE(parser.parse(input));
+    EXPECT_TRUE(parser.done());
+    EXPECT_EQ(parser.tokens_consumed(), input.size() + 1);
+    const auto &errors = parser.get_errors();
+    ASSERT_EQ(errors.size(), 2);
+    EXPECT_EQ(errors[0].position, 3);
+    EXPECT_EQ(errors[1].position, 7);
+    for (const auto &error : errors) {
+        EXPECT_EQ(error.type, LLParser::ErrorType::NOMATCHINGPRODUCTION);
+        EXPECT_EQ(parser.get_table().get_symbol_table().get_symbol(error.expected),
+                  (ProductionSymbol{"T", ProductionSymbol::Kind::NonTerminal}));
+    }
+    EXPECT_EQ(parser.describe(errors[0]), "3: unexpected ')', expected 'T'");
+
+    // a stray token is skipped until E can start again, a missing ) is made up at the end
+    parser.reset();
+    auto unbalanced = std::vector<ProductionSymbol>{terminal("("), terminal("+"), terminal("id")};
+    EXPECT_FALSE(parser.parse(unbalanced));
+    EXPECT_TRUE(parser.done());
+    ASSERT_EQ(parser.get_errors().size(), 2);
+    EXPECT_EQ(parser.get_errors()[0].position, 1);
+    EXPECT_EQ(parser.get_errors()[1].position, 3);
+    EXPECT_EQ(parser.get_errors()[1].type, LLParser::ErrorType::TERMINALMISMATCH);
+}
+
+TEST(LLParsing, PhraseLevelRecoveryDeletesStrayTokens)
+{
+    auto s = ProductionSymbol{"S", ProductionSymbol::Kind::NonTerminal};
+    auto grammar = Grammar{{GrammarRule{s, Production{{terminal("a"), terminal("b")}}}}};
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser parser{generate_dense_ll_table(set_generator)};
+    auto input = std::vector<ProductionSymbol>{terminal("a"), terminal("x"), terminal("b"),
+                                               terminal("b")};
+
+    // panic mode takes b as missing and then skips everything
+    parser.set_recovery(LLParser::Recovery::PanicMode, set_generator);
+    EXPECT_FALSE(parser.parse(input));
+    ASSERT_EQ(parser.get_errors().size(), 1);
+    EXPECT_EQ(parser.get_errors()[0].position, 1);
+
+    // x doesn't fit after b, so it is deleted and the trailing b is found as well
+    parser.set_recovery(LLParser::Recovery::PhraseLevel, set_generator);
+    EXPECT_FALSE(parser.parse(input));
+    const auto &errors = parser.get_errors();
+    ASSERT_EQ(errors.size(), 2);
+    EXPECT_EQ(errors[0].type, LLParser::ErrorType::TERMINALMISMATCH);
+    EXPECT_EQ(errors[0].position, 1);
+    EXPECT_EQ(errors[1].type, LLParser::ErrorType::TRAILINGINPUT);
+    EXPECT_EQ(errors[1].position, 3);
+    EXPECT_EQ(parser.describe(errors[1]), "3: unexpected 'b', expected end of input");
+}
+
+TEST(LLParsing, RecoveryTerminatesWithDefaultRows)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser parser{generate_dense_ll_table(set_generator, LLTable::Encoding::DefaultRows)};
+    parser.set_recovery(LLParser::Recovery::PhraseLevel, set_generator);
+
+    auto input = std::vector<ProductionSymbol>{terminal("("), terminal("+"), terminal("id"),
+                                               terminal(")"), terminal(")"), terminal("-")};
+    EXPECT_FALSE(parser.parse(input));
+    EXPECT_TRUE(parser.done());
+    EXPECT_FALSE(parser.get_errors().empty());
+}
+
+TEST(LLParsing, ParsesBatchLikeOneParserInSequence)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser parser{generate_dense_ll_table(set_generator)};
+    parser.set_recovery(LLParser::Recovery::PanicMode, set_generator);
+    LLParser copy = parser;
+    EXPECT_EQ(copy.get_shared_table(), parser.get_shared_table());
+
+    const auto &symbols = parser.get_table().get_symbol_table();
+    auto id = [&](const char *name) {
+        return symbols.find(name, ProductionSymbol::Kind::Terminal);
+    };
+    // id + id + ... of every length, with a few long ones and some broken ones in between
+    std::vector<std::vector<SymbolId>> inputs;
+    for (std::size_t i = 0; i < 500; i++) {
+        std::vector<SymbolId> input{id("id")};
+        for (std::size_t j = 0; j < (i % 50 == 0 ? 5000 : i % 7); j++) {
+            input.push_back(id("+"));
+            input.push_back(i % 11 == 0 && j == 1 ? id(")") : id("id"));
+        }
+        inputs.push_back(std::move(input));
+    }
+
+    for (unsigned threads : {1u, 4u}) {
+        const auto results = parse_batch(parser, inputs, threads);
+        ASSERT_EQ(results.size(), inputs.size());
+        for (std::size_t i = 0; i < inputs.size(); i++) {
+            parser.reset();
+            EXPECT_EQ(results[i].accepted, parser.parse(inputs[i].begin(), inputs[i].end()));
+            ASSERT_EQ(results[i].errors.size(), parser.get_errors().size());
+            for (std::size_t e = 0; e < results[i].errors.size(); e++)
+                EXPECT_EQ(results[i].errors[e].position, parser.get_errors()[e].position);
+        }
+    }
+    EXPECT_TRUE(parse_batch(parser, {}).empty());
+}
+
+TEST(LLParsing, ParsesSymbolIdSource)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser parser{generate_dense_ll_table(set_generator)};
+    const auto &symbols = grammar.get_symbol_table();
+
+    // a lazily produced token stream: id * id * id ...
+    auto stream = std::views::iota(0, 9) | std::views::transform([&](int i) {
+                      return symbols.find(terminal(i % 2 == 0 ? "id" : "*"));
+                  });
+    EXPECT_TRUE(parser.parse(stream.begin(), stream.end()));
+}
+
+TEST(LLParsing, BuildsSyntaxTree)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser parser{generate_dense_ll_table(set_generator)};
+    SyntaxTree tree;
+    parser.set_syntax_tree(&tree);
+
+    auto input = std::vector<ProductionSymbol>{terminal("("), terminal("id"), terminal("+"),
+                                               terminal("id"), terminal(")"), terminal("*"),
+                                               terminal("id")};
+    ASSERT_TRUE(parser.parse(input));
+
+    const auto &symbols = grammar.get_symbol_table();
+    ASSERT_NE(tree.root(), SyntaxTree::no_node);
+    EXPECT_EQ(symbols.get_symbol(tree[tree.root()].symbol), grammar.get_rules().front().get_LHS());
+
+    // the leaves from left to right are the input, every child points back at its parent
+    std::vector<ProductionSymbol> leaves;
+    std::vector<std::uint32_t> positions;
+    std::vector<SyntaxTree::NodeId> stack{tree.root()};
+    while (!stack.empty()) {
+        const auto node = stack.back();
+        stack.pop_back();
+        if (symbols.is_terminal(tree[node].symbol)) {
+            leaves.push_back(symbols.get_symbol(tree[node].symbol));
+            positions.push_back(tree[node].value);
+            continue;
+        }
+        std::vector<SyntaxTree::NodeId> children;
+        tree.for_each_child(node, [&](SyntaxTree::NodeId child) {
+            EXPECT_EQ(tree[child].parent, node);
+            children.push_back(child);
+        });
+        stack.insert(stack.end(), children.rbegin(), children.rend());
+    }
+    EXPECT_EQ(leaves, input);
+    EXPECT_EQ(positions, (std::vector<std::uint32_t>{0, 1, 2, 3, 4, 5, 6}));
+
+    parser.reset();
+    EXPECT_EQ(tree.size(), 1);
+}
+
+TEST(LLParsing, ReparsesEditsLikeAWholeParse)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    const auto table = std::make_shared<const LLTable>(generate_dense_ll_table(set_generator));
+    const auto &symbols = table->get_symbol_table();
+    auto ids = [&](std::initializer_list<const char *> names) {
+        std::vector<SymbolId> tokens;
+        for (const auto *name : names)
+            tokens.push_back(symbols.find(terminal(name)));
+        return tokens;
+    };
+    const auto id = symbols.find(terminal("id"));
+    const std::vector<std::vector<SymbolId>> replacements{
+        ids({"id"}), ids({"(", "id", "+", "id", ")"}), ids({"id", "*", "id"}), ids({"+"}), {}};
+
+    std::vector<SymbolId> input;
+    for (int i = 0; i < 50; i++) {
+        const auto term = i % 3 == 0 ? ids({"(", "id", "*", "id", ")"}) : ids({"id"});
+        input.insert(input.end(), term.begin(), term.end());
+        input.push_back(symbols.find(terminal(i % 2 == 0 ? "+" : "*")));
+    }
+    input.push_back(id);
+
+    LLParser incremental{table};
+    SyntaxTree tree;
+    incremental.set_syntax_tree(&tree);
+    ASSERT_TRUE(incremental.parse(input.begin(), input.end()));
+    // replaces ids with random snippets, some of which don't fit
+    std::uint32_t random = 1;
+    std::size_t accepted = 0;
+    for (int edit = 0; edit < 200; edit++) {
+        random = random * 1664525u + 1013904223u;
+        auto position = (random >> 8) % input.size();
+        while (position > 0 && input[position] != id)
+            position--;
+        const auto &replacement = replacements[(random >> 24) % replacements.size()];
+        auto edited = input;
+        edited.erase(edited.begin() + static_cast<std::ptrdiff_t>(position));
+        edited.insert(edited.begin() + static_cast<std::ptrdiff_t>(position), replacement.begin(),
+                      replacement.end());
+
+        LLParser whole{table};
+        SyntaxTree whole_tree;
+        whole.set_syntax_tree(&whole_tree);
+        const auto expected = whole.parse(edited.begin(), edited.end());
+        EXPECT_EQ(incremental.reparse(edited, LLParser::TokenEdit::between(input, edited)),
+                  expected)
+            << edit;
+        if (expected) {
+            EXPECT_EQ(flatten(tree, symbols), flatten(whole_tree, symbols)) << edit;
+            // replaced nodes are freed, not left behind
+            EXPECT_EQ(tree.size(), whole_tree.size()) << edit;
+            input = edited;
+            accepted++;
+        } else {
+            // back to the last input, that can't be incremental without an accepted parse
+            ASSERT_TRUE(incremental.reparse(input, LLParser::TokenEdit::between(edited, input)));
+        }
+    }
+    EXPECT_GT(accepted, 50);
+}
+
+TEST(LLParsing, ReparseOnlyTouchesTheEditedSubtree)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser parser{generate_dense_ll_table(set_generator)};
+    const auto &symbols = parser.get_table().get_symbol_table();
+    const auto id = symbols.find(terminal("id"));
+    const auto plus = symbols.find(terminal("+"));
+    SyntaxTree tree;
+    parser.set_syntax_tree(&tree);
+
+    std::vector<SymbolId> input{id};
+    for (int i = 0; i < 10000; i++)
+        input.insert(input.end(), {plus, id});
+    ASSERT_TRUE(parser.parse(input.begin(), input.end()));
+    const auto nodes = tree.num_allocated();
+
+    // id → ( id )
+    const LLParser::TokenEdit edit{10000, 1, 3};
+    auto edited = input;
+    edited.erase(edited.begin() + 10000);
+    edited.insert(edited.begin() + 10000, {symbols.find(terminal("(")), id,
+                                           symbols.find(terminal(")"))});
+    ASSERT_TRUE(parser.reparse(edited, edit));
+    EXPECT_LT(tree.num_allocated(), nodes + 40);
+    EXPECT_EQ(tree[tree.root()].length, edited.size());
+
+    // editing back and forth reuses the nodes freed by the edit before
+    const auto allocated = tree.num_allocated();
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(parser.reparse(input, LLParser::TokenEdit::between(edited, input)));
+        ASSERT_TRUE(parser.reparse(edited, edit));
+    }
+    EXPECT_EQ(tree.num_allocated(), allocated);
+    input = edited;
+
+    // + → *, which joins two elements of the list: ( id ) * id
+    input[10003] = symbols.find(terminal("*"));
+    ASSERT_TRUE(parser.reparse(input, {10003, 1, 1}));
+    EXPECT_LT(tree.num_allocated(), allocated + 40);
+    SyntaxTree whole_tree;
+    LLParser whole{parser.get_table()};
+    whole.set_syntax_tree(&whole_tree);
+    ASSERT_TRUE(whole.parse(input.begin(), input.end()));
+    EXPECT_EQ(tree.size(), whole_tree.size());
+    EXPECT_EQ(flatten(tree, symbols), flatten(whole_tree, symbols));
+
+    // an empty edit changes nothing, one that doesn't fit the input is an error
+    EXPECT_TRUE(parser.reparse(input, {}));
+    EXPECT_THROW(parser.reparse(input, {0, 1, 0}), std::invalid_argument);
+}
+
+TEST(SyntaxTree, GrowsAcrossChunks)
+{
+    SyntaxTree tree;
+    const auto root = tree.add_root(0);
+    const auto symbols = std::vector<SymbolId>(3, 1);
+    auto parent = root;
+    // a long chain, well past the first chunk
+    for (int i = 0; i < 100000; i++)
+        parent = tree.add_children(parent, symbols) + 2;
+    EXPECT_EQ(tree.size(), 300001);
+
+    std::size_t depth = 0;
+    for (auto node = parent; node != root; node = tree[node].parent)
+        depth++;
+    EXPECT_EQ(depth, 100000);
+
+    tree.clear();
+    EXPECT_EQ(tree.root(), SyntaxTree::no_node);
+    EXPECT_EQ(tree.add_root(2), 0);
+}
+
+TEST(LLParsing, EvaluatesWithSemanticActions)
+{
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser parser{generate_dense_ll_table(set_generator)};
+
+    // ( 2 + 3 ) * 4, every id token gets its number from the context
+    struct Input {
+        std::vector<int> numbers;
+    } input{{0, 2, 0, 3, 0, 0, 4}};
+    auto tokens = std::vector<ProductionSymbol>{terminal("("), terminal("id"), terminal("+"),
+                                                terminal("id"), terminal(")"), terminal("*"),
+                                                terminal("id")};
+
+    auto nt = [](const char *name) {
+        return ProductionSymbol{name, ProductionSymbol::Kind::NonTerminal};
+    };
+    auto epsilon = ProductionSymbol::create_epsilon();
+    using Actions = SemanticActions<int, Input>;
+    Actions actions(parser.get_table(), input);
+    actions.on_token([](Input &in, SymbolId, std::size_t position) { return in.numbers[position]; });
+    // E' and T' hold the sum and product of what follows them
+    EXPECT_TRUE(actions.on(nt("E"), {nt("T"), nt("E'")},
+                           [](Input &, std::span<int> v) { return v[0] + v[1]; }));
+    EXPECT_TRUE(actions.on(nt("E'"), {terminal("+"), nt("T"), nt("E'")},
+                           [](Input &, std::span<int> v) { return v[1] + v[2]; }));
+    EXPECT_TRUE(actions.on(nt("E'"), {epsilon}, [](Input &, std::span<int>) { return 0; }));
+    EXPECT_TRUE(actions.on(nt("T"), {nt("F"), nt("T'")},
+                           [](Input &, std::span<int> v) { return v[0] * v[1]; }));
+    EXPECT_TRUE(actions.on(nt("T'"), {terminal("*"), nt("F"), nt("T'")},
+                           [](Input &, std::span<int> v) { return v[1] * v[2]; }));
+    EXPECT_TRUE(actions.on(nt("T'"), {epsilon}, [](Input &, std::span<int>) { return 1; }));
+    EXPECT_TRUE(actions.on(nt("F"), {terminal("("), nt("E"), terminal(")")},
+                           [](Input &, std::span<int> v) { return v[1]; }));
+    EXPECT_FALSE(actions.on(nt("F"), {terminal("-")}, nullptr));
+
+    ASSERT_TRUE(parser.parse(tokens.begin(), tokens.end(), actions));
+    EXPECT_EQ(actions.result(), 20);
+
+    // the plain interface still works after parsing with actions
+    parser.reset();
+    EXPECT_TRUE(parser.parse(tokens));
+}
+
+TEST(LLParsing, ReportsTraceEvents)
+{
+#ifndef JACC_ENABLE_TRACE_EVENTS
+    GTEST_SKIP() << "built without JACC_TRACE_EVENTS";
+#endif
+    struct RecordingSink : TraceSink {
+        std::vector<TraceEvent::Kind> kinds;
+        void on_event(const TraceEvent &event) override { kinds.push_back(event.kind); }
+    };
+
+    auto grammar = expression_grammar();
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    LLParser parser{generate_dense_ll_table(set_generator)};
+    RecordingSink sink;
+    parser.set_trace_sink(&sink);
+
+    EXPECT_TRUE(parser.parse(std::vector<ProductionSymbol>{terminal("id")}));
+    using Kind = TraceEvent::Kind;
+    // E → T E', T → F T', F → id, T' → ε, E' → ε
+    auto expected = std::vector<Kind>{Kind::Expand, Kind::Expand, Kind::Expand, Kind::Match,
+                                      Kind::Expand, Kind::Expand, Kind::Match};
+    EXPECT_EQ(sink.kinds, expected);
+}
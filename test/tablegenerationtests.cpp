@@ -1,8 +1,13 @@
+#include <jacc/driver.h>
 #include <jacc/first_follow_set_generator.h>
 #include <jacc/grammar.h>
+#include <jacc/ll_parser_emitter.h>
 #include <jacc/ll_table_generator.h>
+#include <jacc/perfect_hash.h>
 #include <fmt/core.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
 // #include <spdlog/spdlog.h>
 
 // TEST(TableGeneration, YeahIDunno) {
@@ -123,3 +128,316 @@ TEST(TableGeneration, GrammarsCanIdentifyNullableNonTerminals)
     EXPECT_TRUE(is_nullable(a, indirectly_nullable_grammar));
     EXPECT_TRUE(is_nullable(b, indirectly_nullable_grammar));
 }
+
+TEST(TableGeneration, DenseTableMatchesMapTableForExampleGrammars)
+{
+    for (const auto *file : {"exp.bnf", "first.bnf", "test.bnf"}) {
+        Driver driver;
+        driver.parse(std::string{EXAMPLE_GRAMMAR_DIR}.append(file));
+        auto set_generator = FirstFollowSetGenerator(driver.grammar);
+
+        auto map_table = generate_ll_table(driver.grammar, set_generator);
+        auto dense_table = generate_dense_ll_table(set_generator);
+        const auto &symbols = dense_table.get_symbol_table();
+
+        std::size_t filled_cells = 0;
+        for (auto nonterminal : symbols.get_nonterminals()) {
+            for (auto terminal : symbols.get_terminals()) {
+                const auto production = dense_table.lookup(nonterminal, terminal);
+                const auto &row = map_table[symbols.get_symbol(nonterminal)];
+                auto cell = row.find(symbols.get_symbol(terminal));
+                if (production == LLTable::no_production) {
+                    EXPECT_TRUE(cell == row.end()) << file;
+                    continue;
+                }
+                filled_cells++;
+                ASSERT_TRUE(cell != row.end()) << file;
+                EXPECT_EQ(dense_table.to_production(production), cell->second)
+                    << fmt::format("{}: [{}][{}]", file, symbols.get_symbol(nonterminal),
+                                   symbols.get_symbol(terminal));
+            }
+        }
+        EXPECT_GT(filled_cells, 0) << file;
+    }
+}
+
+TEST(TableGeneration, DenseTableLookupOfUnknownSymbolsMisses)
+{
+    auto s = ProductionSymbol{"S", ProductionSymbol::Kind::NonTerminal};
+    auto x = ProductionSymbol{"x", ProductionSymbol::Kind::Terminal};
+    auto grammar = Grammar{GrammarRule{s, Production{x}}};
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    auto table = generate_dense_ll_table(set_generator);
+    const auto &symbols = table.get_symbol_table();
+
+    EXPECT_EQ(table.get_start_symbol(), symbols.find(s));
+    EXPECT_NE(table.lookup(symbols.find(s), symbols.find(x)), LLTable::no_production);
+    EXPECT_EQ(table.lookup(symbols.find(s), SymbolTable::eoi_id), LLTable::no_production);
+    EXPECT_EQ(table.lookup(symbols.find(s), SymbolTable::invalid_id), LLTable::no_production);
+    EXPECT_EQ(table.lookup(symbols.find(x), symbols.find(x)), LLTable::no_production);
+    EXPECT_EQ(table.num_productions(), 1);
+}
+
+TEST(TableGeneration, EmittedParserIsSelfContained)
+{
+    Driver driver;
+    driver.parse(std::string{EXAMPLE_GRAMMAR_DIR}.append("exp.bnf"));
+    auto set_generator = FirstFollowSetGenerator(driver.grammar);
+    auto table = generate_dense_ll_table(set_generator);
+
+    auto emitted = emit_ll_parser(table, "exp-parser");
+
+    EXPECT_EQ(emitted.header_name, "exp_parser.h");
+    EXPECT_EQ(emitted.source_name, "exp_parser.cpp");
+    EXPECT_NE(emitted.header.find("namespace exp_parser"), std::string::npos);
+    EXPECT_NE(emitted.source.find("#include \"exp_parser.h\""), std::string::npos);
+    EXPECT_NE(emitted.header.find(fmt::format("num_terminals = {};", table.num_columns())),
+              std::string::npos);
+    for (const auto *dependency : {"jacc/", "spdlog", "fmt/", "std::map"}) {
+        EXPECT_EQ(emitted.header.find(dependency), std::string::npos) << dependency;
+        EXPECT_EQ(emitted.source.find(dependency), std::string::npos) << dependency;
+    }
+}
+
+TEST(TableGeneration, DenseTableReportsEveryConflict)
+{
+    // S : A x | x y | B; A : x | ε; B : C | ε; C : ε;
+    auto nonterminal = [](const char *name) {
+        return ProductionSymbol{name, ProductionSymbol::Kind::NonTerminal};
+    };
+    auto terminal = [](const char *name) {
+        return ProductionSymbol{name, ProductionSymbol::Kind::Terminal};
+    };
+    auto s = nonterminal("S"), a = nonterminal("A"), b = nonterminal("B"), c = nonterminal("C");
+    auto x = terminal("x");
+    auto epsilon = Production{ProductionSymbol::create_epsilon()};
+    auto grammar = Grammar{{
+        GrammarRule{s, {Production{{a, x}}, Production{{x, terminal("y")}}, Production{b}}},
+        GrammarRule{a, {Production{x}, epsilon}},
+        GrammarRule{b, {Production{c}, epsilon}},
+        GrammarRule{c, epsilon},
+    }};
+    auto set_generator = FirstFollowSetGenerator(grammar);
+    auto table = generate_dense_ll_table(set_generator);
+    const auto &symbols = table.get_symbol_table();
+
+    ASSERT_EQ(table.conflicts.size(), 3);
+    const auto &first_first = table.conflicts[0];
+    EXPECT_EQ(first_first.kind, LLTable::ConflictKind::FirstFirst);
+    EXPECT_EQ(table.describe(first_first),
+              "FIRST/FIRST conflict in S on x: S -> A x kept over S -> x y");
+    EXPECT_EQ(table.lookup(symbols.find(s), symbols.find(x)), first_first.kept);
+
+    const auto &first_follow = table.conflicts[1];
+    EXPECT_EQ(first_follow.kind, LLTable::ConflictKind::FirstFollow);
+    EXPECT_EQ(table.describe(first_follow),
+              "FIRST/FOLLOW conflict in A on x: A -> x kept over A -> epsilon");
+
+    const auto &follow_follow = table.conflicts[2];
+    EXPECT_EQ(follow_follow.kind, LLTable::ConflictKind::FollowFollow);
+    EXPECT_EQ(follow_follow.nonterminal, symbols.find(b));
+    EXPECT_EQ(follow_follow.terminal, SymbolTable::eoi_id);
+}
+
+TEST(TableGeneration, DenseTableStatsCountFilledCells)
+{
+    Driver driver;
+    driver.parse(std::string{EXAMPLE_GRAMMAR_DIR}.append("exp.bnf"));
+    auto set_generator = FirstFollowSetGenerator(driver.grammar);
+    auto table = generate_dense_ll_table(set_generator);
+
+    const auto stats = table.compute_stats();
+    const auto &cells = table.get_cells();
+    const auto filled = static_cast<std::size_t>(
+        std::count_if(cells.begin(), cells.end(),
+                      [](auto cell) { return cell != LLTable::no_production; }));
+    EXPECT_EQ(stats.rows, table.num_rows());
+    EXPECT_EQ(stats.columns, table.num_columns());
+    EXPECT_EQ(stats.filled_cells, filled);
+    EXPECT_EQ(stats.conflicts, 0);
+    EXPECT_DOUBLE_EQ(stats.fill_ratio,
+                     static_cast<double>(filled) / static_cast<double>(cells.size()));
+    EXPECT_EQ(stats.dense_bytes, cells.size() * sizeof(LLTable::ProductionIndex));
+    // every filled cell needs an entry and a check, and the rows are packed into fewer entries
+    // than the dense table has cells
+    EXPECT_GE(stats.compressed_bytes, filled * 8);
+    EXPECT_LT(stats.compressed_bytes, cells.size() * 8 + stats.rows * 8);
+    EXPECT_LE(stats.default_rows_bytes, stats.compressed_bytes);
+}
+
+TEST(TableGeneration, CompressedTablesLookUpLikeDenseTable)
+{
+    for (const auto *file : {"exp.bnf", "energy.bnf", "test.bnf"}) {
+        Driver driver;
+        driver.parse(std::string{EXAMPLE_GRAMMAR_DIR}.append(file));
+        auto set_generator = FirstFollowSetGenerator(driver.grammar);
+        const auto dense = generate_dense_ll_table(set_generator);
+        const auto displaced =
+            generate_dense_ll_table(set_generator, LLTable::Encoding::RowDisplacement);
+        const auto default_rows =
+            generate_dense_ll_table(set_generator, LLTable::Encoding::DefaultRows);
+        const auto &symbols = dense.get_symbol_table();
+
+        EXPECT_TRUE(displaced.get_cells().empty());
+        auto stored = [](const LLTable &table) {
+            const auto &checks = table.get_checks();
+            return std::count_if(checks.begin(), checks.end(),
+                                 [](auto check) { return check != SymbolTable::no_index; });
+        };
+        EXPECT_LT(stored(default_rows), stored(displaced)) << file;
+        for (auto nonterminal : symbols.get_nonterminals()) {
+            const auto row = symbols.nonterminal_index(nonterminal);
+            for (auto terminal : symbols.get_terminals()) {
+                const auto expected = dense.lookup(nonterminal, terminal);
+                EXPECT_EQ(displaced.lookup(nonterminal, terminal), expected) << file;
+                // an empty cell may hand out the default of its row instead
+                const auto actual = default_rows.lookup(nonterminal, terminal);
+                if (expected == LLTable::no_production)
+                    EXPECT_TRUE(actual == expected || actual == default_rows.get_defaults()[row]);
+                else
+                    EXPECT_EQ(actual, expected) << file;
+            }
+            EXPECT_EQ(displaced.lookup(nonterminal, SymbolTable::invalid_id),
+                      LLTable::no_production);
+        }
+    }
+}
+
+TEST(TableGeneration, EmittedParserKeepsCompressedTable)
+{
+    Driver driver;
+    driver.parse(std::string{EXAMPLE_GRAMMAR_DIR}.append("exp.bnf"));
+    auto set_generator = FirstFollowSetGenerator(driver.grammar);
+    auto table = generate_dense_ll_table(set_generator, LLTable::Encoding::DefaultRows);
+
+    auto emitted = emit_ll_parser(table, "exp-parser");
+
+    EXPECT_NE(emitted.header.find("extern const std::uint32_t displacements[];"),
+              std::string::npos);
+    EXPECT_NE(emitted.source.find("const std::uint16_t checks[] = {"), std::string::npos);
+    EXPECT_EQ(emitted.source.find("table[]"), std::string::npos);
+}
+
+TEST(TableGeneration, PerfectHashGivesEveryKeyItsOwnSlot)
+{
+    std::vector<std::string> names;
+    for (int i = 0; i < 1000; i++)
+        names.push_back(fmt::format("token{}", i));
+    const std::vector<std::string_view> keys(names.begin(), names.end());
+    const PerfectHash hash(keys);
+
+    std::vector<bool> taken(keys.size());
+    for (auto key : keys) {
+        const auto slot = hash.slot(key);
+        ASSERT_LT(slot, keys.size());
+        EXPECT_FALSE(taken[slot]) << key;
+        taken[slot] = true;
+    }
+    const std::vector<std::string_view> repeated{"a", "b", "a"};
+    EXPECT_THROW(PerfectHash{repeated}, std::invalid_argument);
+    EXPECT_EQ(PerfectHash{}.slot("a"), PerfectHash::no_slot);
+}
+
+TEST(TableGeneration, FindTerminalMatchesSymbolTable)
+{
+    for (const auto *file : {"exp.bnf", "energy.bnf", "test.bnf"}) {
+        Driver driver;
+        driver.parse(std::string{EXAMPLE_GRAMMAR_DIR}.append(file));
+        auto set_generator = FirstFollowSetGenerator(driver.grammar);
+        const auto table = generate_dense_ll_table(set_generator);
+        const auto &symbols = table.get_symbol_table();
+
+        for (auto terminal : symbols.get_terminals()) {
+            if (terminal == SymbolTable::eoi_id)
+                continue;
+            EXPECT_EQ(table.find_terminal(*symbols.get_symbol(terminal).get_raw_symbol()),
+                      terminal)
+                << file;
+        }
+        for (auto nonterminal : symbols.get_nonterminals()) {
+            EXPECT_EQ(table.find_terminal(*symbols.get_symbol(nonterminal).get_raw_symbol()),
+                      SymbolTable::invalid_id)
+                << file;
+        }
+        EXPECT_EQ(table.find_terminal("not a terminal"), SymbolTable::invalid_id) << file;
+        EXPECT_EQ(table.find_terminal(""), SymbolTable::invalid_id) << file;
+    }
+}
+
+TEST(TableGeneration, IncrementalUpdatesMatchAFreshBuild)
+{
+    std::mt19937 random(11);
+    auto random_rule = [&](const std::string &LHS) {
+        std::vector<Production> productions;
+        for (auto n = 1 + random() % 3; n > 0; n--) {
+            std::vector<ProductionSymbol> RHS;
+            for (auto length = random() % 4; length > 0; length--) {
+                // the later nonterminals only show up once a rule adds them
+                if (random() % 2)
+                    RHS.emplace_back(fmt::format("N{}", random() % 8),
+                                     ProductionSymbol::Kind::NonTerminal);
+                else
+                    RHS.emplace_back(std::string(1, static_cast<char>('a' + random() % 6)),
+                                     ProductionSymbol::Kind::Terminal);
+            }
+            if (RHS.empty())
+                RHS.push_back(ProductionSymbol::create_epsilon());
+            productions.emplace_back(std::move(RHS));
+        }
+        return GrammarRule{ProductionSymbol{LHS, ProductionSymbol::Kind::NonTerminal},
+                           std::move(productions)};
+    };
+    std::vector<GrammarRule> rules;
+    for (int n = 0; n < 5; n++)
+        rules.push_back(random_rule(fmt::format("N{}", n)));
+    auto set_generator = FirstFollowSetGenerator(Grammar{rules});
+    auto table = generate_dense_ll_table(set_generator);
+
+    for (int edit = 0; edit < 300; edit++) {
+        const auto LHS = fmt::format("N{}", random() % 8);
+        if (random() % 4 == 0 && LHS != "N0")
+            patch_ll_table(table, set_generator,
+                           set_generator.remove_rule(
+                               ProductionSymbol{LHS, ProductionSymbol::Kind::NonTerminal}));
+        else
+            patch_ll_table(table, set_generator, set_generator.replace_rule(random_rule(LHS)));
+
+        auto fresh_generator = FirstFollowSetGenerator(Grammar{set_generator.grammar.get_rules()});
+        const auto fresh = generate_dense_ll_table(fresh_generator);
+        const auto context = fmt::format("after edit {}: {}", edit, set_generator.grammar);
+        ASSERT_EQ(set_generator.generate_first_sets(), fresh_generator.generate_first_sets())
+            << context;
+        ASSERT_EQ(set_generator.generate_follow_sets(), fresh_generator.generate_follow_sets())
+            << context;
+
+        const auto &symbols = table.get_symbol_table();
+        const auto &fresh_symbols = fresh.get_symbol_table();
+        auto filled = [](const LLTable &table) {
+            return std::count_if(table.get_cells().begin(), table.get_cells().end(),
+                                 [](auto cell) { return cell != LLTable::no_production; });
+        };
+        ASSERT_EQ(filled(table), filled(fresh)) << context;
+        for (auto nonterminal : fresh_symbols.get_nonterminals()) {
+            for (auto terminal : fresh_symbols.get_terminals()) {
+                const auto expected = fresh.lookup(nonterminal, terminal);
+                const auto actual =
+                    table.lookup(symbols.find(fresh_symbols.get_symbol(nonterminal)),
+                                 symbols.find(fresh_symbols.get_symbol(terminal)));
+                ASSERT_EQ(actual == LLTable::no_production, expected == LLTable::no_production)
+                    << context;
+                if (actual != LLTable::no_production) {
+                    ASSERT_EQ(table.to_production(actual), fresh.to_production(expected))
+                        << context;
+                }
+            }
+        }
+        auto described = [](const LLTable &table) {
+            std::vector<std::string> conflicts;
+            for (const auto &conflict : table.conflicts)
+                conflicts.push_back(table.describe(conflict));
+            std::sort(conflicts.begin(), conflicts.end());
+            return conflicts;
+        };
+        ASSERT_EQ(described(table), described(fresh)) << context;
+    }
+}